@@ -17,9 +17,25 @@ in vec2 a_texCoord;
 out vec2 o_texCoord;
 
 uniform mat4 projectionMatrix;
-uniform mat4 modelViewMatrix;
+uniform mat4 viewMatrix;
+
+// two texels per particle, written by ParticleRenderer:
+// position and rotation in degrees, then scale and remaining life
+uniform samplerBuffer u_particleData;
 
 void main() {
-    gl_Position = projectionMatrix * modelViewMatrix * vec4(a_pos, 1.0);
+    vec4 positionRotation = texelFetch(u_particleData, gl_InstanceID * 2);
+    vec4 scaleLife = texelFetch(u_particleData, gl_InstanceID * 2 + 1);
+
+    float angle = radians(positionRotation.w);
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 corner = mat2(c, s, -s, c) * a_pos.xy * scaleLife.x;
+
+    // the corner is added in view space so the quad always faces the camera
+    vec4 viewPos = viewMatrix * vec4(positionRotation.xyz, 1.0);
+    viewPos.xy += corner;
+
+    gl_Position = projectionMatrix * viewPos;
     o_texCoord = a_texCoord;
 }
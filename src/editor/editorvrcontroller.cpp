@@ -203,21 +203,9 @@ void EditorVrController::update(float dt)
 
 bool EditorVrController::rayCastToScene(QMatrix4x4 handMatrix, iris::PickingResult& result)
 {
-    QList<iris::PickingResult> hits;
-
-    scene->rayCast(handMatrix * QVector3D(0,0,0),
-                   handMatrix * QVector3D(0,0,-100),
-                   hits);
-
-    if(hits.size() == 0)
-        return false;
-
-    qSort(hits.begin(), hits.end(), [](const iris::PickingResult& a, const iris::PickingResult& b){
-        return a.distanceFromStartSqrd < b.distanceFromStartSqrd;
-    });
-
-    result = hits.first();
-    return true;
+    return scene->rayCastClosest(handMatrix * QVector3D(0,0,0),
+                                 handMatrix * QVector3D(0,0,-100),
+                                 result);
 }
 
 
@@ -30,6 +30,7 @@ For more information see the LICENSE file
 #include "../irisgl/src/core/scene.h"
 #include "../irisgl/src/core/scenenode.h"
 #include "../irisgl/src/core/irisutils.h"
+#include "../irisgl/src/core/meshmanager.h"
 #include "../irisgl/src/scenegraph/meshnode.h"
 #include "../irisgl/src/scenegraph/cameranode.h"
 #include "../irisgl/src/scenegraph/viewernode.h"
@@ -73,6 +74,9 @@ iris::ScenePtr SceneReader::readScene(QString filePath,
 
     readPostProcessData(projectObj, postMan);
 
+    // frees meshes from files no node references anymore, e.g. from a previously opened scene
+    iris::MeshManager::purgeUnused();
+
     return scene;
 }
 
@@ -262,7 +266,7 @@ void SceneReader::readAnimationData(QJsonObject& nodeObj,iris::SceneNodePtr scen
             float value = keyObj["value"].toDouble(0);
             frame->addKey(value,time);
         }
-        animation->keyFrameSet->keyFrames.insert(frame->name,frame);
+        animation->keyFrameSet->insertKeyFrame(frame->name,frame);
         animation->length = animObj["length"].toDouble(1);
         animation->loop = animObj["loop"].toBool(false);
     }
@@ -316,11 +320,10 @@ iris::MeshNodePtr SceneReader::createMesh(QJsonObject& nodeObj)
     auto pickable = nodeObj["pickable"].toBool(true);
 
     if (!source.isEmpty()) {
-        auto mesh = getMesh(getAbsolutePath(source), meshIndex);
         if (source.startsWith(":")) {
             meshNode->setMesh(source);
         } else {
-            meshNode->setMesh(mesh);
+            meshNode->setMesh(getMesh(getAbsolutePath(source), meshIndex));
         }
         meshNode->setPickable(pickable);
         meshNode->meshPath = source;
@@ -464,19 +467,7 @@ iris::MaterialPtr SceneReader::readMaterial(QJsonObject& nodeObj)
  */
 iris::Mesh* SceneReader::getMesh(QString filePath, int index)
 {
-    // if the mesh is already in the hashmap then it was already loaded, just return the indexed mesh
-    if (meshes.contains(filePath)) {
-        auto meshList = meshes[filePath];
-        if (index < meshList.size()) return meshList[index];
-        // maybe the mesh was modified after the file was saved
-        return nullptr;
-    }
-
-    else {
-        auto meshList = iris::GraphicsHelper::loadAllMeshesFromFile(filePath);
-        meshes.insert(filePath,meshList);
-        if (index < meshList.size()) return meshList[index];
-        // maybe the mesh was modified after the file was saved
-        return nullptr;
-    }
+    // meshes are shared with every other node and scene that uses the same file
+    // and are read from the cooked mesh file when it matches the model
+    return iris::MeshManager::getMesh(filePath, index);
 }
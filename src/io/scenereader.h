@@ -30,8 +30,6 @@ class EditorData;
 
 class SceneReader : public AssetIOBase
 {
-    QHash<QString,QList<iris::Mesh*>> meshes;
-
 public:
     iris::ScenePtr readScene(QString filePath,
                              iris::PostProcessManagerPtr postMan,
@@ -187,11 +187,11 @@ void SceneWriter::writeAnimationData(QJsonObject& sceneNodeObj,iris::SceneNodePt
 
         QJsonObject frameObj;
         QJsonArray keys;
-        for(auto key:frame->keys)
+        for(const auto& key:frame->keys)
         {
             QJsonObject keyObj;
-            keyObj["time"] = key->time;
-            keyObj["value"] = key->value;
+            keyObj["time"] = key.time;
+            keyObj["value"] = key.value;
 
             keys.append(keyObj);
         }
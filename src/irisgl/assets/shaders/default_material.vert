@@ -11,19 +11,17 @@ For more information see the LICENSE file
 
 #version 150
 
+#pragma include <uniform_blocks.glsl>
+#pragma include <instancing.glsl>
+
 in vec3 a_pos;
 in vec2 a_texCoord;
 in vec3 a_normal;
 in vec3 a_tangent;
 
 uniform mat4 matrix;
-uniform mat4 u_viewMatrix;
-uniform mat4 u_projMatrix;
-uniform mat4 u_worldMatrix;
-uniform mat3 u_normalMatrix;
 uniform float u_textureScale;
 
-uniform mat4 u_lightSpaceMatrix;
 out vec4 FragPosLightSpace;
 
 out vec2 v_texCoord;
@@ -33,15 +31,18 @@ out mat3 v_tanToWorld;//transforms from tangent space to world space
 
 void main()
 {
-    v_worldPos = (u_worldMatrix*vec4(a_pos,1.0)).xyz;
+    mat4 worldMatrix = getWorldMatrix();
+    mat3 normalMatrix = getNormalMatrix();
+
+    v_worldPos = (worldMatrix*vec4(a_pos,1.0)).xyz;
     //gl_Position = matrix*vec4(a_pos,1.0);
-    gl_Position = u_projMatrix*u_viewMatrix*u_worldMatrix*vec4(a_pos,1.0);
+    gl_Position = getClipPosition(vec4(v_worldPos,1.0));
 
     v_texCoord = a_texCoord*u_textureScale;
     //v_texCoord = a_texCoord*2;
 
-    v_normal = normalize((u_normalMatrix*a_normal));
-    vec3 v_tangent = normalize((u_normalMatrix*a_tangent));
+    v_normal = normalize((normalMatrix*a_normal));
+    vec3 v_tangent = normalize((normalMatrix*a_tangent));
     //vec3 v_bitangent = cross(v_normal,v_tangent);
     vec3 v_bitangent = cross(v_tangent,v_normal);
 
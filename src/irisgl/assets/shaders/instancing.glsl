@@ -0,0 +1,72 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Transforms of the drawn object, from plain uniforms or from the instance buffer.
+// Each instance takes seven texels of u_instanceData: the columns of its world
+// matrix followed by the columns of its normal matrix.
+// The layout must match InstanceBuffer in instancebuffer.h
+//
+// In single pass stereo every instance is drawn twice, even instances for the left eye
+// and odd ones for the right eye, each to its half of a side by side target.
+// Needs uniform_blocks.glsl.
+
+uniform mat4 u_worldMatrix;
+uniform mat3 u_normalMatrix;
+
+uniform bool u_instanced;
+uniform int u_instanceOffset;
+uniform samplerBuffer u_instanceData;
+
+uniform bool u_stereo;
+
+int getInstanceIndex()
+{
+    return u_stereo ? gl_InstanceID / 2 : gl_InstanceID;
+}
+
+// returns the clip space position of worldPos in the eye being drawn
+vec4 getClipPosition(vec4 worldPos)
+{
+    if (!u_stereo)
+        return u_projMatrix * u_viewMatrix * worldPos;
+
+    int eye = gl_InstanceID % 2;
+    vec4 clipPos = u_eyeProjMatrices[eye] * u_eyeViewMatrices[eye] * worldPos;
+
+    // the eye's view is squeezed into its half of the target and clipped at the middle
+    gl_ClipDistance[0] = eye == 0 ? clipPos.w - clipPos.x : clipPos.w + clipPos.x;
+    clipPos.x = clipPos.x * 0.5 + (eye == 0 ? -0.5 : 0.5) * clipPos.w;
+
+    return clipPos;
+}
+
+mat4 getWorldMatrix()
+{
+    if (!u_instanced)
+        return u_worldMatrix;
+
+    int base = (u_instanceOffset + getInstanceIndex()) * 7;
+    return mat4(texelFetch(u_instanceData, base),
+                texelFetch(u_instanceData, base + 1),
+                texelFetch(u_instanceData, base + 2),
+                texelFetch(u_instanceData, base + 3));
+}
+
+mat3 getNormalMatrix()
+{
+    if (!u_instanced)
+        return u_normalMatrix;
+
+    int base = (u_instanceOffset + getInstanceIndex()) * 7 + 4;
+    return mat3(texelFetch(u_instanceData, base).xyz,
+                texelFetch(u_instanceData, base + 1).xyz,
+                texelFetch(u_instanceData, base + 2).xyz);
+}
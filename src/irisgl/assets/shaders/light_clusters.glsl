@@ -0,0 +1,131 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Point and spot lights binned into view space clusters, needs uniform_blocks.glsl.
+// u_clusterLights has four texels per light and u_clusterData has an offset and
+// count per cluster followed by the clusters' light lists.
+// The layout must match LightClusters in lightclusters.h
+
+const int CLUSTER_GRID_WIDTH = 16;
+const int CLUSTER_GRID_HEIGHT = 9;
+const int CLUSTER_GRID_DEPTH = 24;
+
+uniform samplerBuffer u_clusterLights;
+uniform usamplerBuffer u_clusterData;
+
+// returns the offset and count of the light list of the cluster worldPos is in
+uvec2 getLightCluster(vec3 worldPos)
+{
+    vec4 viewPos = u_sharedViewMatrix * vec4(worldPos, 1.0);
+    vec4 clipPos = u_sharedProjMatrix * viewPos;
+    vec2 screenPos = clipPos.xy / clipPos.w * 0.5 + 0.5;
+
+    int x = clamp(int(screenPos.x * CLUSTER_GRID_WIDTH), 0, CLUSTER_GRID_WIDTH - 1);
+    int y = clamp(int(screenPos.y * CLUSTER_GRID_HEIGHT), 0, CLUSTER_GRID_HEIGHT - 1);
+    int z = clamp(int(log(max(-viewPos.z, 0.0001)) * u_clusterDepthScale + u_clusterDepthBias),
+                  0, CLUSTER_GRID_DEPTH - 1);
+
+    int cluster = (z * CLUSTER_GRID_HEIGHT + y) * CLUSTER_GRID_WIDTH + x;
+    return uvec2(texelFetch(u_clusterData, cluster * 2).r,
+                 texelFetch(u_clusterData, cluster * 2 + 1).r);
+}
+
+// returns the index-th light of a cluster returned by getLightCluster
+Light getClusterLight(uvec2 cluster, int index)
+{
+    int base = int(texelFetch(u_clusterData, int(cluster.x) + index).r) * 4;
+
+    vec4 positionType = texelFetch(u_clusterLights, base + 1);
+    vec4 directionDistance = texelFetch(u_clusterLights, base + 2);
+    vec4 spot = texelFetch(u_clusterLights, base + 3);
+
+    Light light;
+    light.color = texelFetch(u_clusterLights, base);
+    light.position = positionType.xyz;
+    light.type = int(positionType.w);
+    light.direction = directionDistance.xyz;
+    light.distance = directionDistance.w;
+    light.intensity = spot.x;
+    light.cutOffAngle = spot.y;
+    light.cutOffSoftness = spot.z;
+
+    return light;
+}
+
+// adds a light's diffuse and specular intensity at worldPos
+// n is the normalized surface normal and v the normalized direction to the eye
+void addLight(Light light, vec3 worldPos, vec3 n, vec3 v, float shininess,
+              inout vec3 diffuse, inout vec3 specular)
+{
+    float ndl = 0.0;
+    vec3 lightDir = light.position-worldPos;//unnormalized
+    vec3 l = normalize(lightDir);
+    float atten = 1.0;
+    float spotCutoff = 1.0;
+
+    if(light.type!=TYPE_DIRECTIONAL)//point and spot
+    {
+        ndl = max(dot(n,l),0.0);
+
+        if(ndl>0)
+        {
+            float lightDist = length(lightDir);
+
+            //atten = 1.0-smoothstep(0.0,light.distance,lightDist);
+            atten = clamp((lightDist-light.distance)/(-light.distance),0.0,1.0);
+            atten = atten*atten;
+
+            //attenuation
+            //https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
+            //http://brabl.com/light-attenuation/
+            //http://gamedev.stackexchange.com/questions/56897/glsl-light-attenuation-color-and-intensity-formula
+        }
+
+        if(light.type==TYPE_SPOT)
+        {
+            float cos_angle = degrees(acos(dot(-l, light.direction)));
+            spotCutoff = clamp((cos_angle-light.cutOffAngle)/
+                               (-light.cutOffSoftness)
+                              ,
+                              0.0,1.0);
+            ndl = ndl*spotCutoff;
+        }
+    }
+    else
+    {
+        //directional
+        l = normalize(-light.direction);
+        ndl = max(dot(l, n),0.0);
+    }
+
+    float spec = 0.0;
+
+    if (ndl > 0.0 && shininess > 0.0) {
+        float normFactor = (shininess + 2.0) / 2.0;//todo: find a better alternative
+        vec3 r = reflect(-l, n);
+        spec = normFactor*pow(max(dot(r, v), 0.0), shininess)*spotCutoff;
+    }
+
+    diffuse += atten*ndl*light.intensity*light.color.rgb;
+    specular += atten*spec*light.intensity*light.color.rgb;
+}
+
+// adds the directional lights and the lights of worldPos's cluster
+void addLights(vec3 worldPos, vec3 n, vec3 v, float shininess,
+               inout vec3 diffuse, inout vec3 specular)
+{
+    for (int i = 0; i < u_lightCount; i++)
+        addLight(u_lights[i], worldPos, n, v, shininess, diffuse, specular);
+
+    uvec2 cluster = getLightCluster(worldPos);
+    for (int i = 0; i < int(cluster.y); i++)
+        addLight(getClusterLight(cluster, i), worldPos, n, v, shininess, diffuse, specular);
+}
@@ -13,6 +13,9 @@ For more information see the LICENSE file
 
 #version 150
 
+#pragma include <uniform_blocks.glsl>
+#pragma include <light_clusters.glsl>
+
 #define PI 3.14159265359
 #define PI2 6.28318530718
 #define RECIPROCAL_PI2 0.15915494
@@ -22,11 +25,6 @@ in vec3 v_normal;
 in vec3 v_worldPos;
 in mat3 v_tanToWorld;
 
-const int MAX_LIGHTS = 8;
-const int TYPE_POINT = 0;
-const int TYPE_DIRECTIONAL = 1;
-const int TYPE_SPOT = 2;
-
 in vec4 FragPosLightSpace;
 uniform sampler2D u_shadowMap;
 uniform bool u_shadowEnabled;
@@ -67,28 +65,22 @@ float SampleShadowMapPCF(sampler2D shadowMap, vec2 coords, float compare, vec2 t
     return result / (NUM_SAMPLES * NUM_SAMPLES);
 }
 
-float CalcShadowMap(vec4 fragPosLightSpace) {
+float CalcShadowMap(vec3 worldPos) {
+    int cascade = getShadowCascade(worldPos);
+    if (cascade < 0)
+        return 1.0;
+
+    vec4 fragPosLightSpace = u_shadowMatrices[cascade] * vec4(worldPos, 1.0);
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
     vec2 texelSize = 1.0 / textureSize(u_shadowMap, 0);
-    return SampleShadowMapPCF(u_shadowMap, projCoords.xy, projCoords.z, texelSize);
-}
 
-struct Light {
-    int type;
-    vec3 position;
-    vec3 ambient;
-    vec4 color;
-    float distance;
-    float intensity;
-    vec3 direction;
-    float cutOffAngle;
-    float cutOffSoftness;
-};
-uniform Light u_lights[MAX_LIGHTS];
-uniform int u_lightCount;
+    // the pcf kernel reaches 4 texels out, it shouldnt sample the neighbouring cascades
+    vec4 tile = u_shadowTiles[cascade];
+    projCoords.xy = clamp(projCoords.xy, tile.xy + texelSize * 4.0, tile.zw - texelSize * 4.0);
 
-uniform vec3 u_eyePos;
+    return SampleShadowMapPCF(u_shadowMap, projCoords.xy, projCoords.z, texelSize);
+}
 
 struct Material
 {
@@ -101,15 +93,7 @@ struct Material
     float alpha;
 };
 
-struct Fog
-{
-    bool enabled;
-    float start;
-    float end;
-    vec4 color;
-};
-
-uniform Fog u_fogData;
+uniform bool u_fogEnabled;
 
 out vec4 fragColor;
 
@@ -157,79 +141,23 @@ void main()
     vec3 normal = material.normal;
 
     vec3 v = normalize(u_eyePos-v_worldPos);
-    float spotCutoff = 1.0;
-
-    for(int i=0;i<u_lightCount;i++)
-    {
-        float ndl = 0.0;
-        vec3 n = normalize(normal);
-        vec3 lightDir = u_lights[i].position-v_worldPos;//unnormalized
-        vec3 l = normalize(lightDir);
-        float atten = 1.0;
-
-        if(u_lights[i].type!=TYPE_DIRECTIONAL)//point and spot
-        {
-            ndl = max(dot(n,l),0.0);
-
-            if(ndl>0)
-            {
-                float lightDist = length(lightDir);
-
-                //atten = 1.0-smoothstep(0.0,u_lights[i].distance,lightDist);
-                atten = clamp((lightDist-u_lights[i].distance)/(-u_lights[i].distance),0.0,1.0);
-                atten = atten*atten;
-
-                //attenuation
-                //https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
-                //http://brabl.com/light-attenuation/
-                //http://gamedev.stackexchange.com/questions/56897/glsl-light-attenuation-color-and-intensity-formula
-
-            }
-
-            if(u_lights[i].type==TYPE_SPOT)
-            {
-                float cos_angle = degrees(acos(dot(-l, u_lights[i].direction)));
-                spotCutoff = clamp((cos_angle-u_lights[i].cutOffAngle)/
-                                   (-u_lights[i].cutOffSoftness)
-                                  ,
-                                  0.0,1.0);
-                ndl = ndl*spotCutoff;
-            }
 
-
-        }
-        else
-        {
-            //directional
-            l = normalize(-u_lights[i].direction);
-            ndl = max(dot(l, n),0.0);
-        }
-
-        float spec = 0.0;
-
-        if (ndl > 0.0 && material.shininess > 0.0) {
-            float normFactor = (material.shininess + 2.0) / 2.0;//todo: find a better alternative
-            vec3 r = reflect(-l, n);
-            spec = normFactor*pow(max(dot(r, v), 0.0), material.shininess)*spotCutoff;
-        }
-
-        diffuse += atten*ndl*u_lights[i].intensity*u_lights[i].color.rgb;
-        specular += atten*spec* u_lights[i].intensity * u_lights[i].color.rgb;
-    }
+    // directional lights then the point and spot lights near the fragment
+    addLights(v_worldPos, normalize(normal), v, material.shininess, diffuse, specular);
 
     vec3 col = material.diffuse;
 
-    float ShadowFactor = u_shadowEnabled ? CalcShadowMap(FragPosLightSpace) : 1.0;
+    float ShadowFactor = u_shadowEnabled ? CalcShadowMap(v_worldPos) : 1.0;
 
     vec3 finalColor = (material.ambient + material.emission + (ShadowFactor *
                       (diffuse * col + (material.specular * specular))));
 
 
-    if(u_fogData.enabled)
+    if(u_fogEnabled)
     {
         float zDist = length(v_worldPos-u_eyePos);
-        float fogFactor = clamp((zDist-u_fogData.start)/(u_fogData.end-u_fogData.start),0,1);
-        finalColor = mix(finalColor,u_fogData.color.rgb,fogFactor);
+        float fogFactor = clamp((zDist-u_fogStart)/(u_fogEnd-u_fogStart),0,1);
+        finalColor = mix(finalColor,u_fogColor.rgb,fogFactor);
     }
 
     fragColor = vec4(finalColor, material.alpha);
@@ -0,0 +1,86 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Per-frame data shared by every program.
+// The layout must match FrameDataBlock and LightDataBlock in uniformblocks.h
+// u_lights only holds the directional lights, point and spot lights are in the
+// light clusters (see light_clusters.glsl)
+
+const int MAX_LIGHTS = 8;
+const int MAX_SHADOW_CASCADES = 4;
+
+layout(std140) uniform FrameData
+{
+    mat4 u_viewMatrix;
+    mat4 u_projMatrix;
+    // the last cascade's matrix, for shaders that dont use the cascades
+    mat4 u_lightSpaceMatrix;
+
+    vec3 u_eyePos;
+    float u_fogStart;
+    vec4 u_fogColor;
+    float u_fogEnd;
+
+    // world to shadow atlas matrices of the cascades and their tiles in the atlas
+    mat4 u_shadowMatrices[MAX_SHADOW_CASCADES];
+    vec4 u_shadowTiles[MAX_SHADOW_CASCADES];
+    // view space distance at which each cascade ends
+    vec4 u_shadowSplits;
+    int u_shadowCascadeCount;
+
+    // a fragment's cluster slice is log(depth) * u_clusterDepthScale + u_clusterDepthBias
+    float u_clusterDepthScale;
+    float u_clusterDepthBias;
+
+    // the matrices of each eye in single pass stereo (see instancing.glsl)
+    // u_viewMatrix and u_projMatrix then cover both eyes in programs that use them
+    mat4 u_eyeViewMatrices[2];
+    mat4 u_eyeProjMatrices[2];
+
+    // the view the light clusters were binned for and the cascades were split along
+    // programs without u_stereo are drawn once per eye with that eye's u_viewMatrix and
+    // u_projMatrix, these stay the view of both eyes
+    mat4 u_sharedViewMatrix;
+    mat4 u_sharedProjMatrix;
+};
+
+// returns the closest cascade that covers worldPos, -1 if it's past the last one
+int getShadowCascade(vec3 worldPos)
+{
+    float depth = -(u_sharedViewMatrix * vec4(worldPos, 1.0)).z;
+    for (int i = 0; i < u_shadowCascadeCount; i++) {
+        if (depth < u_shadowSplits[i])
+            return i;
+    }
+
+    return -1;
+}
+
+const int TYPE_POINT = 0;
+const int TYPE_DIRECTIONAL = 1;
+const int TYPE_SPOT = 2;
+
+struct Light {
+    vec4 color;
+    vec3 position;
+    int type;
+    vec3 direction;
+    float distance;
+    float intensity;
+    float cutOffAngle;
+    float cutOffSoftness;
+};
+
+layout(std140) uniform LightData
+{
+    Light u_lights[MAX_LIGHTS];
+    int u_lightCount;
+};
@@ -0,0 +1,354 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QtMath>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+#include "benchmark.h"
+#include "../src/core/scene.h"
+#include "../src/core/scenenode.h"
+#include "../src/animation/animation.h"
+#include "../src/animation/keyframeset.h"
+#include "../src/animation/keyframeanimation.h"
+#include "../src/math/fastrandom.h"
+
+using namespace iris;
+
+namespace
+{
+
+const char* animatedChannels[] = {
+    "Translation X", "Translation Y", "Translation Z",
+    "Rotation Y",
+    "Scale X", "Scale Y", "Scale Z"
+};
+const int animatedChannelCount = sizeof(animatedChannels) / sizeof(animatedChannels[0]);
+
+// nodes directly under the root, each with keyCount random keys on every animated channel
+QVector<SceneNodePtr> createAnimatedNodes(ScenePtr scene, int nodeCount, int keyCount, float length)
+{
+    FastRandom random(13);
+    QVector<SceneNodePtr> nodes;
+    for (int i = 0; i < nodeCount; i++) {
+        auto node = SceneNode::create();
+        auto keyFrameSet = node->animation->keyFrameSet;
+        for (auto name : animatedChannels) {
+            auto keyFrame = keyFrameSet->getOrCreateFrame(name);
+            for (int k = 0; k < keyCount; k++)
+                keyFrame->addKey(random.nextFloat() * 10, length * k / (keyCount - 1));
+        }
+
+        scene->getRootNode()->addChild(node, false);
+        nodes.append(node);
+    }
+
+    return nodes;
+}
+
+// how SceneNode::updateAnimation evaluated a node before its keyframes were compiled into bindings
+void applyByName(SceneNode* node, float time)
+{
+    auto keyFrameSet = node->animation->keyFrameSet;
+
+    if(keyFrameSet->hasKeyFrame("Translation X"))
+        node->pos.setX(keyFrameSet->getKeyFrame("Translation X")->getValueAt(time));
+    if(keyFrameSet->hasKeyFrame("Translation Y"))
+        node->pos.setY(keyFrameSet->getKeyFrame("Translation Y")->getValueAt(time));
+    if(keyFrameSet->hasKeyFrame("Translation Z"))
+        node->pos.setZ(keyFrameSet->getKeyFrame("Translation Z")->getValueAt(time));
+
+    if (keyFrameSet->hasKeyFrame("Rotation X") ||
+        keyFrameSet->hasKeyFrame("Rotation Y") ||
+        keyFrameSet->hasKeyFrame("Rotation Z")) {
+        auto rotEuler = node->rot.toEulerAngles();
+        if(keyFrameSet->hasKeyFrame("Rotation X"))
+            rotEuler.setX(keyFrameSet->getKeyFrame("Rotation X")->getValueAt(time));
+        if(keyFrameSet->hasKeyFrame("Rotation Y"))
+            rotEuler.setY(keyFrameSet->getKeyFrame("Rotation Y")->getValueAt(time));
+        if(keyFrameSet->hasKeyFrame("Rotation Z"))
+            rotEuler.setZ(keyFrameSet->getKeyFrame("Rotation Z")->getValueAt(time));
+        node->rot = QQuaternion::fromEulerAngles(rotEuler);
+    }
+
+    if(keyFrameSet->hasKeyFrame("Scale X"))
+        node->scale.setX(keyFrameSet->getKeyFrame("Scale X")->getValueAt(time));
+    if(keyFrameSet->hasKeyFrame("Scale Y"))
+        node->scale.setY(keyFrameSet->getKeyFrame("Scale Y")->getValueAt(time));
+    if(keyFrameSet->hasKeyFrame("Scale Z"))
+        node->scale.setZ(keyFrameSet->getKeyFrame("Scale Z")->getValueAt(time));
+}
+
+bool sameVector(const QVector4D& a, const QVector4D& b)
+{
+    return (a - b).length() <= 1e-4f * qMax(1.0f, b.length());
+}
+
+// the node's transform inputs, rotation as a quaternion so euler ambiguities dont matter
+QVector<QVector4D> getNodeState(const SceneNodePtr& node)
+{
+    return {QVector4D(node->pos, 0), node->rot.toVector4D(), QVector4D(node->scale, 0)};
+}
+
+// how KeyFrame::getValueAt found its keys before they were searched, walking them from the start
+float linearValueAt(const FloatKeyFrame& keyFrame, float time)
+{
+    const auto& keys = keyFrame.keys;
+    int numKeys = keys.size();
+    if (time <= keys[0].time)
+        return keys[0].value;
+    if (time >= keys[numKeys - 1].time)
+        return keys[numKeys - 1].value;
+
+    for (int i = 0; i < numKeys - 1; i++) {
+        if (keys[i].time <= time && time < keys[i + 1].time) {
+            float t = (time - keys[i].time) / (keys[i + 1].time - keys[i].time);
+            return keys[i].value + (keys[i + 1].value - keys[i].value) * t;
+        }
+    }
+
+    return keys[numKeys - 1].value;
+}
+
+}
+
+IRIS_BENCHMARK(animationBinding, "animation-binding", "Animating thousands of nodes through compiled channel bindings against looking keyframes up by name", true)
+{
+    int nodeCount = run.quick ? 1000 : 5000;
+    const int keyCount = 16;
+    const float length = 10;
+    const float delta = 1.0f / 60;
+
+    auto scene = Scene::create();
+    auto nodes = createAnimatedNodes(scene, nodeCount, keyCount, length);
+
+    // both ways of evaluating have to leave every node in the same state
+    int mismatches = 0;
+    for (float time : {0.0f, 0.5f, 3.3f, 7.25f, 12.0f}) {
+        scene->updateSceneAnimation(time);
+
+        QVector<QVector<QVector4D>> bound;
+        for (auto& node : nodes)
+            bound.append(getNodeState(node));
+
+        for (int i = 0; i < nodes.size(); i++) {
+            applyByName(nodes[i].data(), time);
+            auto byName = getNodeState(nodes[i]);
+            for (int v = 0; v < byName.size(); v++) {
+                // q and -q are the same rotation
+                if (!sameVector(bound[i][v], byName[v]) && !sameVector(-bound[i][v], byName[v])) {
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+    }
+    run.check(mismatches == 0, QString("%1 nodes were animated differently by their bindings").arg(mismatches));
+
+    // a replaced set has the same channels, so only the set itself tells the binding it's stale.
+    // the old set is freed first so the new one can land at the same address
+    const int replacedCount = 100;
+    for (int i = 0; i < replacedCount; i++) {
+        auto animation = nodes[i]->animation;
+        animation->keyFrameSet.clear();
+        animation->keyFrameSet = KeyFrameSet::create();
+        for (auto name : animatedChannels)
+            animation->keyFrameSet->getOrCreateFrame(name)->addKey(i, 0);
+    }
+    scene->updateSceneAnimation(1.0f);
+
+    // and a keyframe replaced within a set that's already bound
+    for (int i = 0; i < replacedCount; i++) {
+        auto keyFrame = new FloatKeyFrame();
+        keyFrame->addKey(i + 1, 0);
+        nodes[i]->animation->keyFrameSet->insertKeyFrame("Scale X", keyFrame);
+    }
+    scene->updateSceneAnimation(1.0f);
+
+    int staleNodes = 0;
+    for (int i = 0; i < replacedCount; i++) {
+        if (nodes[i]->pos != QVector3D(i, i, i) || nodes[i]->scale != QVector3D(i + 1, i, i))
+            staleNodes++;
+    }
+    run.check(staleNodes == 0, QString("%1 nodes played keyframes that were replaced").arg(staleNodes));
+
+    // playback steps forward a frame at a time and loops
+    float time = 0;
+    auto nextTime = [&]() {
+        time += delta;
+        if (time > length)
+            time = 0;
+        return time;
+    };
+
+    double byNameMs = run.time(10, [&]() {
+        float t = nextTime();
+        for (auto& node : nodes)
+            applyByName(node.data(), t);
+    });
+    double bindingMs = run.time(10, [&]() {
+        scene->updateSceneAnimation(nextTime());
+    });
+
+    run.row({"nodes, channels, keys", QString("%1, %2, %3").arg(nodeCount).arg(animatedChannelCount).arg(keyCount)});
+    run.row({"per frame", "time", "per node", "speedup"});
+    run.row({"by name, as before", formatMs(byNameMs), QString::number(byNameMs * 1000000 / nodeCount, 'f', 0) + " ns", "1.0x"});
+    run.row({"bindings", formatMs(bindingMs), QString::number(bindingMs * 1000000 / nodeCount, 'f', 0) + " ns",
+             QString::number(byNameMs / bindingMs, 'f', 1) + "x"});
+}
+
+IRIS_BENCHMARK(keyFrameLookup, "keyframe-lookup", "Evaluating a 10k key curve during playback and at random times", false)
+{
+    const int keyCount = 10000;
+    const float length = 600;
+    int evaluationCount = run.quick ? 2000 : 20000;
+
+    // keys are added in random order so addKey has to insert them in the middle
+    FastRandom random(17);
+    QVector<double> keyTimes;
+    for (int i = 0; i < keyCount; i++)
+        keyTimes.append(length * i / (keyCount - 1));
+    for (int i = keyCount - 1; i > 0; i--)
+        std::swap(keyTimes[i], keyTimes[(int)(random.nextFloat() * i)]);
+
+    FloatKeyFrame keyFrame;
+    double addMs = run.time(1, [&]() {
+        keyFrame.clear();
+        for (auto time : keyTimes)
+            keyFrame.addKey(qSin(time * 0.1) * 10, time);
+    });
+    run.check(std::is_sorted(keyFrame.keys.begin(), keyFrame.keys.end(), [](const Key<float>& a, const Key<float>& b) {
+        return a.time < b.time;
+    }), "addKey left the keys out of order");
+
+    // playback moves a frame at a time, scrubbing and seeking jump anywhere
+    QVector<float> playbackTimes;
+    QVector<float> randomTimes;
+    for (int i = 0; i < evaluationCount; i++) {
+        playbackTimes.append(fmod(i / 60.0f, length));
+        randomTimes.append(random.nextFloat() * length);
+    }
+
+    int mismatches = 0;
+    for (auto times : {&playbackTimes, &randomTimes}) {
+        for (auto time : *times) {
+            if (qAbs(keyFrame.getValueAt(time) - linearValueAt(keyFrame, time)) > 1e-4f)
+                mismatches++;
+        }
+    }
+    run.check(mismatches == 0, QString("%1 values differ from walking the keys").arg(mismatches));
+
+    // the sum keeps the evaluations from being optimized away
+    float sum = 0;
+    auto evaluate = [&](const QVector<float>& times) {
+        for (auto time : times)
+            sum += keyFrame.getValueAt(time);
+    };
+    auto evaluateLinear = [&](const QVector<float>& times) {
+        for (auto time : times)
+            sum += linearValueAt(keyFrame, time);
+    };
+
+    double linearPlaybackMs = run.time(1, [&]() { evaluateLinear(playbackTimes); });
+    double playbackMs = run.time(1, [&]() { evaluate(playbackTimes); });
+    double linearRandomMs = run.time(1, [&]() { evaluateLinear(randomTimes); });
+    double randomMs = run.time(1, [&]() { evaluate(randomTimes); });
+    run.check(sum == sum, "evaluated a nan");
+
+    auto perValue = [&](double ms) {
+        return QString::number(ms * 1000000 / evaluationCount, 'f', 1) + " ns";
+    };
+
+    run.row({"keys, evaluations", QString("%1, %2").arg(keyCount).arg(evaluationCount)});
+    run.row({"addKey in random order", formatMs(addMs), QString::number(addMs * 1000000 / keyCount, 'f', 0) + " ns per key"});
+    run.row({"per evaluation", "walking keys", "getValueAt", "speedup"});
+    run.row({"playback", perValue(linearPlaybackMs), perValue(playbackMs), QString::number(linearPlaybackMs / playbackMs, 'f', 0) + "x"});
+    run.row({"random times", perValue(linearRandomMs), perValue(randomMs), QString::number(linearRandomMs / randomMs, 'f', 0) + "x"});
+}
+
+IRIS_BENCHMARK(animationBaking, "animation-baking", "Memory and per frame time of baked animations against evaluating the curves", true)
+{
+    int nodeCount = run.quick ? 1000 : 5000;
+    const int keyCount = 16;
+    const float length = 10;
+    const float rate = 60;
+    const float delta = 1.0f / 60;
+
+    auto scene = Scene::create();
+    auto nodes = createAnimatedNodes(scene, nodeCount, keyCount, length);
+
+    float time = 0;
+    auto playFrame = [&]() {
+        time += delta;
+        if (time > length)
+            time = 0;
+        scene->updateSceneAnimation(time);
+    };
+
+    double curveMs = run.time(10, playFrame);
+
+    // a sample time falls on a sample, so the baked state matches the curves there
+    const float sampleTime = 90 / rate;
+    scene->updateSceneAnimation(sampleTime);
+    QVector<QVector<QVector4D>> curveStates;
+    for (auto& node : nodes)
+        curveStates.append(getNodeState(node));
+
+    QElapsedTimer timer;
+    timer.start();
+    scene->bakeAnimations(rate);
+    double bakeMs = timer.nsecsElapsed() / 1000000.0;
+
+    scene->updateSceneAnimation(sampleTime);
+    int mismatches = 0;
+    for (int i = 0; i < nodes.size(); i++) {
+        auto bakedState = getNodeState(nodes[i]);
+        for (int v = 0; v < bakedState.size(); v++) {
+            if (!sameVector(bakedState[v], curveStates[i][v]) && !sameVector(-bakedState[v], curveStates[i][v])) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    run.check(mismatches == 0, QString("%1 nodes differ from their curves at a sample time").arg(mismatches));
+
+    double bakedMs = run.time(10, playFrame);
+
+    // editing a key resamples only that channel on the next frame
+    auto keyFrame = nodes[0]->animation->keyFrameSet->getKeyFrame("Translation X");
+    keyFrame->keys[keyCount / 2].value += 1;
+    keyFrame->setKeyTime(keyCount / 2, keyFrame->keys[keyCount / 2].time);
+    timer.start();
+    playFrame();
+    double editedMs = timer.nsecsElapsed() / 1000000.0;
+
+    auto stats = scene->getAnimationStats();
+    // a float per translation and scale channel, and the rotation as a quaternion
+    const int floatsPerSample = animatedChannelCount - 1 + 4;
+    int sampleCount = (int)std::ceil(length * rate) + 1;
+    run.check(stats.bakedSize == nodeCount * floatsPerSample * sampleCount * (int)sizeof(float),
+              "the baked size doesnt match the number of samples");
+    run.check(stats.bakedUpdateTime > 0 && stats.curveUpdateTime > 0, "the scene should have timed both kinds of frames");
+
+    scene->bakeAnimations(0);
+    run.check(scene->getAnimationStats().bakedSize == 0, "the samples should have been dropped");
+
+    run.row({"nodes, channels, keys", QString("%1, %2, %3").arg(nodeCount).arg(animatedChannelCount).arg(keyCount)});
+    run.row({"baked at", QString("%1 samples per second, %2 s").arg(rate).arg(length)});
+    run.row({"baked size", QString::number(stats.bakedSize / 1024) + " KiB",
+             QString::number(stats.bakedSize / (double)nodeCount / 1024, 'f', 1) + " KiB per node"});
+    run.row({"baking", formatMs(bakeMs)});
+    run.row({"per frame", "time", "getAnimationStats", "speedup"});
+    run.row({"curves", formatMs(curveMs), QString::number(stats.curveUpdateTime) + " us", "1.0x"});
+    run.row({"baked", formatMs(bakedMs), QString::number(stats.bakedUpdateTime) + " us", QString::number(curveMs / bakedMs, 'f', 1) + "x"});
+    run.row({"baked, after editing a key", formatMs(editedMs)});
+}
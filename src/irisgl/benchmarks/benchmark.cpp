@@ -0,0 +1,142 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "benchmark.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <cstdio>
+
+namespace iris
+{
+
+Benchmark::Benchmark(const char* name, const char* description, bool needsContext, Function function)
+{
+    this->name = name;
+    this->description = description;
+    this->needsContext = needsContext;
+    this->function = function;
+
+    getBenchmarks().append(this);
+}
+
+QList<Benchmark*>& Benchmark::getBenchmarks()
+{
+    // function local so registration from other files' static initializers is safe
+    static QList<Benchmark*> benchmarks;
+    return benchmarks;
+}
+
+Benchmark* Benchmark::find(const QString& name)
+{
+    for (auto benchmark : getBenchmarks()) {
+        if (benchmark->name == name)
+            return benchmark;
+    }
+
+    return nullptr;
+}
+
+BenchmarkRun::BenchmarkRun(const Benchmark* benchmark, int maxWorkers, bool quick)
+{
+    this->benchmark = benchmark;
+    this->maxWorkers = maxWorkers;
+    this->quick = quick;
+    checks = 0;
+    failures = 0;
+}
+
+double BenchmarkRun::time(int iterations, const std::function<void()>& func)
+{
+    const int repeats = quick ? 1 : 5;
+    func();
+
+    double best = 0;
+    QElapsedTimer timer;
+    for (int r = 0; r < repeats; r++) {
+        timer.start();
+        for (int i = 0; i < iterations; i++)
+            func();
+        double ms = timer.nsecsElapsed() / 1000000.0 / iterations;
+
+        if (r == 0 || ms < best)
+            best = ms;
+    }
+
+    return best;
+}
+
+QList<int> BenchmarkRun::getWorkerCounts() const
+{
+    QList<int> counts;
+    for (int count = 1; count < maxWorkers; count *= 2)
+        counts.append(count);
+    counts.append(maxWorkers);
+
+    return counts;
+}
+
+void BenchmarkRun::row(const QStringList& columns)
+{
+    rows.append(columns);
+}
+
+bool BenchmarkRun::check(bool passed, const QString& what)
+{
+    checks++;
+    if (!passed) {
+        failures++;
+        failedChecks.append(what);
+    }
+
+    return passed;
+}
+
+void BenchmarkRun::print() const
+{
+    printf("%s: %s\n", benchmark->name.toUtf8().constData(), benchmark->description.toUtf8().constData());
+
+    QVector<int> widths;
+    for (auto& columns : rows) {
+        for (int i = 0; i < columns.size(); i++) {
+            if (i >= widths.size())
+                widths.append(0);
+            widths[i] = qMax(widths[i], columns[i].size());
+        }
+    }
+
+    for (auto& columns : rows) {
+        QString line = "  ";
+        for (int i = 0; i < columns.size(); i++) {
+            // the first column is a label, the rest are numbers
+            if (i == 0)
+                line += columns[i].leftJustified(widths[i]);
+            else
+                line += "  " + columns[i].rightJustified(widths[i]);
+        }
+        printf("%s\n", line.toUtf8().constData());
+    }
+
+    for (auto& what : failedChecks)
+        printf("  FAILED: %s\n", what.toUtf8().constData());
+    printf("  %d of %d checks passed\n\n", checks - failures, checks);
+    fflush(stdout);
+}
+
+QString formatMs(double ms)
+{
+    if (ms < 0.01)
+        return QString::number(ms * 1000.0, 'f', 2) + " us";
+    if (ms < 10.0)
+        return QString::number(ms, 'f', 3) + " ms";
+    return QString::number(ms, 'f', 1) + " ms";
+}
+
+}
@@ -0,0 +1,110 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <functional>
+
+namespace iris
+{
+
+class BenchmarkRun;
+
+/**
+ * A named benchmark the irisglbench runner can run by name.
+ * Benchmarks register themselves with the IRIS_BENCHMARK macro.
+ */
+class Benchmark
+{
+public:
+    typedef void (*Function)(BenchmarkRun& run);
+
+    QString name;
+    QString description;
+    // whether run needs a current gl context
+    bool needsContext;
+    Function function;
+
+    Benchmark(const char* name, const char* description, bool needsContext, Function function);
+
+    static QList<Benchmark*>& getBenchmarks();
+    static Benchmark* find(const QString& name);
+};
+
+/**
+ * Passed to a running benchmark. It times the code under test and collects the
+ * report rows and the results of correctness checks.
+ */
+class BenchmarkRun
+{
+public:
+    // the most worker threads scaling benchmarks should go up to
+    int maxWorkers;
+    // smaller problem sizes so the whole suite runs quickly as a test
+    bool quick;
+
+    BenchmarkRun(const Benchmark* benchmark, int maxWorkers, bool quick);
+
+    /**
+     * Calls func iterations times after one untimed warm up call, repeats that
+     * a few times and returns the best time of one call in milliseconds.
+     * The best of several runs is the least disturbed by the rest of the system.
+     */
+    double time(int iterations, const std::function<void()>& func);
+
+    /**
+     * Returns the worker counts scaling benchmarks step through: 1, 2, 4, ...
+     * up to maxWorkers, which is always included
+     */
+    QList<int> getWorkerCounts() const;
+
+    /**
+     * Adds a row to the benchmark's report. The first column is a label, the
+     * columns are aligned when the report is printed.
+     */
+    void row(const QStringList& columns);
+
+    /**
+     * Records a correctness check. A failed check fails the benchmark and
+     * makes irisglbench exit with an error.
+     */
+    bool check(bool passed, const QString& what);
+
+    void print() const;
+
+    bool hasFailed() const
+    {
+        return failures > 0;
+    }
+
+private:
+    const Benchmark* benchmark;
+    QList<QStringList> rows;
+    QStringList failedChecks;
+    int checks;
+    int failures;
+};
+
+// formats milliseconds with enough digits for the sub millisecond timings
+QString formatMs(double ms);
+
+}
+
+#define IRIS_BENCHMARK(id, name, description, needsContext) \
+    static void id(iris::BenchmarkRun& run); \
+    static iris::Benchmark id##Benchmark(name, description, needsContext, id); \
+    static void id(iris::BenchmarkRun& run)
+
+#endif // BENCHMARK_H
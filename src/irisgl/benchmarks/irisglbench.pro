@@ -0,0 +1,48 @@
+#**************************************************************************
+#This file is part of IrisGL
+#http://www.irisgl.org
+#Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+#
+#This is free software: you may copy, redistribute
+#and/or modify it under the terms of the GPLv3 License
+#
+#For more information see the LICENSE file
+#**************************************************************************
+
+# benchmarks and checks for irisgl, built on their own so the editor isnt needed:
+#   qmake irisglbench.pro && make
+#   ./irisglbench --list
+#   ./irisglbench --quick                (every benchmark with small sizes, as a test)
+#   ./irisglbench trimesh-raycast        (one benchmark at full size)
+
+QT       += core gui
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+TARGET = irisglbench
+TEMPLATE = app
+
+include(../irisgl.pri)
+
+HEADERS += \
+    benchmark.h
+
+SOURCES += \
+    main.cpp \
+    benchmark.cpp \
+    trimeshbench.cpp \
+    scenebench.cpp \
+    shaderbench.cpp \
+    meshbench.cpp \
+    particlebench.cpp \
+    animationbench.cpp \
+    renderbench.cpp
+
+# scenes load their primitives from app/ next to the executable, like the editor
+# http://stackoverflow.com/questions/32631084/create-dir-copy-files-with-qmake
+movecontent.commands = $(COPY_DIR) \"$$shell_path($$PWD/../../../app)\" \"$$shell_path($$OUT_PWD/app)\"
+first.depends = $(first) movecontent
+export(first.depends)
+export(movecontent.commands)
+QMAKE_EXTRA_TARGETS += first movecontent
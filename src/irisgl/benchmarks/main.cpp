@@ -0,0 +1,126 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QSurfaceFormat>
+#include <QThread>
+#include <cstdio>
+
+#include "benchmark.h"
+#include "../src/core/jobsystem.h"
+#include "../src/vr/vrmanager.h"
+
+using namespace iris;
+
+/**
+ * Runs the irisgl benchmarks. Every benchmark also checks its results against a
+ * simple reference, so the exit code is non zero if any of them is wrong and
+ * "irisglbench --quick" doubles as the library's test run.
+ *
+ * The gl benchmarks draw to an offscreen surface, so no window is opened. On a
+ * machine without a display run it with QT_QPA_PLATFORM=minimalegl, or
+ * QT_QPA_PLATFORM=offscreen when only cpu benchmarks are picked.
+ *
+ * Renderers draw vr frames to a SimulatedVrDevice, so the vr benchmarks
+ * (vr-frames, vr-stereo) run headless without a headset or the oculus runtime.
+ */
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setApplicationName("irisglbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the IrisGL benchmarks and checks their results.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("benchmarks", "Benchmarks to run, all of them if none are given.", "[benchmarks...]");
+
+    QCommandLineOption listOption("list", "Lists the benchmarks.");
+    QCommandLineOption quickOption("quick", "Runs with small problem sizes, as a test.");
+    QCommandLineOption workersOption("workers", "Most worker threads the scaling benchmarks use.",
+                                     "count", QString::number(QThread::idealThreadCount()));
+    parser.addOption(listOption);
+    parser.addOption(quickOption);
+    parser.addOption(workersOption);
+    parser.process(app);
+
+    if (parser.isSet(listOption)) {
+        for (auto benchmark : Benchmark::getBenchmarks()) {
+            printf("%-20s %s\n", benchmark->name.toUtf8().constData(), benchmark->description.toUtf8().constData());
+        }
+        return 0;
+    }
+
+    QList<Benchmark*> benchmarks;
+    for (auto& name : parser.positionalArguments()) {
+        auto benchmark = Benchmark::find(name);
+        if (benchmark == nullptr) {
+            fprintf(stderr, "unknown benchmark %s, --list shows them\n", name.toUtf8().constData());
+            return 2;
+        }
+        benchmarks.append(benchmark);
+    }
+    if (benchmarks.isEmpty())
+        benchmarks = Benchmark::getBenchmarks();
+
+    VrManager::setBackend(VrBackend::Simulated);
+
+    int maxWorkers = qMax(1, parser.value(workersOption).toInt());
+    bool quick = parser.isSet(quickOption);
+
+    // created when the first gl benchmark runs so cpu benchmarks work without gl
+    QOffscreenSurface surface;
+    QOpenGLContext* context = nullptr;
+
+    int failed = 0;
+    for (auto benchmark : benchmarks) {
+        if (benchmark->needsContext && context == nullptr) {
+            QSurfaceFormat format;
+            format.setDepthBufferSize(24);
+            format.setMajorVersion(3);
+            format.setMinorVersion(2);
+            format.setProfile(QSurfaceFormat::CoreProfile);
+
+            surface.setFormat(format);
+            surface.create();
+
+            context = new QOpenGLContext();
+            context->setFormat(format);
+            if (!context->create() || !context->makeCurrent(&surface)) {
+                fprintf(stderr, "couldnt create a gl 3.2 core context for %s\n", benchmark->name.toUtf8().constData());
+                return 2;
+            }
+
+            auto gl = context->versionFunctions<QOpenGLFunctions_3_2_Core>();
+            printf("gl: %s, %s\n\n", gl->glGetString(GL_RENDERER), gl->glGetString(GL_VERSION));
+        }
+
+        BenchmarkRun run(benchmark, maxWorkers, quick);
+        benchmark->function(run);
+        run.print();
+
+        // scaling benchmarks change it, the next benchmark starts from the default
+        JobSystem::setWorkerCount(QThread::idealThreadCount());
+
+        if (run.hasFailed())
+            failed++;
+    }
+
+    if (failed > 0) {
+        printf("%d of %d benchmarks failed their checks\n", failed, benchmarks.size());
+        return 1;
+    }
+
+    return 0;
+}
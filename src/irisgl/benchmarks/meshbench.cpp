@@ -0,0 +1,193 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QtMath>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include "benchmark.h"
+#include "../src/core/irisutils.h"
+#include "../src/core/meshmanager.h"
+#include "../src/graphics/mesh.h"
+#include "../src/graphics/meshcooker.h"
+#include "../src/graphics/vertexlayout.h"
+#include "../src/geometry/trimesh.h"
+
+using namespace iris;
+
+namespace
+{
+
+// a rolling terrain of size by size quads with normals and texture coordinates
+bool writeTerrain(const QString& path, int size)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QTextStream stream(&file);
+    auto height = [=](int x, int z) {
+        return qSin(x * 0.1) * qCos(z * 0.07) * 4.0;
+    };
+
+    for (int z = 0; z <= size; z++) {
+        for (int x = 0; x <= size; x++) {
+            QVector3D normal(height(x - 1, z) - height(x + 1, z), 2, height(x, z - 1) - height(x, z + 1));
+            normal.normalize();
+
+            stream << "v " << (double)x << " " << height(x, z) << " " << (double)z << "\n";
+            stream << "vt " << x / (double)size << " " << z / (double)size << "\n";
+            stream << "vn " << (double)normal.x() << " " << (double)normal.y() << " " << (double)normal.z() << "\n";
+        }
+    }
+
+    // obj indices start at 1
+    auto vertex = [&](int x, int z) {
+        return QString::number(z * (size + 1) + x + 1);
+    };
+    auto corner = [&](int x, int z) {
+        auto index = vertex(x, z);
+        return index + "/" + index + "/" + index;
+    };
+
+    for (int z = 0; z < size; z++) {
+        for (int x = 0; x < size; x++) {
+            stream << "f " << corner(x, z) << " " << corner(x, z + 1) << " " << corner(x + 1, z + 1) << "\n";
+            stream << "f " << corner(x, z) << " " << corner(x + 1, z + 1) << " " << corner(x + 1, z) << "\n";
+        }
+    }
+
+    return true;
+}
+
+bool sameMesh(Mesh* a, Mesh* b)
+{
+    return a->vertexCount == b->vertexCount &&
+           a->gpuMemorySize == b->gpuMemorySize &&
+           a->getTriMesh()->triangles.size() == b->getTriMesh()->triangles.size() &&
+           a->boundingBox.minPos == b->boundingBox.minPos &&
+           a->boundingBox.maxPos == b->boundingBox.maxPos;
+}
+
+}
+
+IRIS_BENCHMARK(meshCooking, "mesh-cooking", "Loading a large model through assimp against loading its cooked mesh file", true)
+{
+    int size = run.quick ? 64 : 400;
+
+    QDir dir(QDir::tempPath() + "/irisglbench-meshes");
+    dir.removeRecursively();
+    dir.mkpath(".");
+    auto path = dir.absoluteFilePath("terrain.obj");
+    if (!run.check(writeTerrain(path, size), "couldnt write " + path))
+        return;
+
+    // the importer without cooking, as every load was before
+    QElapsedTimer timer;
+    timer.start();
+    auto imported = Mesh::loadMesh(path);
+    double assimpMs = timer.nsecsElapsed() / 1000000.0;
+
+    // the first load through the manager imports the file and cooks it
+    timer.start();
+    auto firstLoad = MeshManager::getMesh(path);
+    double firstLoadMs = timer.nsecsElapsed() / 1000000.0;
+    run.check(sameMesh(firstLoad, imported), "the manager's import differs from Mesh::loadMesh");
+
+    // later loads read the cooked file, purging drops the cached mesh each time
+    MeshManager::purgeUnused();
+    Mesh* cooked = nullptr;
+    double cookedMs = run.time(1, [&]() {
+        MeshManager::purgeUnused();
+        cooked = MeshManager::getMesh(path);
+    });
+    run.check(sameMesh(cooked, imported), "the cooked mesh differs from the imported one");
+
+    auto stats = MeshManager::getStats();
+    run.check(stats.cookedLoads > 0, "the cooked file was never loaded");
+
+    run.row({"vertices, triangles", QString("%1, %2").arg(imported->vertexCount).arg(imported->getTriMesh()->triangles.size())});
+    run.row({"obj file", QString::number(QFileInfo(path).size() / 1024) + " KiB"});
+    run.row({"cooked file", QString::number(QFileInfo(MeshCooker::getCookedPath(path)).size() / 1024) + " KiB"});
+    run.row({"Mesh::loadMesh, assimp", formatMs(assimpMs), "1.0x"});
+    run.row({"first load, import and cook", formatMs(firstLoadMs), QString::number(assimpMs / firstLoadMs, 'f', 1) + "x"});
+    run.row({"cooked load", formatMs(cookedMs), QString::number(assimpMs / cookedMs, 'f', 1) + "x"});
+
+    delete imported;
+    MeshManager::purgeUnused();
+    dir.removeRecursively();
+}
+
+IRIS_BENCHMARK(vertexFormat, "vertex-format", "Bytes per vertex of the packed vertex format against a float3 buffer per attribute", true)
+{
+    QStringList paths;
+    QDir primitives(IrisUtils::getAbsoluteAssetPath("app/content/primitives"));
+    for (auto& name : primitives.entryList({"*.obj"}, QDir::Files, QDir::Name))
+        paths.append(primitives.absoluteFilePath(name));
+    paths.append(IrisUtils::getAbsoluteAssetPath("app/models/gear.obj"));
+    paths.append(IrisUtils::getAbsoluteAssetPath("app/models/head.obj"));
+
+    QDir dir(QDir::tempPath() + "/irisglbench-meshes");
+    dir.removeRecursively();
+    dir.mkpath(".");
+    auto terrainPath = dir.absoluteFilePath("terrain.obj");
+    if (writeTerrain(terrainPath, run.quick ? 64 : 400))
+        paths.append(terrainPath);
+
+    // strides are the vertex alone, bytes per vertex also count the indices
+    run.row({"model", "vertices", "stride", "float3 stride", "bytes/vertex", "float3 bytes/vertex", "saved"});
+
+    qint64 totalVertices = 0;
+    qint64 totalBytes = 0;
+    qint64 totalUnpackedBytes = 0;
+    int grownMeshes = 0;
+    for (auto& path : paths) {
+        auto mesh = MeshManager::getMesh(path);
+        if (mesh == nullptr) {
+            run.check(false, "couldnt load " + path);
+            continue;
+        }
+
+        int stride = mesh->vertexLayout->getStride();
+        int unpackedStride = sizeof(float) * 3 * mesh->vertexLayout->getAttribs().size();
+        double bytesPerVertex = mesh->gpuMemorySize / (double)mesh->vertexCount;
+        double unpackedBytesPerVertex = mesh->unpackedMemorySize / (double)mesh->vertexCount;
+
+        run.row({QFileInfo(path).fileName(),
+                 QString::number(mesh->vertexCount),
+                 QString::number(stride),
+                 QString::number(unpackedStride),
+                 QString::number(bytesPerVertex, 'f', 1),
+                 QString::number(unpackedBytesPerVertex, 'f', 1),
+                 QString::number(100.0 - 100.0 * mesh->gpuMemorySize / mesh->unpackedMemorySize, 'f', 0) + "%"});
+
+        totalVertices += mesh->vertexCount;
+        totalBytes += mesh->gpuMemorySize;
+        totalUnpackedBytes += mesh->unpackedMemorySize;
+        if (mesh->gpuMemorySize > mesh->unpackedMemorySize)
+            grownMeshes++;
+    }
+
+    run.row({"all models",
+             QString::number(totalVertices),
+             "",
+             "",
+             QString::number(totalBytes / (double)totalVertices, 'f', 1),
+             QString::number(totalUnpackedBytes / (double)totalVertices, 'f', 1),
+             QString::number(100.0 - 100.0 * totalBytes / totalUnpackedBytes, 'f', 0) + "%"});
+    run.check(grownMeshes == 0, QString("%1 meshes take more memory packed").arg(grownMeshes));
+
+    MeshManager::purgeUnused();
+    dir.removeRecursively();
+}
@@ -0,0 +1,224 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QThread>
+#include <list>
+
+#include "benchmark.h"
+#include "../src/core/jobsystem.h"
+#include "../src/graphics/particlepool.h"
+#include "../src/scenegraph/particlesystemnode.h"
+#include "../src/math/fastrandom.h"
+
+using namespace iris;
+
+namespace
+{
+
+// how particles were stored before the pool, one heap allocation per particle in a list
+struct ListParticle
+{
+    QVector3D position;
+    QVector3D velocity;
+    float gravityEffect;
+    float lifeLength;
+    float rotation;
+    float scale;
+    float elapsedTime;
+};
+
+void updateList(std::list<ListParticle*>& particles, float delta)
+{
+    auto it = particles.begin();
+    while (it != particles.end()) {
+        auto p = *it;
+        p->velocity += QVector3D(0, ParticlePool::gravity * p->gravityEffect * delta, 0);
+        p->position += p->velocity * delta;
+        p->elapsedTime += delta;
+        p->scale *= 1.0f - p->elapsedTime / p->lifeLength;
+
+        if (p->elapsedTime > p->lifeLength) {
+            delete p;
+            it = particles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void clearList(std::list<ListParticle*>& particles)
+{
+    for (auto p : particles)
+        delete p;
+    particles.clear();
+}
+
+// emits the same particles into both, lives are picked from [minLife, maxLife)
+void emitParticles(int count, float minLife, float maxLife, ParticlePool& pool, std::list<ListParticle*>& list)
+{
+    FastRandom random(5);
+    pool.setCapacity(count);
+    for (int i = 0; i < count; i++) {
+        auto p = new ListParticle();
+        p->position = QVector3D(random.nextFloat(), random.nextFloat(), random.nextFloat());
+        p->velocity = QVector3D(random.nextFloat() - 0.5f, random.nextFloat() * 5, random.nextFloat() - 0.5f);
+        p->gravityEffect = random.nextFloat();
+        p->lifeLength = minLife + random.nextFloat() * (maxLife - minLife);
+        p->rotation = random.nextFloat() * 360;
+        p->scale = 1;
+        p->elapsedTime = 0;
+
+        pool.emit(p->position, p->velocity, p->gravityEffect, p->lifeLength, p->rotation, p->scale);
+        list.push_back(p);
+    }
+}
+
+// systems emitting enough to stay at about 80% of their capacity once warmed up
+QVector<ParticleSystemNodePtr> createSystems(int count, int capacity)
+{
+    QVector<ParticleSystemNodePtr> systems;
+    for (int i = 0; i < count; i++) {
+        auto system = ParticleSystemNode::create();
+        system->maxParticles = capacity;
+        system->setLife(2.0f);
+        system->setPPS(capacity * 0.4f);
+        system->setGravity(0.5f);
+        system->setSeed(i + 1);
+        systems.append(system);
+    }
+
+    return systems;
+}
+
+QVector<ParticleSystemNode*> getPointers(const QVector<ParticleSystemNodePtr>& systems)
+{
+    QVector<ParticleSystemNode*> pointers;
+    for (auto& system : systems)
+        pointers.append(system.data());
+    return pointers;
+}
+
+int countParticles(const QVector<ParticleSystemNode*>& systems)
+{
+    int count = 0;
+    for (auto system : systems)
+        count += system->getParticles().getCount();
+    return count;
+}
+
+}
+
+IRIS_BENCHMARK(particlePool, "particle-pool", "ParticlePool::update against the list of heap allocated particles it replaced", false)
+{
+    const float delta = 1.0f / 60;
+
+    // both are stepped until most particles died, the order differs so sums are compared
+    {
+        ParticlePool pool;
+        std::list<ListParticle*> list;
+        emitParticles(10000, 0.05f, 0.5f, pool, list);
+
+        double poolSum = 0;
+        double listSum = 0;
+        bool countsMatch = true;
+        for (int step = 0; step < 20; step++) {
+            pool.update(delta, ParticleDissipation::Shrink, 1.0f);
+            updateList(list, delta);
+            countsMatch = countsMatch && pool.getCount() == (int)list.size();
+        }
+        for (int i = 0; i < pool.getCount(); i++)
+            poolSum += pool.getPosition(i).y() + pool.getScale(i);
+        for (auto p : list)
+            listSum += p->position.y() + p->scale;
+
+        run.check(countsMatch, "pool and list kept a different number of particles");
+        run.check(qAbs(poolSum - listSum) <= 1e-4 * qAbs(listSum), "pool and list particles moved differently");
+        run.check(pool.getCount() > 0 && pool.getCount() < 10000, "some particles should have died");
+        clearList(list);
+    }
+
+    QList<int> counts = {10000, 100000};
+    if (!run.quick)
+        counts.append(1000000);
+
+    run.row({"particles", "list", "pool", "per particle", "speedup"});
+    for (auto count : counts) {
+        // lives are long enough that the counts stay the same while timing
+        ParticlePool pool;
+        std::list<ListParticle*> list;
+        emitParticles(count, 1000, 2000, pool, list);
+
+        double listMs = run.time(1, [&]() {
+            updateList(list, delta);
+        });
+        double poolMs = run.time(1, [&]() {
+            pool.update(delta, ParticleDissipation::Shrink, 1.0f);
+        });
+
+        run.row({QString::number(count), formatMs(listMs), formatMs(poolMs),
+                 QString::number(poolMs * 1000000.0 / count, 'f', 2) + " ns",
+                 QString::number(listMs / poolMs, 'f', 1) + "x"});
+        clearList(list);
+    }
+}
+
+IRIS_BENCHMARK(particleSimulate, "particle-simulate", "ParticleSystemNode::simulateParticles on 1 to N job system workers", true)
+{
+    int systemCount = run.quick ? 2 : 8;
+    int capacity = run.quick ? 20000 : 100000;
+    int warmUpSteps = 150;
+    const float delta = 1.0f / 60;
+
+    // the same systems on one worker and on several must end up with the same particles
+    {
+        auto single = createSystems(systemCount, capacity);
+        auto multi = createSystems(systemCount, capacity);
+        auto singlePointers = getPointers(single);
+        auto multiPointers = getPointers(multi);
+
+        for (int step = 0; step < warmUpSteps; step++) {
+            JobSystem::setWorkerCount(1);
+            ParticleSystemNode::simulateParticles(singlePointers, delta);
+            JobSystem::setWorkerCount(qMax(2, run.maxWorkers));
+            ParticleSystemNode::simulateParticles(multiPointers, delta);
+        }
+
+        bool same = countParticles(singlePointers) == countParticles(multiPointers);
+        for (int s = 0; same && s < systemCount; s++) {
+            auto& a = singlePointers[s]->getParticles();
+            auto& b = multiPointers[s]->getParticles();
+            for (int i = 0; same && i < a.getCount(); i++)
+                same = a.getPosition(i) == b.getPosition(i) && a.getScale(i) == b.getScale(i);
+        }
+        run.check(same, "simulating on several workers gave different particles than on one");
+    }
+
+    auto systems = createSystems(systemCount, capacity);
+    auto pointers = getPointers(systems);
+    for (int step = 0; step < warmUpSteps; step++)
+        ParticleSystemNode::simulateParticles(pointers, delta);
+
+    run.row({"systems, particles", QString("%1, %2").arg(systemCount).arg(countParticles(pointers))});
+    run.row({"cores", QString::number(QThread::idealThreadCount())});
+    run.row({"workers", "per step", "speedup"});
+
+    double singleMs = 0;
+    for (auto workers : run.getWorkerCounts()) {
+        JobSystem::setWorkerCount(workers);
+        double ms = run.time(10, [&]() {
+            ParticleSystemNode::simulateParticles(pointers, delta);
+        });
+        if (workers == 1)
+            singleMs = ms;
+
+        run.row({QString::number(workers), formatMs(ms), QString::number(singleMs / ms, 'f', 2) + "x"});
+    }
+}
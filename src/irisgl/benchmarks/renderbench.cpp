@@ -0,0 +1,592 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QtMath>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QThread>
+#include <QDir>
+#include <QFile>
+
+#include "benchmark.h"
+#include "../src/core/scene.h"
+#include "../src/core/irisutils.h"
+#include "../src/scenegraph/meshnode.h"
+#include "../src/scenegraph/lightnode.h"
+#include "../src/scenegraph/cameranode.h"
+#include "../src/materials/defaultmaterial.h"
+#include "../src/graphics/forwardrenderer.h"
+#include "../src/graphics/viewport.h"
+#include "../src/graphics/lightclusters.h"
+#include "../src/core/jobsystem.h"
+#include "../src/graphics/material.h"
+#include "../src/vr/vrmanager.h"
+#include "../src/vr/simulatedvrdevice.h"
+#include "../src/math/fastrandom.h"
+
+using namespace iris;
+
+namespace
+{
+
+const float frameDelta = 1.0f / 60;
+
+struct ShadowScene
+{
+    ScenePtr scene;
+    CameraNodePtr camera;
+    LightNodePtr light;
+    QVector<MeshNodePtr> movers;
+};
+
+MeshNodePtr addMesh(ScenePtr scene, const QString& path, const QVector3D& pos, const QVector3D& scale)
+{
+    auto node = MeshNode::create();
+    node->setMesh(IrisUtils::getAbsoluteAssetPath(path));
+    node->setMaterial(DefaultMaterial::create());
+    node->pos = pos;
+    node->scale = scale;
+    scene->getRootNode()->addChild(node, false);
+
+    return node;
+}
+
+// a field of side by side cubes on a ground plane, with spheres that can be moved around
+ShadowScene createShadowScene(int side, int moverCount)
+{
+    ShadowScene shadowScene;
+    auto scene = shadowScene.scene = Scene::create();
+    scene->shadowEnabled = true;
+
+    auto ground = addMesh(scene, "app/content/primitives/plane.obj", QVector3D(), QVector3D(1, 1, 1) * side * 4.0f);
+    ground->setShadowEnabled(false);
+
+    FastRandom random(19);
+    for (int z = 0; z < side; z++) {
+        for (int x = 0; x < side; x++) {
+            float height = 1 + random.nextFloat() * 3;
+            addMesh(scene, "app/content/primitives/cube.obj",
+                    QVector3D((x - side / 2) * 4.0f, height, (z - side / 2) * 4.0f),
+                    QVector3D(1, height, 1));
+        }
+    }
+
+    for (int i = 0; i < moverCount; i++)
+        shadowScene.movers.append(addMesh(scene, "app/content/primitives/sphere.obj", QVector3D(i * 3.0f, 6, 0), QVector3D(1, 1, 1)));
+
+    auto light = shadowScene.light = LightNode::create();
+    light->setLightType(LightType::Directional);
+    light->rot = QQuaternion::fromEulerAngles(-50, 30, 0);
+    scene->getRootNode()->addChild(light, false);
+
+    auto camera = shadowScene.camera = CameraNode::create();
+    camera->pos = QVector3D(0, 12, 30);
+    camera->rot = QQuaternion::fromEulerAngles(-25, 0, 0);
+    scene->setCamera(camera);
+
+    return shadowScene;
+}
+
+QVector<float> readDepthTexture(GLuint texture, int size)
+{
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+    QVector<float> depth(size * size);
+    gl->glBindTexture(GL_TEXTURE_2D, texture);
+    gl->glGetTexImage(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+    return depth;
+}
+
+struct FramesResult
+{
+    double frameMs;
+    int rebuilds;
+    int hits;
+    int shadowItemsDrawn;
+};
+
+// renders frames, calling step before each one to move things
+template<typename Step>
+FramesResult renderFrames(ShadowScene& shadowScene, ForwardRendererPtr renderer, Viewport* viewport, int frames, Step step)
+{
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+
+    FramesResult result = {0, 0, 0, 0};
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < frames; frame++) {
+        step(frame);
+        shadowScene.scene->update(frameDelta);
+        renderer->renderScene(frameDelta, viewport);
+
+        auto& stats = renderer->getRenderStats();
+        result.rebuilds += stats.shadowCacheRebuilds;
+        result.hits += stats.shadowCacheHits;
+        result.shadowItemsDrawn += stats.shadowItemsDrawn;
+    }
+    gl->glFinish();
+    result.frameMs = timer.nsecsElapsed() / 1000000.0 / frames;
+
+    return result;
+}
+
+// point and spot lights scattered through the view, ranges are picked from [minRange, maxRange)
+// returns the position and range of each light
+QVector<QVector4D> addLights(LightClusters& clusters, int count, float minRange, float maxRange)
+{
+    FastRandom random(7);
+    QVector<QVector4D> lights;
+    clusters.clear();
+    for (int i = 0; i < count; i++) {
+        QVector3D pos((random.nextFloat() - 0.5f) * 160, random.nextFloat() * 20, -random.nextFloat() * 180);
+        QVector3D dir(random.nextFloat() - 0.5f, -1, random.nextFloat() - 0.5f);
+        float range = minRange + random.nextFloat() * (maxRange - minRange);
+        auto type = i % 4 == 0 ? LightType::Spot : LightType::Point;
+        clusters.addLight((int)type, pos, dir.normalized(), range, QColor(255, 255, 255), 1.0f, 30.0f, 0.5f);
+        lights.append(QVector4D(pos, range));
+    }
+
+    return lights;
+}
+
+// the cluster a view space point falls in, found the way light_clusters.glsl does
+int getCluster(const LightClusters& clusters, const QMatrix4x4& projMatrix, const QVector3D& viewPos)
+{
+    auto ndc = projMatrix.map(viewPos);
+    int x = qBound(0, (int)((ndc.x() * 0.5f + 0.5f) * LightClusters::gridWidth), LightClusters::gridWidth - 1);
+    int y = qBound(0, (int)((ndc.y() * 0.5f + 0.5f) * LightClusters::gridHeight), LightClusters::gridHeight - 1);
+    int z = qBound(0, (int)(std::log(-viewPos.z()) * clusters.getDepthScale() + clusters.getDepthBias()),
+                   LightClusters::gridDepth - 1);
+
+    return (z * LightClusters::gridHeight + y) * LightClusters::gridWidth + x;
+}
+
+// counts points inside a light's range whose cluster doesnt list that light
+int countMissedLights(const LightClusters& clusters, const QVector<QVector4D>& lights,
+                      const QMatrix4x4& viewMatrix, const QMatrix4x4& projMatrix, int pointCount)
+{
+    auto& data = clusters.getClusterData();
+    auto invView = viewMatrix.inverted();
+    auto invProj = projMatrix.inverted();
+
+    FastRandom random(11);
+    int missed = 0;
+    for (int p = 0; p < pointCount; p++) {
+        // uniformly over the screen and the depth range
+        auto farPoint = invProj.map(QVector3D(random.nextFloat() * 2 - 1, random.nextFloat() * 2 - 1, 1.0f));
+        auto viewPos = farPoint * (0.001f + random.nextFloat() * 0.998f);
+        if (-viewPos.z() < 0.2f)
+            continue;
+        auto worldPos = invView.map(viewPos);
+
+        int cluster = getCluster(clusters, projMatrix, viewPos);
+        int offset = data[cluster * 2];
+        int count = data[cluster * 2 + 1];
+
+        for (int i = 0; i < lights.size(); i++) {
+            if ((lights[i].toVector3D() - worldPos).length() > lights[i].w())
+                continue;
+
+            bool listed = false;
+            for (int j = 0; j < count && !listed; j++)
+                listed = (int)data[offset + j] == i;
+            missed += !listed;
+        }
+    }
+
+    return missed;
+}
+
+// a headset with small eyes that doesnt move, renderers created after this draw to it
+SimulatedVrDevice* createVrDevice()
+{
+    SimulatedVrSettings settings;
+    settings.eyeWidth = 320;
+    settings.eyeHeight = 360;
+    settings.mirrorWidth = 640;
+    settings.mirrorHeight = 360;
+
+    auto device = new SimulatedVrDevice(settings);
+    device->setScript([](double, SimulatedVrState& state) {
+        state.headRotation = QQuaternion::fromEulerAngles(-30, 0, 0);
+    });
+    VrManager::setDefaultDevice(device);
+
+    return device;
+}
+
+bool writeFile(const QString& path, const QString& contents)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(contents.toUtf8());
+    return true;
+}
+
+// a flat color that reads its matrices from the FrameData block, it has no u_stereo
+// so single pass stereo draws it once per eye
+class FrameBlockMaterial : public Material
+{
+public:
+    FrameBlockMaterial(const QString& vsPath, const QString& fsPath)
+    {
+        createProgramFromShaderSource(vsPath, fsPath);
+    }
+};
+
+bool writeFrameBlockShaders(const QString& vsPath, const QString& fsPath)
+{
+    return writeFile(vsPath,
+                     "#version 150\n"
+                     "#pragma include <uniform_blocks.glsl>\n"
+                     "in vec3 a_pos;\n"
+                     "uniform mat4 u_worldMatrix;\n"
+                     "void main() {\n"
+                     "    gl_Position = u_projMatrix * u_viewMatrix * u_worldMatrix * vec4(a_pos, 1.0);\n"
+                     "}\n") &&
+           writeFile(fsPath,
+                     "#version 150\n"
+                     "out vec4 fragColor;\n"
+                     "void main() {\n"
+                     "    fragColor = vec4(1.0, 0.5, 0.1, 1.0);\n"
+                     "}\n");
+}
+
+QVector<uchar> readMirror(VrDevice* device, int width, int height)
+{
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+    QVector<uchar> pixels(width * height * 4);
+    device->bindMirrorTextureId();
+    gl->glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+    return pixels;
+}
+
+}
+
+IRIS_BENCHMARK(vrFrames, "vr-frames", "Frames drawn with renderSceneVr to a simulated rift cv1, with its frame pacing stats", true)
+{
+    int frames = run.quick ? 3 : 20;
+
+    // rift cv1 eyes and refresh rate, looking around with the default script
+    auto device = new SimulatedVrDevice();
+    VrManager::setDefaultDevice(device);
+    auto& settings = device->getSettings();
+
+    auto shadowScene = createShadowScene(run.quick ? 6 : 16, 8);
+    shadowScene.camera->pos = QVector3D(0, 10, 22);
+    shadowScene.camera->rot = QQuaternion();
+
+    auto renderer = ForwardRenderer::create();
+    renderer->setScene(shadowScene.scene);
+    run.check(renderer->isVrSupported(), "the simulated device wasnt initialized");
+
+    Viewport viewport;
+    viewport.width = settings.mirrorWidth;
+    viewport.height = settings.mirrorHeight;
+    viewport.pixelRatioScale = 1;
+
+    run.row({"eye size, refresh", QString("%1x%2, %3 Hz").arg(settings.eyeWidth).arg(settings.eyeHeight).arg(settings.refreshRate)});
+    run.row({QString("%1 frames").arg(frames), "fps", "last render", "last frame", "max frame", "missed refreshes"});
+
+    for (bool stereo : {false, true}) {
+        renderer->setStereoRenderingEnabled(stereo);
+
+        // the first frame creates the stereo target
+        shadowScene.scene->update(frameDelta);
+        renderer->renderSceneVr(frameDelta, &viewport);
+        device->resetStats();
+
+        QElapsedTimer timer;
+        timer.start();
+        qint64 firstFrameEnd = 0;
+        for (int frame = 0; frame < frames; frame++) {
+            shadowScene.scene->update(frameDelta);
+            renderer->renderSceneVr(frameDelta, &viewport);
+            if (frame == 0)
+                firstFrameEnd = timer.nsecsElapsed();
+        }
+        double seconds = timer.nsecsElapsed() / 1e9;
+
+        // after the first frame every refresh either showed a new frame or was missed
+        auto stats = device->getStats();
+        double refreshes = (seconds - firstFrameEnd / 1e9) * settings.refreshRate;
+        double expectedMissed = qMax(0.0, refreshes - (frames - 1));
+        run.check(stats.frameCount == frames, QString("the device counted %1 frames instead of %2").arg(stats.frameCount).arg(frames));
+        run.check(stats.renderTime > 0 && stats.frameTime <= stats.maxFrameTime, "the frame times are inconsistent");
+        run.check(qAbs(stats.missedRefreshes - expectedMissed) <= 2 + refreshes * 0.02,
+                  QString("%1 missed refreshes counted, about %2 expected").arg(stats.missedRefreshes).arg(expectedMissed, 0, 'f', 0));
+
+        run.row({stereo ? "single pass stereo" : "each eye",
+                 QString::number(frames / seconds, 'f', 1),
+                 formatMs(stats.renderTime / 1000.0),
+                 formatMs(stats.frameTime / 1000.0),
+                 formatMs(stats.maxFrameTime / 1000.0),
+                 QString::number(stats.missedRefreshes)});
+    }
+}
+
+IRIS_BENCHMARK(vrStereo, "vr-stereo", "Single pass stereo against drawing each eye, with programs that support it and programs that dont", true)
+{
+    QDir dir(QDir::tempPath() + "/irisglbench-shaders");
+    dir.mkpath(".");
+    auto vsPath = dir.absoluteFilePath("frameblock.vert");
+    auto fsPath = dir.absoluteFilePath("frameblock.frag");
+    if (!run.check(writeFrameBlockShaders(vsPath, fsPath), "couldnt write the shaders to " + dir.path()))
+        return;
+
+    auto device = createVrDevice();
+    auto& settings = device->getSettings();
+
+    // stereo cubes on the left, cubes drawn once per eye on the right
+    int side = run.quick ? 6 : 12;
+    auto shadowScene = createShadowScene(side, 0);
+    auto frameBlockMaterial = MaterialPtr(new FrameBlockMaterial(vsPath, fsPath));
+    int fallbackItems = 0;
+    for (auto child : shadowScene.scene->getRootNode()->children) {
+        if (child->getSceneNodeType() == SceneNodeType::Mesh && child->pos.x() > 0) {
+            child.staticCast<MeshNode>()->setMaterial(frameBlockMaterial);
+            fallbackItems++;
+        }
+    }
+
+    // the headset adds its own rotation
+    shadowScene.camera->pos = QVector3D(0, 10, 22);
+    shadowScene.camera->rot = QQuaternion();
+
+    auto renderer = ForwardRenderer::create();
+    renderer->setScene(shadowScene.scene);
+
+    Viewport viewport;
+    viewport.width = settings.mirrorWidth;
+    viewport.height = settings.mirrorHeight;
+    viewport.pixelRatioScale = 1;
+
+    auto renderVr = [&](bool stereo) {
+        renderer->setStereoRenderingEnabled(stereo);
+        shadowScene.scene->update(frameDelta);
+        renderer->renderSceneVr(frameDelta, &viewport);
+    };
+
+    renderVr(false);
+    auto eyesImage = readMirror(device, settings.mirrorWidth, settings.mirrorHeight);
+    auto eyesStats = renderer->getRenderStats();
+    renderVr(true);
+    auto stereoImage = readMirror(device, settings.mirrorWidth, settings.mirrorHeight);
+    auto stereoStats = renderer->getRenderStats();
+
+    // the two paths rasterize the same triangles, only pixels along edges may differ.
+    // the items drawn once per eye are compared on their own, they're a flat color
+    auto isFallbackColor = [](const QVector<uchar>& image, int i) {
+        return image[i] > 240 && qAbs(image[i + 1] - 188) < 12 && qAbs(image[i + 2] - 89) < 12;
+    };
+    int differentPixels = 0;
+    int fallbackPixels = 0;
+    int differentFallbackPixels = 0;
+    for (int i = 0; i < eyesImage.size(); i += 4) {
+        int diff = 0;
+        for (int c = 0; c < 3; c++)
+            diff = qMax(diff, qAbs(eyesImage[i + c] - stereoImage[i + c]));
+        differentPixels += diff > 8;
+
+        bool eyesFallback = isFallbackColor(eyesImage, i);
+        bool stereoFallback = isFallbackColor(stereoImage, i);
+        fallbackPixels += eyesFallback || stereoFallback;
+        differentFallbackPixels += eyesFallback != stereoFallback;
+    }
+    double differentPercent = 100.0 * differentPixels / (eyesImage.size() / 4);
+    double differentFallbackPercent = 100.0 * differentFallbackPixels / qMax(fallbackPixels, 1);
+    run.check(fallbackPixels > 0, "the items drawn once per eye arent in the image");
+    run.check(differentPercent < 1.0, QString("%1% of the pixels differ between single pass stereo and drawing each eye")
+                                      .arg(differentPercent, 0, 'f', 2));
+    run.check(differentFallbackPercent < 2.0, QString("%1% of the pixels of the items drawn once per eye moved in single pass stereo")
+                                              .arg(differentFallbackPercent, 0, 'f', 2));
+
+    int frames = run.quick ? 5 : 30;
+    double eyesMs = run.time(frames, [&]() { renderVr(false); });
+    double stereoMs = run.time(frames, [&]() { renderVr(true); });
+
+    run.row({"items, drawn once per eye", QString("%1, %2").arg(side * side + 1).arg(fallbackItems)});
+    run.row({"eye size", QString("%1x%2").arg(settings.eyeWidth).arg(settings.eyeHeight)});
+    run.row({"pixels differing", QString::number(differentPercent, 'f', 2) + "%"});
+    run.row({"pixels of items drawn per eye differing", QString::number(differentFallbackPercent, 'f', 2) + "%"});
+    run.row({"", "per frame", "draw calls", "instanced batches", "program binds"});
+    run.row({"each eye", formatMs(eyesMs), QString::number(eyesStats.drawCalls),
+             QString::number(eyesStats.instancedBatches), QString::number(eyesStats.programBinds)});
+    run.row({"single pass stereo", formatMs(stereoMs), QString::number(stereoStats.drawCalls),
+             QString::number(stereoStats.instancedBatches), QString::number(stereoStats.programBinds)});
+
+    dir.removeRecursively();
+}
+
+IRIS_BENCHMARK(lightClusters, "light-clusters", "LightClusters::build binning point and spot lights on 1 to N job system workers", true)
+{
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+    LightClusters clusters(gl);
+
+    QMatrix4x4 viewMatrix;
+    viewMatrix.lookAt(QVector3D(0, 5, 10), QVector3D(0, 5, -10), QVector3D(0, 1, 0));
+    QMatrix4x4 projMatrix;
+    projMatrix.perspective(60, 16.0f / 9.0f, 0.1f, 200);
+
+    // every point in a light's range must find the light in its cluster's list
+    {
+        auto lights = addLights(clusters, 500, 1, 8);
+
+        JobSystem::setWorkerCount(1);
+        clusters.build(viewMatrix, projMatrix);
+        int missed = countMissedLights(clusters, lights, viewMatrix, projMatrix, run.quick ? 20000 : 200000);
+        run.check(clusters.getStats().overflowCount == 0, "a cluster overflowed, the coverage check needs fewer lights");
+        run.check(missed == 0, QString("%1 points in a light's range didnt find it in their cluster").arg(missed));
+
+        // the slices are binned separately so the lists dont depend on the workers
+        auto singleData = clusters.getClusterData();
+        JobSystem::setWorkerCount(qMax(2, run.maxWorkers));
+        clusters.build(viewMatrix, projMatrix);
+        run.check(clusters.getClusterData() == singleData, "binning on several workers gave different clusters than on one");
+    }
+
+    QList<int> counts = {100, 1000};
+    if (!run.quick)
+        counts.append(4000);
+
+    run.row({"cores", QString::number(QThread::idealThreadCount())});
+    run.row({"lights", "workers", "per build", "speedup", "visible", "clusters used", "indices", "overflows"});
+    for (auto count : counts) {
+        addLights(clusters, count, 1, 8);
+
+        double singleMs = 0;
+        for (auto workers : run.getWorkerCounts()) {
+            JobSystem::setWorkerCount(workers);
+            double ms = run.time(10, [&]() {
+                clusters.build(viewMatrix, projMatrix);
+            });
+            if (workers == 1)
+                singleMs = ms;
+
+            auto& stats = clusters.getStats();
+            run.row({QString::number(count), QString::number(workers), formatMs(ms),
+                     QString::number(singleMs / ms, 'f', 2) + "x",
+                     QString::number(stats.visibleLights), QString::number(stats.clustersUsed),
+                     QString::number(stats.indexCount), QString::number(stats.overflowCount)});
+        }
+    }
+}
+
+IRIS_BENCHMARK(shadowCache, "shadow-cache", "Per cascade rebuilds of the static casters' cached shadow depth while the camera, casters and light move", true)
+{
+    int side = run.quick ? 10 : 24;
+    int frames = run.quick ? 20 : 60;
+    const int moverCount = 8;
+
+    auto shadowScene = createShadowScene(side, moverCount);
+    auto renderer = ForwardRenderer::create();
+    renderer->setScene(shadowScene.scene);
+
+    // smaller than the defaults so a software renderer keeps up
+    ShadowSettings settings;
+    settings.cascadeResolution = 1024;
+    renderer->setShadowSettings(settings);
+    int atlasSize = ShadowCascades::getGridSize(settings.cascadeCount) * settings.cascadeResolution;
+    int cascadeFrames = frames * settings.cascadeCount;
+
+    // a small view so the frame time is mostly the shadow pass
+    Viewport viewport;
+    viewport.width = 160;
+    viewport.height = 90;
+    viewport.pixelRatioScale = 1;
+
+    auto still = [](int) {};
+
+    // on the first frame every caster is new so they're all drawn straight into the cascades
+    renderFrames(shadowScene, renderer, &viewport, 1, still);
+    auto directDepth = readDepthTexture(renderer->getShadowMap(), atlasSize);
+
+    // once they're static the cascades are copied from the static layer, from the same view
+    renderFrames(shadowScene, renderer, &viewport, 40, still);
+    auto cachedDepth = readDepthTexture(renderer->getShadowMap(), atlasSize);
+
+    // both are drawn with the same matrices, so they should be the same texel for texel
+    int shadowTexels = 0;
+    int differentTexels = 0;
+    for (int i = 0; i < directDepth.size(); i++) {
+        if (directDepth[i] < 1.0f || cachedDepth[i] < 1.0f)
+            shadowTexels++;
+        if (directDepth[i] != cachedDepth[i])
+            differentTexels++;
+    }
+    run.check(shadowTexels > 0, "nothing was drawn into the shadow map");
+    run.check(differentTexels == 0, QString("%1 texels differ from drawing the casters directly").arg(differentTexels));
+
+    auto moveCamera = [&](int frame) {
+        shadowScene.camera->pos += QVector3D(0.3f, 0, -0.2f);
+        shadowScene.camera->rot = QQuaternion::fromEulerAngles(-25, frame * 1.5f, 0);
+    };
+    auto moveSpheres = [&](int frame) {
+        moveCamera(frame);
+        for (int i = 0; i < shadowScene.movers.size(); i++) {
+            float angle = frame * 0.05f + i;
+            shadowScene.movers[i]->pos = QVector3D(qCos(angle) * 10, 6, qSin(angle) * 10);
+        }
+    };
+    auto turnLight = [&](int frame) {
+        shadowScene.light->rot = QQuaternion::fromEulerAngles(-50, 30 + (frame + 1) * 0.5f, 0);
+    };
+
+    // the same frames with the static casters drawn every frame, as before they were cached
+    // the camera is put back so both runs see the same views
+    auto cameraPos = shadowScene.camera->pos;
+    auto runAll = [&](bool cached, FramesResult results[3]) {
+        settings.cacheStaticCasters = cached;
+        renderer->setShadowSettings(settings);
+        shadowScene.camera->pos = cameraPos;
+        shadowScene.camera->rot = QQuaternion::fromEulerAngles(-25, 0, 0);
+        // long enough for the spheres moved by the last run to become static again
+        renderFrames(shadowScene, renderer, &viewport, 40, still);
+
+        results[0] = renderFrames(shadowScene, renderer, &viewport, frames, still);
+        results[1] = renderFrames(shadowScene, renderer, &viewport, frames, moveCamera);
+        results[2] = renderFrames(shadowScene, renderer, &viewport, frames, moveSpheres);
+    };
+
+    FramesResult uncached[3];
+    FramesResult cached[3];
+    runAll(false, uncached);
+    runAll(true, cached);
+    auto lightResult = renderFrames(shadowScene, renderer, &viewport, frames, turnLight);
+
+    run.check(cached[0].rebuilds == 0 && cached[0].hits == cascadeFrames, "every cascade should be reused while nothing moves");
+    run.check(cached[1].hits > 0, "moving the camera rebuilt every cascade every frame");
+    run.check(cached[2].rebuilds <= cached[1].rebuilds + settings.cascadeCount,
+              QString("moving casters rebuilt %1 cascades, only leaving the static casters should").arg(cached[2].rebuilds - cached[1].rebuilds));
+    run.check(lightResult.rebuilds == cascadeFrames, "turning the light should rebuild every cascade every frame");
+    run.check(uncached[0].rebuilds == cascadeFrames, "turning the cache off should rebuild every cascade every frame");
+
+    run.row({"casters, moving", QString("%1, %2").arg(side * side + moverCount).arg(moverCount)});
+    run.row({"atlas, cascades, step", QString("%1, %2, %3").arg(atlasSize).arg(settings.cascadeCount).arg(settings.cascadeStep)});
+    run.row({"cached texels differing", QString::number(differentTexels)});
+    run.row({QString("%1 frames").arg(frames), "per frame", "cascade rebuilds", "hits", "shadow items per frame"});
+
+    auto addRow = [&](const QString& name, const FramesResult& result) {
+        run.row({name, formatMs(result.frameMs), QString::number(result.rebuilds), QString::number(result.hits),
+                 QString::number(result.shadowItemsDrawn / (double)frames, 'f', 1)});
+    };
+    const char* names[] = {"nothing moving", "camera moving", "camera and spheres moving"};
+    for (int i = 0; i < 3; i++) {
+        addRow(QString(names[i]) + ", not cached", uncached[i]);
+        addRow(names[i], cached[i]);
+    }
+    addRow("light turning", lightResult);
+}
@@ -0,0 +1,328 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QtMath>
+#include <QElapsedTimer>
+#include <algorithm>
+
+#include "benchmark.h"
+#include "../src/core/scene.h"
+#include "../src/core/scenenode.h"
+#include "../src/core/transformsystem.h"
+#include "../src/core/irisutils.h"
+#include "../src/scenegraph/meshnode.h"
+#include "../src/graphics/mesh.h"
+#include "../src/geometry/trimesh.h"
+#include "../src/math/fastrandom.h"
+
+using namespace iris;
+
+namespace
+{
+
+struct Segment
+{
+    QVector3D start;
+    QVector3D end;
+};
+
+// spheres scattered over a square grid, every one sharing the same mesh
+ScenePtr createSphereField(int nodeCount, float spacing)
+{
+    auto scene = Scene::create();
+    auto meshPath = IrisUtils::getAbsoluteAssetPath("app/content/primitives/sphere.obj");
+
+    FastRandom random(3);
+    int side = qCeil(qSqrt(nodeCount));
+    for (int i = 0; i < nodeCount; i++) {
+        auto node = MeshNode::create();
+        node->setMesh(meshPath);
+        node->pos = QVector3D((i % side) * spacing, random.nextFloat() * spacing, (i / side) * spacing);
+        node->scale = QVector3D(1, 1, 1) * (0.5f + random.nextFloat());
+        scene->getRootNode()->addChild(node, false);
+    }
+
+    return scene;
+}
+
+// across the field through the spheres, a quarter pass above it and miss
+QVector<Segment> createSegments(int count, float fieldSize, float spacing)
+{
+    FastRandom random(11);
+    QVector<Segment> segments;
+    for (int i = 0; i < count; i++) {
+        float height = i % 4 == 0 ? spacing * 3 : random.nextFloat() * spacing;
+        float angle = random.nextFloat() * 2 * M_PI;
+
+        Segment segment;
+        segment.start = QVector3D(random.nextFloat() * fieldSize, height, random.nextFloat() * fieldSize);
+        segment.end = segment.start + QVector3D(qCos(angle), 0, qSin(angle)) * fieldSize * 0.5f;
+        segments.append(segment);
+    }
+
+    return segments;
+}
+
+// the closest hit is found on a shortened segment, so distances can differ by float rounding
+bool sameDistance(float a, float b)
+{
+    return qAbs(a - b) <= 1e-5f * qMax(a, b);
+}
+
+bool pickingResultLessThan(const PickingResult& a, const PickingResult& b)
+{
+    if (a.hitNode.data() != b.hitNode.data())
+        return a.hitNode.data() < b.hitNode.data();
+    return a.distanceFromStartSqrd < b.distanceFromStartSqrd;
+}
+
+bool samePickingResults(QList<PickingResult> a, QList<PickingResult> b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    std::sort(a.begin(), a.end(), pickingResultLessThan);
+    std::sort(b.begin(), b.end(), pickingResultLessThan);
+    for (int i = 0; i < a.size(); i++) {
+        if (a[i].hitNode != b[i].hitNode ||
+            !sameDistance(a[i].distanceFromStartSqrd, b[i].distanceFromStartSqrd))
+            return false;
+    }
+
+    return true;
+}
+
+// nodes are added breadth first so every parent has branching children
+QVector<SceneNodePtr> createHierarchy(ScenePtr scene, int nodeCount, int branching)
+{
+    FastRandom random(7);
+    QVector<SceneNodePtr> nodes;
+    nodes.append(scene->getRootNode());
+    for (int i = 1; i < nodeCount; i++) {
+        auto node = SceneNode::create();
+        node->pos = QVector3D(random.nextFloat(), random.nextFloat(), random.nextFloat()) * 2.0f;
+        node->rot = QQuaternion::fromEulerAngles(random.nextFloat() * 90, random.nextFloat() * 90, 0);
+        node->scale = QVector3D(1, 1, 1) * (0.9f + random.nextFloat() * 0.2f);
+        nodes[(i - 1) / branching]->addChild(node, false);
+        nodes.append(node);
+    }
+
+    return nodes;
+}
+
+// the world transform built from pos, rot and scale of the node and every ancestor
+QMatrix4x4 composeGlobalTransform(SceneNodePtr node)
+{
+    QMatrix4x4 local;
+    local.translate(node->pos);
+    local.rotate(node->rot);
+    local.scale(node->scale);
+
+    if (!node->parent)
+        return local;
+    return composeGlobalTransform(node->parent) * local;
+}
+
+bool sameMatrix(const QMatrix4x4& a, const QMatrix4x4& b)
+{
+    for (int i = 0; i < 16; i++) {
+        if (qAbs(a.constData()[i] - b.constData()[i]) > 1e-3f * qMax(1.0f, qAbs(b.constData()[i])))
+            return false;
+    }
+    return true;
+}
+
+}
+
+IRIS_BENCHMARK(sceneTransforms, "scene-transforms", "Per frame SceneNode transform updates of a static hierarchy", true)
+{
+    int nodeCount = run.quick ? 5000 : 50000;
+    const int branching = 4;
+
+    auto scene = Scene::create();
+    auto nodes = createHierarchy(scene, nodeCount, branching);
+    auto leaf = nodes.last();
+
+    // render lists are cleared by the renderer, which isnt used here
+    auto update = [&]() {
+        scene->update(0);
+        scene->geometryRenderList.clear();
+        scene->shadowRenderList.clear();
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    update();
+    double firstMs = timer.nsecsElapsed() / 1000000.0;
+
+    QVector<quint64> versions;
+    for (auto& node : nodes)
+        versions.append(node->getTransformVersion());
+
+    double staticMs = run.time(10, update);
+
+    int rebuilt = 0;
+    for (int i = 0; i < nodes.size(); i++)
+        rebuilt += nodes[i]->getTransformVersion() != versions[i];
+    run.check(rebuilt == 0, QString("%1 transforms were rebuilt although nothing moved").arg(rebuilt));
+
+    auto moveLeaf = [&]() {
+        leaf->pos += QVector3D(0.001f, 0, 0);
+        update();
+    };
+    double leafMs = run.time(10, moveLeaf);
+
+    // every node rebuilt, what each frame cost before transforms were only rebuilt on changes
+    auto rebuildAll = [&]() {
+        for (auto& node : nodes)
+            node->markTransformDirty();
+        update();
+    };
+    double allMs = run.time(1, rebuildAll);
+
+    QMatrix4x4 transform;
+    double getGlobalMs = run.time(1000, [&]() {
+        transform = leaf->getGlobalTransform();
+    });
+
+    // the root moving must reach the deepest node
+    scene->getRootNode()->pos += QVector3D(1, 2, 3);
+    update();
+    run.check(sameMatrix(leaf->globalTransform, composeGlobalTransform(leaf)),
+              "the deepest node's transform doesnt match its ancestors'");
+
+    // the same frame with the flattened transform system doing the transforms
+    // the frames with the flattened transform system doing the transforms, the scene still walks
+    // the nodes to submit render items so the system's own update time is reported too
+    scene->setTransformSystemEnabled(true);
+    auto transformSystem = scene->getTransformSystem();
+    update();
+    double systemStaticMs = run.time(10, update);
+    run.check(transformSystem->getStats().nodesChanged == 0, "the transform system rebuilt transforms although nothing moved");
+    qint64 systemStaticUs = transformSystem->getStats().updateTime;
+    double systemLeafMs = run.time(10, moveLeaf);
+    qint64 systemLeafUs = transformSystem->getStats().updateTime;
+    double systemAllMs = run.time(1, rebuildAll);
+    qint64 systemAllUs = transformSystem->getStats().updateTime;
+
+    scene->getRootNode()->pos += QVector3D(1, 2, 3);
+    update();
+    run.check(sameMatrix(leaf->globalTransform, composeGlobalTransform(leaf)) &&
+              sameMatrix(transformSystem->getWorldTransform(leaf->getTransformHandle()), leaf->globalTransform),
+              "the transform system's deepest node doesnt match its ancestors'");
+    scene->setTransformSystemEnabled(false);
+
+    int depth = 0;
+    for (auto node = leaf; !!node->parent; node = node->parent)
+        depth++;
+
+    run.row({"nodes, depth", QString("%1, %2").arg(nodes.size()).arg(depth)});
+    run.row({"first update", formatMs(firstMs)});
+    run.row({"per frame", "time", "vs every node rebuilt", "TransformSystem::update"});
+    run.row({"every node rebuilt", formatMs(allMs), "1.0x"});
+    run.row({"nothing moved", formatMs(staticMs), QString::number(allMs / staticMs, 'f', 1) + "x"});
+    run.row({"one leaf moved", formatMs(leafMs), QString::number(allMs / leafMs, 'f', 1) + "x"});
+    run.row({"every node rebuilt, transform system", formatMs(systemAllMs), QString::number(allMs / systemAllMs, 'f', 1) + "x",
+             QString::number(systemAllUs) + " us"});
+    run.row({"nothing moved, transform system", formatMs(systemStaticMs), QString::number(allMs / systemStaticMs, 'f', 1) + "x",
+             QString::number(systemStaticUs) + " us"});
+    run.row({"one leaf moved, transform system", formatMs(systemLeafMs), QString::number(allMs / systemLeafMs, 'f', 1) + "x",
+             QString::number(systemLeafUs) + " us"});
+    run.row({"getGlobalTransform, deepest node", QString::number(getGlobalMs * 1000000, 'f', 0) + " ns"});
+}
+
+IRIS_BENCHMARK(sceneRaycast, "scene-raycast", "Scene ray casts through the spatial index against walking every node", true)
+{
+    int nodeCount = run.quick ? 1000 : 10000;
+    int segmentCount = run.quick ? 50 : 500;
+    const float spacing = 4;
+
+    QElapsedTimer timer;
+    timer.start();
+    auto scene = createSphereField(nodeCount, spacing);
+    double createMs = timer.nsecsElapsed() / 1000000.0;
+
+    // the first update calculates the transforms and fills the spatial index
+    timer.start();
+    scene->update(0);
+    double indexMs = timer.nsecsElapsed() / 1000000.0;
+
+    auto segments = createSegments(segmentCount, qSqrt(nodeCount) * spacing, spacing);
+
+    run.row({"mesh nodes", QString::number(nodeCount)});
+    run.row({"triangles per mesh", QString::number(scene->getRootNode()->children[0].staticCast<MeshNode>()->getMesh()->getTriMesh()->triangles.size())});
+    run.row({"create nodes", formatMs(createMs)});
+    run.row({"first update, fills index", formatMs(indexMs)});
+
+    // the brute force walk is the reference both indexed queries are checked against
+    int allMismatches = 0;
+    int closestMismatches = 0;
+    int hitCount = 0;
+    qint64 nodesVisited = 0;
+    qint64 meshesTested = 0;
+    for (auto& segment : segments) {
+        QList<PickingResult> bruteForce;
+        scene->rayCast(scene->getRootNode(), segment.start, segment.end, bruteForce);
+
+        QList<PickingResult> indexed;
+        scene->rayCast(segment.start, segment.end, indexed);
+        if (!samePickingResults(indexed, bruteForce))
+            allMismatches++;
+
+        float closestDistance = -1;
+        for (auto& result : bruteForce) {
+            if (closestDistance < 0 || result.distanceFromStartSqrd < closestDistance)
+                closestDistance = result.distanceFromStartSqrd;
+        }
+
+        PickingResult closest;
+        bool hit = scene->rayCastClosest(segment.start, segment.end, closest);
+        if (hit != !bruteForce.isEmpty() || (hit && !sameDistance(closest.distanceFromStartSqrd, closestDistance)))
+            closestMismatches++;
+        if (hit)
+            hitCount++;
+
+        nodesVisited += scene->lastRayCastStats.treeNodesVisited;
+        meshesTested += scene->lastRayCastStats.meshesTested;
+    }
+    run.row({"segments, hitting", QString("%1, %2").arg(segments.size()).arg(hitCount)});
+    run.row({"closest: tree nodes, meshes per segment",
+             QString("%1, %2").arg(nodesVisited / (double)segments.size(), 0, 'f', 1)
+                              .arg(meshesTested / (double)segments.size(), 0, 'f', 1)});
+    run.check(allMismatches == 0, QString("indexed hits differ from the brute force walk for %1 segments").arg(allMismatches));
+    run.check(closestMismatches == 0, QString("closest hit differs from the brute force walk for %1 segments").arg(closestMismatches));
+    run.check(hitCount > 0 && hitCount < segments.size(), "segments should both hit and miss");
+
+    QList<PickingResult> results;
+    PickingResult result;
+
+    double bruteForceMs = run.time(1, [&]() {
+        for (auto& segment : segments) {
+            results.clear();
+            scene->rayCast(scene->getRootNode(), segment.start, segment.end, results);
+        }
+    });
+    double indexedMs = run.time(1, [&]() {
+        for (auto& segment : segments) {
+            results.clear();
+            scene->rayCast(segment.start, segment.end, results);
+        }
+    });
+    double closestMs = run.time(1, [&]() {
+        for (auto& segment : segments)
+            scene->rayCastClosest(segment.start, segment.end, result);
+    });
+
+    run.row({"per segment", "time", "vs brute force"});
+    run.row({"brute force, all hits", formatMs(bruteForceMs / segments.size()), "1.0x"});
+    run.row({"rayCast, all hits", formatMs(indexedMs / segments.size()), QString::number(bruteForceMs / indexedMs, 'f', 1) + "x"});
+    run.row({"rayCastClosest", formatMs(closestMs / segments.size()), QString::number(bruteForceMs / closestMs, 'f', 1) + "x"});
+}
@@ -0,0 +1,127 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+
+#include "benchmark.h"
+#include "../src/graphics/graphicshelper.h"
+#include "../src/graphics/programbinarycache.h"
+
+using namespace iris;
+
+namespace
+{
+
+// the programs the engine's materials, renderer and post processes load on startup
+const char* shaderPairs[][2] = {
+    {":assets/shaders/default_material.vert", ":assets/shaders/default_material.frag"},
+    {":assets/shaders/defaultsky.vert", ":assets/shaders/defaultsky.frag"},
+    {":assets/shaders/viewer.vert", ":assets/shaders/viewer.frag"},
+    {":assets/shaders/color.vert", ":assets/shaders/color.frag"},
+    {":assets/shaders/shadow_map.vert", ":assets/shaders/shadow_map.frag"},
+    {":assets/shaders/billboard.vert", ":assets/shaders/billboard.frag"},
+    {":assets/shaders/fullscreen.vert", ":assets/shaders/fullscreen.frag"},
+    {":assets/shaders/postprocesses/default.vs", ":assets/shaders/postprocesses/bloom_blur.fs"},
+    {":assets/shaders/postprocesses/default.vs", ":assets/shaders/postprocesses/bloom_combine.fs"},
+    {":assets/shaders/postprocesses/default.vs", ":assets/shaders/postprocesses/bloom_threshold.fs"},
+    {":assets/shaders/postprocesses/default.vs", ":assets/shaders/postprocesses/coloroverlay.fs"},
+    {":assets/shaders/postprocesses/default.vs", ":assets/shaders/postprocesses/greyscale.fs"},
+    {":assets/shaders/postprocesses/default.vs", ":assets/shaders/postprocesses/radial_blur.fs"},
+    {":assets/shaders/postprocesses/default.vs", ":assets/shaders/postprocesses/ssao.fs"}
+};
+const int shaderPairCount = sizeof(shaderPairs) / sizeof(shaderPairs[0]);
+
+struct LoadPass
+{
+    double timeMs;
+    int linked;
+    ProgramBinaryCacheStats stats;
+};
+
+/**
+ * Loads every program in a new context, as a fresh start of the editor would.
+ * The shader cache keys programs by share group so none are shared with earlier passes.
+ * context is kept by the caller so a later context cant reuse its share group's address.
+ */
+LoadPass loadPrograms(QOpenGLContext* context, QSurface* surface)
+{
+    context->setFormat(QOpenGLContext::currentContext()->format());
+    context->create();
+    context->makeCurrent(surface);
+
+    auto before = ProgramBinaryCache::getStats();
+
+    LoadPass pass;
+    pass.linked = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < shaderPairCount; i++) {
+        auto program = GraphicsHelper::loadShader(shaderPairs[i][0], shaderPairs[i][1]);
+        if (program->isLinked())
+            pass.linked++;
+    }
+    pass.timeMs = timer.nsecsElapsed() / 1000000.0;
+
+    auto after = ProgramBinaryCache::getStats();
+    pass.stats.binaryHits = after.binaryHits - before.binaryHits;
+    pass.stats.binaryMisses = after.binaryMisses - before.binaryMisses;
+    pass.stats.binaryRejected = after.binaryRejected - before.binaryRejected;
+    pass.stats.loadTimeMs = after.loadTimeMs - before.loadTimeMs;
+    pass.stats.compileTimeMs = after.compileTimeMs - before.compileTimeMs;
+
+    return pass;
+}
+
+}
+
+IRIS_BENCHMARK(programBinaryCache, "program-binary-cache", "Loading the engine's shader programs from source and from saved program binaries", true)
+{
+    if (!ProgramBinaryCache::isSupported()) {
+        run.row({"program binaries", "not supported by this driver"});
+        return;
+    }
+
+    auto mainContext = QOpenGLContext::currentContext();
+    auto surface = mainContext->surface();
+
+    // an empty cache directory so the first pass is a first start
+    auto previousDir = ProgramBinaryCache::getCacheDir();
+    QDir cacheDir(QDir::tempPath() + "/irisglbench-shaders");
+    cacheDir.removeRecursively();
+    ProgramBinaryCache::setCacheDir(cacheDir.absolutePath());
+
+    QOpenGLContext coldContext;
+    QOpenGLContext warmContext;
+    auto cold = loadPrograms(&coldContext, surface);
+    auto warm = loadPrograms(&warmContext, surface);
+
+    mainContext->makeCurrent(surface);
+    ProgramBinaryCache::setCacheDir(previousDir);
+    cacheDir.removeRecursively();
+
+    run.row({"programs", QString::number(shaderPairCount)});
+    run.row({"", "first start", "binaries saved"});
+    run.row({"load all programs", formatMs(cold.timeMs), formatMs(warm.timeMs)});
+    run.row({"compiling from source", formatMs(cold.stats.compileTimeMs), formatMs(warm.stats.compileTimeMs)});
+    run.row({"restoring binaries", formatMs(cold.stats.loadTimeMs), formatMs(warm.stats.loadTimeMs)});
+    run.row({"binary hits, misses, rejected",
+             QString("%1, %2, %3").arg(cold.stats.binaryHits).arg(cold.stats.binaryMisses).arg(cold.stats.binaryRejected),
+             QString("%1, %2, %3").arg(warm.stats.binaryHits).arg(warm.stats.binaryMisses).arg(warm.stats.binaryRejected)});
+    run.row({"speedup", "1.0x", QString::number(cold.timeMs / warm.timeMs, 'f', 1) + "x"});
+
+    run.check(cold.linked == shaderPairCount && warm.linked == shaderPairCount, "every program should link");
+    run.check(cold.stats.binaryMisses == shaderPairCount, "the first start should compile every program");
+    run.check(warm.stats.binaryHits == shaderPairCount, "the second start should restore every program from its binary");
+}
@@ -0,0 +1,161 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include <QtMath>
+#include <QElapsedTimer>
+
+#include "benchmark.h"
+#include "../src/geometry/trimesh.h"
+#include "../src/geometry/trimeshbvh.h"
+#include "../src/math/fastrandom.h"
+
+using namespace iris;
+
+namespace
+{
+
+// a sphere with bumps on it, so hits are spread over the whole hierarchy
+void buildBumpySphere(TriMesh* mesh, int rings, int segments)
+{
+    auto point = [=](int ring, int segment) {
+        float theta = M_PI * ring / rings;
+        float phi = 2 * M_PI * segment / segments;
+        float radius = 10.0f + 0.5f * qSin(theta * 7) * qSin(phi * 5);
+        return QVector3D(qSin(theta) * qCos(phi), qCos(theta), qSin(theta) * qSin(phi)) * radius;
+    };
+
+    // counter-clockwise seen from outside, so segments coming from outside hit
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            auto a = point(r, s);
+            auto b = point(r + 1, s);
+            auto c = point(r + 1, s + 1);
+            auto d = point(r, s + 1);
+            if (r != 0)
+                mesh->addTriangle(a, d, c);
+            if (r != rings - 1)
+                mesh->addTriangle(a, c, b);
+        }
+    }
+}
+
+struct Segment
+{
+    QVector3D start;
+    QVector3D end;
+};
+
+// from outside the sphere towards a point inside it, with a quarter missing it
+QVector<Segment> createSegments(int count)
+{
+    FastRandom random(7);
+    auto randomVector = [&]() {
+        return QVector3D(random.nextFloat() * 2 - 1, random.nextFloat() * 2 - 1, random.nextFloat() * 2 - 1);
+    };
+
+    QVector<Segment> segments;
+    for (int i = 0; i < count; i++) {
+        Segment segment;
+        segment.start = randomVector().normalized() * 30;
+        segment.end = randomVector() * (i % 4 == 0 ? 40 : 8);
+        segments.append(segment);
+    }
+
+    return segments;
+}
+
+}
+
+IRIS_BENCHMARK(trimeshRaycast, "trimesh-raycast", "TriMesh segment queries through the BVH against testing every triangle", false)
+{
+    int rings = run.quick ? 32 : 224;
+    int segmentCount = run.quick ? 200 : 2000;
+
+    TriMesh mesh;
+    buildBumpySphere(&mesh, rings, rings * 2);
+    auto segments = createSegments(segmentCount);
+
+    QElapsedTimer timer;
+    timer.start();
+    mesh.getBVH();
+    double buildMs = timer.nsecsElapsed() / 1000000.0;
+
+    auto bvh = mesh.getBVH();
+    run.row({"triangles", QString::number(mesh.triangles.size())});
+    run.row({"bvh nodes, depth", QString("%1, %2").arg(bvh->nodes.size()).arg(bvh->getDepth())});
+    run.row({"bvh build", formatMs(buildMs)});
+
+    // the linear path is the reference both bvh queries are checked against
+    int closestMismatches = 0;
+    int allMismatches = 0;
+    int hitCount = 0;
+    for (auto& segment : segments) {
+        QList<TriangleIntersectionResult> linear;
+        mesh.getSegmentIntersectionsLinear(segment.start, segment.end, linear);
+
+        QList<TriangleIntersectionResult> all;
+        mesh.getSegmentIntersections(segment.start, segment.end, all);
+        if (all.size() != linear.size()) {
+            allMismatches++;
+        } else {
+            for (int i = 0; i < all.size(); i++) {
+                if (all[i].triangleIndex != linear[i].triangleIndex)
+                    allMismatches++;
+            }
+        }
+
+        float closestT = 2.0f;
+        for (auto& result : linear)
+            closestT = qMin(closestT, result.t);
+
+        TriangleIntersectionResult closest;
+        bool hit = mesh.getClosestSegmentIntersection(segment.start, segment.end, closest);
+        if (hit != !linear.isEmpty() || (hit && qAbs(closest.t - closestT) > 1e-6f))
+            closestMismatches++;
+        if (hit)
+            hitCount++;
+    }
+    run.row({"segments, hitting", QString("%1, %2").arg(segments.size()).arg(hitCount)});
+    run.check(closestMismatches == 0, QString("closest hit differs from the linear search for %1 segments").arg(closestMismatches));
+    run.check(allMismatches == 0, QString("all hits differ from the linear search for %1 segments").arg(allMismatches));
+    run.check(hitCount > 0 && hitCount < segments.size(), "segments should both hit and miss");
+
+    QVector3D hitPoint;
+    TriangleIntersectionResult result;
+    QList<TriangleIntersectionResult> results;
+
+    double linearMs = run.time(1, [&]() {
+        for (auto& segment : segments) {
+            results.clear();
+            mesh.getSegmentIntersectionsLinear(segment.start, segment.end, results);
+        }
+    });
+    double closestMs = run.time(1, [&]() {
+        for (auto& segment : segments)
+            mesh.getClosestSegmentIntersection(segment.start, segment.end, result);
+    });
+    double allMs = run.time(1, [&]() {
+        for (auto& segment : segments) {
+            results.clear();
+            mesh.getSegmentIntersections(segment.start, segment.end, results);
+        }
+    });
+    double anyMs = run.time(1, [&]() {
+        for (auto& segment : segments)
+            mesh.isHitBySegment(segment.start, segment.end, hitPoint);
+    });
+
+    run.row({"per segment", "time", "vs linear"});
+    run.row({"linear, all hits", formatMs(linearMs / segments.size()), "1.0x"});
+    run.row({"bvh, all hits", formatMs(allMs / segments.size()), QString::number(linearMs / allMs, 'f', 1) + "x"});
+    run.row({"bvh, closest hit", formatMs(closestMs / segments.size()), QString::number(linearMs / closestMs, 'f', 1) + "x"});
+    run.row({"bvh, isHitBySegment", formatMs(anyMs / segments.size()), QString::number(linearMs / anyMs, 'f', 1) + "x"});
+}
@@ -18,6 +18,7 @@ HEADERS += \
     $$PWD/src/graphics/texture2d.h \
     $$PWD/src/graphics/texture.h \
     $$PWD/src/graphics/mesh.h \
+    $$PWD/src/graphics/meshcooker.h \
     $$PWD/src/graphics/material.h \
     $$PWD/src/scenegraph/cameranode.h \
     $$PWD/src/scenegraph/meshnode.h \
@@ -30,11 +31,20 @@ HEADERS += \
     $$PWD/src/graphics/graphicshelper.h \
     $$PWD/src/graphics/utils/billboard.h \
     $$PWD/src/geometry/trimesh.h \
+    $$PWD/src/geometry/trimeshbvh.h \
+    $$PWD/src/geometry/boundingbox.h \
+    $$PWD/src/geometry/aabbtree.h \
     $$PWD/src/materials/defaultskymaterial.h \
     $$PWD/src/core/meshmanager.h \
+    $$PWD/src/core/jobsystem.h \
+    $$PWD/src/core/transformsystem.h \
     $$PWD/src/graphics/utils/fullscreenquad.h \
     $$PWD/src/vr/vrdevice.h \
+    $$PWD/src/vr/ovrdevice.h \
+    $$PWD/src/vr/simulatedvrdevice.h \
     $$PWD/src/math/mathhelper.h \
+    $$PWD/src/math/fastrandom.h \
+    $$PWD/src/math/frustum.h \
     $$PWD/src/irisglfwd.h \
     $$PWD/src/graphics/shader.h \
     $$PWD/src/irisgl.h \
@@ -42,13 +52,21 @@ HEADERS += \
     $$PWD/src/animation/keyframeset.h \
     $$PWD/src/math/bezierhelper.h \
     $$PWD/src/animation/animation.h \
+    $$PWD/src/animation/animationbinding.h \
     $$PWD/src/materials/materialhelper.h \
     $$PWD/src/core/irisutils.h \
     $$PWD/src/scenegraph/viewernode.h \
     $$PWD/src/materials/viewermaterial.h \
-    $$PWD/src/graphics/particle.h \
+    $$PWD/src/graphics/particlepool.h \
     $$PWD/src/graphics/particlerender.h \
     $$PWD/src/graphics/renderitem.h \
+    $$PWD/src/graphics/renderqueue.h \
+    $$PWD/src/graphics/uniformblocks.h \
+    $$PWD/src/graphics/instancebuffer.h \
+    $$PWD/src/graphics/shadowcascades.h \
+    $$PWD/src/graphics/lightclusters.h \
+    $$PWD/src/graphics/shadercache.h \
+    $$PWD/src/graphics/programbinarycache.h \
     $$PWD/src/scenegraph/particlesystemnode.h \
     $$PWD/src/vr/vrmanager.h \
     $$PWD/src/graphics/iviewsource.h \
@@ -70,11 +88,23 @@ include(src/libovr/libovr.pri)
 
 SOURCES += \
     $$PWD/src/graphics/mesh.cpp \
+    $$PWD/src/graphics/meshcooker.cpp \
     $$PWD/src/materials/defaultmaterial.cpp \
     $$PWD/src/core/scene.cpp \
+    $$PWD/src/core/meshmanager.cpp \
+    $$PWD/src/core/jobsystem.cpp \
+    $$PWD/src/core/transformsystem.cpp \
     $$PWD/src/scenegraph/meshnode.cpp \
     $$PWD/src/core/scenenode.cpp \
     $$PWD/src/graphics/forwardrenderer.cpp \
+    $$PWD/src/graphics/renderqueue.cpp \
+    $$PWD/src/graphics/uniformblocks.cpp \
+    $$PWD/src/graphics/particlepool.cpp \
+    $$PWD/src/graphics/instancebuffer.cpp \
+    $$PWD/src/graphics/shadowcascades.cpp \
+    $$PWD/src/graphics/lightclusters.cpp \
+    $$PWD/src/graphics/shadercache.cpp \
+    $$PWD/src/graphics/programbinarycache.cpp \
     $$PWD/src/graphics/graphicshelper.cpp \
     $$PWD/src/graphics/utils/billboard.cpp \
     $$PWD/src/scenegraph/cameranode.cpp \
@@ -83,11 +113,16 @@ SOURCES += \
     $$PWD/src/graphics/material.cpp \
     $$PWD/src/graphics/utils/fullscreenquad.cpp \
     $$PWD/src/vr/vrdevice.cpp \
+    $$PWD/src/vr/ovrdevice.cpp \
+    $$PWD/src/vr/simulatedvrdevice.cpp \
     $$PWD/src/geometry/trimesh.cpp \
+    $$PWD/src/geometry/trimeshbvh.cpp \
+    $$PWD/src/geometry/aabbtree.cpp \
     $$PWD/src/graphics/vertexlayout.cpp \
     $$PWD/src/graphics/shader.cpp \
     $$PWD/src/graphics/texture.cpp \
     $$PWD/src/animation/animation.cpp \
+    $$PWD/src/animation/animationbinding.cpp \
     $$PWD/src/animation/keyframeset.cpp \
     $$PWD/src/materials/materialhelper.cpp \
     $$PWD/src/scenegraph/viewernode.cpp \
@@ -106,3 +141,9 @@ SOURCES += \
 
 RESOURCES += \
     $$PWD/assets.qrc
+
+# gcc only vectorizes loops that need a remainder loop, like the particle pool's, at -O3
+# qmake builds release with -O2. clang and msvc already vectorize them at -O2
+*-g++ {
+    QMAKE_CXXFLAGS_RELEASE += -ftree-vectorize -fvect-cost-model=dynamic
+}
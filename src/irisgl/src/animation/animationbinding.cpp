@@ -0,0 +1,274 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "animationbinding.h"
+#include "keyframeset.h"
+#include "keyframeanimation.h"
+#include "../core/scenenode.h"
+
+#include <cmath>
+
+namespace iris
+{
+
+namespace
+{
+
+struct ChannelName
+{
+    const char* name;
+    AnimationTarget target;
+};
+
+const ChannelName channelNames[] = {
+    {"Translation X", AnimationTarget::TranslationX},
+    {"Translation Y", AnimationTarget::TranslationY},
+    {"Translation Z", AnimationTarget::TranslationZ},
+    {"Rotation X", AnimationTarget::RotationX},
+    {"Rotation Y", AnimationTarget::RotationY},
+    {"Rotation Z", AnimationTarget::RotationZ},
+    {"Scale X", AnimationTarget::ScaleX},
+    {"Scale Y", AnimationTarget::ScaleY},
+    {"Scale Z", AnimationTarget::ScaleZ}
+};
+
+}
+
+AnimationBinding::AnimationBinding() :
+    bakeRate(0),
+    sampleCount(0),
+    rowSize(0),
+    rotationColumn(-1),
+    sourceVersion(0),
+    rotationChannelCount(0)
+{
+    eulerRotation[0] = eulerRotation[1] = eulerRotation[2] = 0;
+}
+
+bool AnimationBinding::isCompiledFrom(const QSharedPointer<KeyFrameSet>& keyFrameSet) const
+{
+    // a freed set clears source, so the pointers can only match if it's the same set
+    return !keyFrameSet.isNull() &&
+           source == keyFrameSet &&
+           sourceVersion == keyFrameSet->getVersion();
+}
+
+void AnimationBinding::compile(SceneNode* node, const QSharedPointer<KeyFrameSet>& keyFrameSet)
+{
+    channels.clear();
+    rotationChannelCount = 0;
+    clearBake();
+
+    source = keyFrameSet;
+    sourceVersion = !keyFrameSet.isNull() ? keyFrameSet->getVersion() : 0;
+    if (keyFrameSet.isNull())
+        return;
+
+    for (const auto& channelName : channelNames) {
+        auto keyFrame = keyFrameSet->getKeyFrame(channelName.name);
+        if (keyFrame == nullptr)
+            continue;
+
+        AnimationChannel channel;
+        channel.target = channelName.target;
+        channel.keyFrame = keyFrame;
+        channel.bakedVersion = -1;
+
+        switch (channelName.target) {
+        case AnimationTarget::TranslationX: channel.slot = &node->pos[0]; break;
+        case AnimationTarget::TranslationY: channel.slot = &node->pos[1]; break;
+        case AnimationTarget::TranslationZ: channel.slot = &node->pos[2]; break;
+        case AnimationTarget::RotationX: channel.slot = &eulerRotation[0]; break;
+        case AnimationTarget::RotationY: channel.slot = &eulerRotation[1]; break;
+        case AnimationTarget::RotationZ: channel.slot = &eulerRotation[2]; break;
+        case AnimationTarget::ScaleX: channel.slot = &node->scale[0]; break;
+        case AnimationTarget::ScaleY: channel.slot = &node->scale[1]; break;
+        case AnimationTarget::ScaleZ: channel.slot = &node->scale[2]; break;
+        }
+
+        switch (channelName.target) {
+        case AnimationTarget::RotationX:
+        case AnimationTarget::RotationY:
+        case AnimationTarget::RotationZ:
+            rotationChannelCount++;
+            break;
+        default:
+            break;
+        }
+
+        channels.append(channel);
+    }
+
+    // translation and scale channels get a column each, the rotation quaternion comes last
+    int valueColumnCount = channels.size() - rotationChannelCount;
+    int column = 0;
+    rotationColumn = rotationChannelCount != 0 ? valueColumnCount : -1;
+    for (auto& channel : channels) {
+        if (channel.slot >= eulerRotation && channel.slot < eulerRotation + 3)
+            channel.column = rotationColumn;
+        else
+            channel.column = column++;
+    }
+    rowSize = valueColumnCount + (rotationChannelCount != 0 ? 4 : 0);
+}
+
+void AnimationBinding::apply(SceneNode* node, float time)
+{
+    if (channels.isEmpty())
+        return;
+
+    if (isBaked()) {
+        updateBake(node);
+
+        // blends the two samples around time, times past the last key keep the last sample
+        float samplePos = qBound(0.0f, time * bakeRate, (float)(sampleCount - 1));
+        int index = (int)samplePos;
+        int nextIndex = qMin(index + 1, sampleCount - 1);
+        float t = samplePos - index;
+
+        auto a = bakedSamples.constData() + index * rowSize;
+        auto b = bakedSamples.constData() + nextIndex * rowSize;
+        for (const auto& channel : channels) {
+            if (channel.column != rotationColumn)
+                *channel.slot = a[channel.column] + (b[channel.column] - a[channel.column]) * t;
+        }
+
+        // neighbouring samples were baked in the same hemisphere, so the blend takes the short way
+        if (rotationColumn >= 0) {
+            a += rotationColumn;
+            b += rotationColumn;
+            node->rot = QQuaternion(a[0] + (b[0] - a[0]) * t,
+                                    a[1] + (b[1] - a[1]) * t,
+                                    a[2] + (b[2] - a[2]) * t,
+                                    a[3] + (b[3] - a[3]) * t).normalized();
+        }
+
+        return;
+    }
+
+    // axes without a channel keep the node's current rotation
+    if (rotationChannelCount != 0 && rotationChannelCount != 3) {
+        auto euler = node->rot.toEulerAngles();
+        eulerRotation[0] = euler.x();
+        eulerRotation[1] = euler.y();
+        eulerRotation[2] = euler.z();
+    }
+
+    for (const auto& channel : channels)
+        *channel.slot = channel.keyFrame->getValueAt(time);
+
+    if (rotationChannelCount != 0)
+        node->rot = QQuaternion::fromEulerAngles(eulerRotation[0], eulerRotation[1], eulerRotation[2]);
+}
+
+void AnimationBinding::bake(SceneNode* node, float rate)
+{
+    bakeRate = rate;
+    if (rate <= 0) {
+        clearBake();
+        return;
+    }
+
+    // enough samples to reach the last key of the longest channel
+    double lastKeyTime = 0;
+    for (const auto& channel : channels) {
+        if (!channel.keyFrame->keys.empty())
+            lastKeyTime = qMax(lastKeyTime, channel.keyFrame->keys.back().time);
+    }
+
+    sampleCount = (int)std::ceil(lastKeyTime * rate) + 1;
+    bakedSamples.resize(sampleCount * rowSize);
+
+    for (int i = 0; i < channels.size(); i++) {
+        if (channels[i].column != rotationColumn)
+            bakeChannel(i);
+    }
+
+    if (rotationColumn >= 0)
+        bakeRotation(node);
+}
+
+void AnimationBinding::clearBake()
+{
+    bakeRate = 0;
+    sampleCount = 0;
+    bakedSamples.clear();
+    bakedSamples.squeeze();
+}
+
+void AnimationBinding::bakeChannel(int index)
+{
+    auto& channel = channels[index];
+
+    for (int i = 0; i < sampleCount; i++)
+        bakedSamples[i * rowSize + channel.column] = channel.keyFrame->getValueAt(i / bakeRate);
+
+    channel.bakedVersion = channel.keyFrame->getVersion();
+}
+
+void AnimationBinding::bakeRotation(SceneNode* node)
+{
+    // axes without a channel keep the node's current rotation
+    auto euler = node->rot.toEulerAngles();
+    float angles[3] = {euler.x(), euler.y(), euler.z()};
+
+    QQuaternion previous;
+    for (int i = 0; i < sampleCount; i++) {
+        for (const auto& channel : channels) {
+            if (channel.column == rotationColumn)
+                angles[channel.slot - eulerRotation] = channel.keyFrame->getValueAt(i / bakeRate);
+        }
+
+        auto rot = QQuaternion::fromEulerAngles(angles[0], angles[1], angles[2]);
+        if (i > 0 && QQuaternion::dotProduct(rot, previous) < 0)
+            rot = -rot;
+        previous = rot;
+
+        auto sample = bakedSamples.data() + i * rowSize + rotationColumn;
+        sample[0] = rot.scalar();
+        sample[1] = rot.x();
+        sample[2] = rot.y();
+        sample[3] = rot.z();
+    }
+
+    for (auto& channel : channels) {
+        if (channel.column == rotationColumn)
+            channel.bakedVersion = channel.keyFrame->getVersion();
+    }
+}
+
+void AnimationBinding::updateBake(SceneNode* node)
+{
+    bool rotationChanged = false;
+    for (int i = 0; i < channels.size(); i++) {
+        auto& channel = channels[i];
+        if (channel.bakedVersion == channel.keyFrame->getVersion())
+            continue;
+
+        // a key moved past the end of the samples, every channel needs more of them
+        auto& keys = channel.keyFrame->keys;
+        if (!keys.empty() && keys.back().time * bakeRate > sampleCount - 1) {
+            bake(node, bakeRate);
+            return;
+        }
+
+        if (channel.column == rotationColumn)
+            rotationChanged = true;
+        else
+            bakeChannel(i);
+    }
+
+    // the rotation channels share a quaternion, so they're resampled together
+    if (rotationChanged)
+        bakeRotation(node);
+}
+
+}
@@ -0,0 +1,141 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef ANIMATIONBINDING_H
+#define ANIMATIONBINDING_H
+
+#include <QVector>
+#include <QWeakPointer>
+
+namespace iris
+{
+
+class SceneNode;
+class KeyFrameSet;
+class FloatKeyFrame;
+
+/**
+ * Node property an animation channel writes to
+ */
+enum class AnimationTarget
+{
+    TranslationX,
+    TranslationY,
+    TranslationZ,
+    RotationX,
+    RotationY,
+    RotationZ,
+    ScaleX,
+    ScaleY,
+    ScaleZ
+};
+
+struct AnimationChannel
+{
+    AnimationTarget target;
+    FloatKeyFrame* keyFrame;
+    // the float the evaluated value is written to
+    float* slot;
+    // where the channel's baked samples are in a row, rotation channels share the quaternion's column
+    int column;
+    // keyframe version the channel's baked samples were taken from
+    int bakedVersion;
+};
+
+/**
+ * A node's keyframe set resolved to the channels that are animated, so playback
+ * doesnt look up keyframes by name every frame.
+ *
+ * Unless the binding is baked, rotation channels are written to euler angles that are
+ * converted to the node's rotation once per frame. The binding is compiled again when
+ * the set is replaced or its version changes. The set is held weakly so a new set
+ * allocated where a freed one was is never mistaken for it.
+ *
+ * The channels can also be baked: sampled at a fixed rate into one row of floats per
+ * sample, so playback reads two rows and blends them instead of searching each curve.
+ * A row has a float for each translation and scale channel, then the node's final
+ * rotation as a quaternion that's nlerped, so baked playback does no euler conversion.
+ * Rotation axes without a channel keep the values they had when the rotation was baked.
+ * A channel whose keys were edited is sampled again on the next apply.
+ */
+class AnimationBinding
+{
+public:
+    AnimationBinding();
+
+    /**
+     * Returns true if the binding was compiled from keyFrameSet and no keyframes were added to
+     * or replaced in it since
+     */
+    bool isCompiledFrom(const QSharedPointer<KeyFrameSet>& keyFrameSet) const;
+
+    void compile(SceneNode* node, const QSharedPointer<KeyFrameSet>& keyFrameSet);
+
+    /**
+     * Evaluates the animated channels at time and writes them to the node
+     */
+    void apply(SceneNode* node, float time);
+
+    bool isAnimated() const
+    {
+        return !channels.isEmpty();
+    }
+
+    /**
+     * Samples every channel rate times per second, up to its last key.
+     * Compiling the binding again drops the samples.
+     */
+    void bake(SceneNode* node, float rate);
+    void clearBake();
+
+    bool isBaked() const
+    {
+        return bakeRate > 0;
+    }
+
+    /**
+     * Returns the size of the baked samples in bytes
+     */
+    int getBakedSize() const
+    {
+        return bakedSamples.size() * sizeof(float);
+    }
+
+private:
+    // samples a translation or scale channel into its column of bakedSamples
+    void bakeChannel(int index);
+    // samples the rotation channels into the quaternion at rotationColumn
+    void bakeRotation(SceneNode* node);
+    // resamples the channels whose keys changed since they were baked
+    void updateBake(SceneNode* node);
+
+    QVector<AnimationChannel> channels;
+
+    // samples per second, 0 if the binding isnt baked
+    float bakeRate;
+    int sampleCount;
+    // sampleCount rows of rowSize floats
+    QVector<float> bakedSamples;
+    int rowSize;
+    // column of the rotation quaternion, stored scalar first, -1 if nothing rotates
+    int rotationColumn;
+
+    QWeakPointer<KeyFrameSet> source;
+    int sourceVersion;
+
+    // rotation channels write here
+    float eulerRotation[3];
+    int rotationChannelCount;
+};
+
+}
+
+#endif // ANIMATIONBINDING_H
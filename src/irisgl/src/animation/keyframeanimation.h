@@ -19,6 +19,9 @@ For more information see the LICENSE file
 #include <QQuaternion>
 #include <QColor>
 
+#include <algorithm>
+#include <vector>
+
 namespace iris
 {
 
@@ -54,31 +57,41 @@ public:
     }
 };
 
-template <typename T> bool KeyCompare(const Key<T> * const & a, const Key<T> * const & b)
-{
-   return a->time < b->time;
-}
-
+/**
+ * Animation curve. Keys are stored by value and always sorted by time, so a key is
+ * found with a binary search. The key last found is remembered, so evaluating the
+ * curve at increasing times, as playback does, usually doesnt search at all.
+ */
 template<typename T>
 class KeyFrame
 {
 public:
     QString name;
-    std::vector<Key<T>*> keys;
+    // sorted by time, use addKey and setKeyTime to keep them sorted
+    std::vector<Key<T>> keys;
     float length;//in seconds
 
     KeyFrame()
     {
         length = 15;//for now
+        cursor = 0;
+        version = 0;
     }
 
     void clear()
     {
-        for (size_t i=0;i<keys.size();i++)
-        {
-            delete keys[i];
-        }
         keys.clear();
+        cursor = 0;
+        version++;
+    }
+
+    /**
+     * Returns a number that changes whenever keys are added, moved or removed.
+     * Used to find out when data derived from the curve, such as baked samples, is out of date.
+     */
+    int getVersion() const
+    {
+        return version;
     }
 
     float getLength()
@@ -96,22 +109,44 @@ public:
         if(keys.size()==0)
             return;
 
-        //sort keys
-        this->sortKeys();
         //get last key and use that to determine length
-        auto last = keys.end().c;
-        length = last->time;
+        length = keys.back().time;
     }
 
-    void addKey(T value,double time)
+    /**
+     * Inserts a key at its place in time. Keys with the same time stay in insertion order.
+     * @return index of the new key
+     */
+    int addKey(T value,double time)
     {
-        auto key = new Key<T>();
-        key->value = value;
-        key->time = time;
-        keys.push_back(key);
+        Key<T> key;
+        key.value = value;
+        key.time = time;
+        key.leftTangent = TangentType::Linear;
+        key.rightTangent = TangentType::Linear;
 
-        //todo: make this faster
-        this->sortKeys();
+        auto iter = std::upper_bound(keys.begin(), keys.end(), time, compareTimeToKey);
+        iter = keys.insert(iter, key);
+        version++;
+
+        return (int)(iter - keys.begin());
+    }
+
+    /**
+     * Changes the time of the key at index and moves it so the keys stay sorted.
+     * @return the key's new index
+     */
+    int setKeyTime(int index,double time)
+    {
+        Key<T> key = keys[index];
+        key.time = time;
+        keys.erase(keys.begin() + index);
+
+        auto iter = std::upper_bound(keys.begin(), keys.end(), time, compareTimeToKey);
+        iter = keys.insert(iter, key);
+        version++;
+
+        return (int)(iter - keys.begin());
     }
 
     bool hasKeys()
@@ -166,65 +201,87 @@ public:
 
         if(numKeys==1)
         {
-            *firstKey = keys[0];
+            *firstKey = &keys[0];
             return;
         }
 
         //before first key
         //todo: wrap around
-        if(time<=keys[0]->time)
+        if(time<=keys[0].time)
         {
-            *firstKey = keys[0];
+            *firstKey = &keys[0];
             return;
         }
 
         //after last key
         //todo: wrap around
-        if(time>=keys[numKeys-1]->time)
+        if(time>=keys[numKeys-1].time)
         {
-            *firstKey = keys[numKeys-1];
+            *firstKey = &keys[numKeys-1];
             return;
         }
 
-        //find first key and last key
-        for(size_t k = 0;k<keys.size();k++)
-        {
-            Key<T>* key = keys[k];
-
-            if(key->time<=time)
-                *firstKey = key;
-            else
-            {
-                *lastKey = key;
-                break;
-            }
-        }
-
+        int index = findKey(time);
+        *firstKey = &keys[index];
+        *lastKey = &keys[index+1];
     }
 
     void sortKeys()
     {
-        std::sort(keys.begin(),keys.end(),KeyCompare<T>);
+        std::stable_sort(keys.begin(),keys.end(),compareKeys);
+        version++;
     }
 
     double getFirstKeyTime()
     {
         Q_ASSERT(keys.size()>0);
 
-        return keys.begin().time;
+        return keys.front().time;
     }
 
     double getLastKeyTime()
     {
         Q_ASSERT(keys.size()>0);
 
-        return keys.end().time;
+        return keys.back().time;
     }
 
     virtual ~KeyFrame()
     {
-        for(auto iter = keys.begin();iter!=keys.end();iter++)
-            delete *iter;
+    }
+
+private:
+    // index of the key last found by findKey
+    int cursor;
+    int version;
+
+    static bool compareTimeToKey(double time,const Key<T>& key)
+    {
+        return time < key.time;
+    }
+
+    static bool compareKeys(const Key<T>& a,const Key<T>& b)
+    {
+        return a.time < b.time;
+    }
+
+    // returns the index of the last key at or before time
+    // time must be after the first key and before the last one
+    int findKey(double time)
+    {
+        int numKeys = keys.size();
+
+        // playback mostly stays between the same two keys or moves on to the next ones
+        for (int i = cursor; i < cursor + 2 && i < numKeys - 1; i++) {
+            if (keys[i].time <= time && time < keys[i+1].time) {
+                cursor = i;
+                return i;
+            }
+        }
+
+        auto iter = std::upper_bound(keys.begin(), keys.end(), time, compareTimeToKey);
+        cursor = (int)(iter - keys.begin()) - 1;
+        return cursor;
     }
 
 protected:
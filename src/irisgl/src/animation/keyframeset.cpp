@@ -15,6 +15,11 @@ For more information see the LICENSE file
 namespace iris
 {
 
+KeyFrameSet::KeyFrameSet()
+{
+    version = 0;
+}
+
 FloatKeyFrame* KeyFrameSet::getOrCreateFrame(QString name)
 {
     if(keyFrames.contains(name))
@@ -24,9 +29,16 @@ FloatKeyFrame* KeyFrameSet::getOrCreateFrame(QString name)
 
     auto keyFrame = new FloatKeyFrame();
     keyFrames.insert(name,keyFrame);
+    version++;
     return keyFrame;
 }
 
+void KeyFrameSet::insertKeyFrame(QString name, FloatKeyFrame* frame)
+{
+    keyFrames.insert(name,frame);
+    version++;
+}
+
 FloatKeyFrame* KeyFrameSet::getKeyFrame(QString name)
 {
     if(keyFrames.contains(name))
@@ -27,15 +27,35 @@ class KeyFrameSet
 {
 public:
     //QMap presrves insertion order,QHash doesnt
+    //add frames through getOrCreateFrame or insertKeyFrame so the version changes
     QMap<QString,FloatKeyFrame*> keyFrames;
 
+    KeyFrameSet();
+
     FloatKeyFrame* getOrCreateFrame(QString name);
 
+    /**
+     * Adds frame under name, replacing the frame already there
+     */
+    void insertKeyFrame(QString name, FloatKeyFrame* frame);
+
     FloatKeyFrame* getKeyFrame(QString name);
 
     bool hasKeyFrame(QString name);
 
+    /**
+     * Returns a number that changes whenever a keyframe is added or replaced.
+     * Used to find out when bindings to the keyframes are out of date.
+     */
+    int getVersion() const
+    {
+        return version;
+    }
+
     static QSharedPointer<KeyFrameSet> create();
+
+private:
+    int version;
 };
 
 }
@@ -0,0 +1,114 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "jobsystem.h"
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+namespace iris
+{
+
+namespace
+{
+
+// takes indices until none are left then signals that it's done
+class IndexJob : public QRunnable
+{
+public:
+    IndexJob(const std::function<void(int)>& job, QAtomicInt& nextIndex, int count, QSemaphore& done) :
+        job(job),
+        nextIndex(nextIndex),
+        count(count),
+        done(done)
+    {
+    }
+
+    void run() override
+    {
+        runIndices(job, nextIndex, count);
+        done.release();
+    }
+
+    static void runIndices(const std::function<void(int)>& job, QAtomicInt& nextIndex, int count)
+    {
+        int index;
+        while ((index = nextIndex.fetchAndAddOrdered(1)) < count)
+            job(index);
+    }
+
+private:
+    const std::function<void(int)>& job;
+    QAtomicInt& nextIndex;
+    int count;
+    QSemaphore& done;
+};
+
+}
+
+void JobSystem::parallelFor(int count, const std::function<void(int)>& job)
+{
+    if (count <= 0)
+        return;
+
+    // the calling thread is one of the workers
+    int helperCount = qMin(getWorkerCount(), count) - 1;
+    if (helperCount <= 0) {
+        for (int i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+
+    QAtomicInt nextIndex(0);
+    QSemaphore done;
+
+    auto pool = getThreadPool();
+    for (int i = 0; i < helperCount; i++)
+        pool->start(new IndexJob(job, nextIndex, count, done));
+
+    IndexJob::runIndices(job, nextIndex, count);
+
+    // the locals are referenced by the helpers until they finish
+    done.acquire(helperCount);
+}
+
+int JobSystem::getWorkerCount()
+{
+    if (workerCount <= 0)
+        workerCount = qMax(QThread::idealThreadCount(), 1);
+
+    return workerCount;
+}
+
+void JobSystem::setWorkerCount(int count)
+{
+    workerCount = qMax(count, 1);
+    getThreadPool()->setMaxThreadCount(qMax(workerCount - 1, 1));
+}
+
+QThreadPool* JobSystem::getThreadPool()
+{
+    // separate from the global pool so long running tasks there cant starve the jobs
+    static QThreadPool* pool = nullptr;
+    if (pool == nullptr) {
+        pool = new QThreadPool();
+        pool->setMaxThreadCount(qMax(getWorkerCount() - 1, 1));
+    }
+
+    return pool;
+}
+
+int JobSystem::workerCount = 0;
+
+}
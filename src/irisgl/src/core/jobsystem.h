@@ -0,0 +1,55 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <functional>
+
+class QThreadPool;
+
+namespace iris
+{
+
+/**
+ * Runs independent jobs on a pool of worker threads.
+ * Jobs must not touch gl or the gui, they should only work on their own data.
+ */
+class JobSystem
+{
+public:
+    /**
+     * Calls job(i) for every i in [0, count) spread over the workers and returns
+     * once all of them are done. The calling thread runs jobs too.
+     * Jobs are handed out one index at a time so uneven jobs still balance.
+     */
+    static void parallelFor(int count, const std::function<void(int)>& job);
+
+    /**
+     * Returns the number of threads parallelFor uses, including the calling thread
+     */
+    static int getWorkerCount();
+
+    /**
+     * Limits the threads parallelFor uses. 1 runs every job on the calling thread.
+     * Defaults to the number of cores.
+     */
+    static void setWorkerCount(int count);
+
+private:
+    static QThreadPool* getThreadPool();
+
+    static int workerCount;
+};
+
+}
+
+#endif // JOBSYSTEM_H
@@ -0,0 +1,219 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "meshmanager.h"
+#include "../graphics/mesh.h"
+#include "../graphics/meshcooker.h"
+
+#include "assimp/postprocess.h"
+#include "assimp/Importer.hpp"
+#include "assimp/scene.h"
+#include "assimp/mesh.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+
+namespace iris
+{
+
+Mesh* MeshManager::getMesh(const QString& path, int index)
+{
+    requests++;
+
+    auto key = getKey(path);
+    if (files.contains(key)) {
+        cacheHits++;
+        return getMeshAt(key, index);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // cooked files skip assimp entirely
+    QList<Mesh*> cookedMeshes;
+    if (!key.startsWith(":") && MeshCooker::load(key, cookedMeshes)) {
+        for (auto mesh : cookedMeshes) {
+            if (mesh != nullptr)
+                refCounts.insert(mesh, 0);
+        }
+
+        files.insert(key, cookedMeshes);
+        cookedLoads++;
+        cookedLoadTime += timer.elapsed();
+    } else {
+        Assimp::Importer importer;
+        const aiScene *scene;
+
+        if (key.startsWith(":")) {
+            // loads mesh from resource
+            QFile file(key);
+            file.open(QIODevice::ReadOnly);
+            auto data = file.readAll();
+            scene = importer.ReadFileFromMemory((void*)data.data(),
+                                                data.length(),
+                                                aiProcessPreset_TargetRealtime_Fast);
+        } else {
+            scene = importer.ReadFile(path.toStdString().c_str(),
+                                      aiProcessPreset_TargetRealtime_Fast);
+        }
+
+        fileImports++;
+        addMeshes(path, scene);
+        importTime += timer.elapsed();
+    }
+
+    return getMeshAt(key, index);
+}
+
+Mesh* MeshManager::getMeshAt(const QString& key, int index)
+{
+    const auto& meshes = files[key];
+    if (index < 0 || index >= meshes.size())
+        return nullptr;
+
+    return meshes[index];
+}
+
+void MeshManager::addMeshes(const QString& path, const aiScene* scene)
+{
+    auto key = getKey(path);
+    if (files.contains(key))
+        return;
+
+    // failed imports are cached as empty too so they arent retried every request
+    QList<Mesh*> meshes;
+
+    if (scene) {
+        for (unsigned i = 0; i < scene->mNumMeshes; i++) {
+            // objects like Bezier curves have no vertex positions in the aiMesh
+            // the slot is kept so the other meshes keep their indices
+            Mesh* mesh = nullptr;
+            if (scene->mMeshes[i]->HasPositions()) {
+                mesh = new Mesh(scene->mMeshes[i]);
+                refCounts.insert(mesh, 0);
+            }
+
+            meshes.append(mesh);
+        }
+    }
+
+    files.insert(key, meshes);
+
+    // the next load of the file reads the cooked meshes instead of importing it
+    if (!key.startsWith(":"))
+        MeshCooker::save(key, scene);
+}
+
+void MeshManager::retain(Mesh* mesh)
+{
+    auto iter = refCounts.find(mesh);
+    if (iter != refCounts.end())
+        iter.value()++;
+}
+
+void MeshManager::release(Mesh* mesh)
+{
+    auto iter = refCounts.find(mesh);
+    if (iter != refCounts.end() && iter.value() > 0)
+        iter.value()--;
+}
+
+bool MeshManager::isManaged(Mesh* mesh)
+{
+    return refCounts.contains(mesh);
+}
+
+void MeshManager::purgeUnused()
+{
+    for (auto iter = files.begin(); iter != files.end();) {
+        bool isUsed = false;
+        for (auto mesh : iter.value()) {
+            if (mesh != nullptr && refCounts[mesh] > 0) {
+                isUsed = true;
+                break;
+            }
+        }
+
+        if (isUsed) {
+            ++iter;
+            continue;
+        }
+
+        for (auto mesh : iter.value()) {
+            if (mesh != nullptr) {
+                refCounts.remove(mesh);
+                delete mesh;
+            }
+        }
+
+        iter = files.erase(iter);
+    }
+}
+
+MeshManagerStats MeshManager::getStats()
+{
+    MeshManagerStats stats;
+    stats.meshCount = refCounts.size();
+    stats.requests = requests;
+    stats.cacheHits = cacheHits;
+    stats.fileImports = fileImports;
+    stats.cookedLoads = cookedLoads;
+    stats.importTime = importTime;
+    stats.cookedLoadTime = cookedLoadTime;
+    stats.residentBytes = 0;
+    stats.bytesSaved = 0;
+    stats.vertexCount = 0;
+    stats.gpuBytes = 0;
+    stats.unpackedGpuBytes = 0;
+
+    for (auto iter = refCounts.constBegin(); iter != refCounts.constEnd(); ++iter) {
+        auto mesh = iter.key();
+        stats.vertexCount += mesh->vertexCount;
+        stats.gpuBytes += mesh->gpuMemorySize;
+        stats.unpackedGpuBytes += mesh->unpackedMemorySize;
+
+        qint64 size = mesh->getMemorySize();
+        stats.residentBytes += size;
+
+        if (iter.value() > 1)
+            stats.bytesSaved += size * (iter.value() - 1);
+    }
+
+    return stats;
+}
+
+QString MeshManager::getKey(const QString& path)
+{
+    // ":/app/x.obj", ":app/x.obj" and "qrc:/app/x.obj" are the same resource
+    if (path.startsWith(":") || path.startsWith("qrc:")) {
+        auto resource = path.mid(path.startsWith(":") ? 1 : 4);
+        while (resource.startsWith('/'))
+            resource.remove(0, 1);
+
+        return ":/" + QDir::cleanPath(resource);
+    }
+
+    return QFileInfo(path).absoluteFilePath();
+}
+
+QHash<QString, QList<Mesh*>> MeshManager::files;
+QHash<Mesh*, int> MeshManager::refCounts;
+
+int MeshManager::requests = 0;
+int MeshManager::cacheHits = 0;
+int MeshManager::fileImports = 0;
+int MeshManager::cookedLoads = 0;
+qint64 MeshManager::importTime = 0;
+qint64 MeshManager::cookedLoadTime = 0;
+
+}
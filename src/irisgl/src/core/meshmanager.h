@@ -12,11 +12,110 @@ For more information see the LICENSE file
 #ifndef MESHMANAGER_H
 #define MESHMANAGER_H
 
+#include <QHash>
+#include <QList>
+#include <QString>
 
+struct aiScene;
+
+namespace iris
+{
+
+class Mesh;
+
+struct MeshManagerStats
+{
+    // meshes currently held by the manager
+    int meshCount;
+    // getMesh calls
+    int requests;
+    // getMesh calls served without importing the file
+    int cacheHits;
+    // files run through assimp
+    int fileImports;
+    // files loaded from their cooked mesh file
+    int cookedLoads;
+
+    // milliseconds spent importing and cooking files, and loading cooked files
+    // dividing each by its count compares the two paths
+    qint64 importTime;
+    qint64 cookedLoadTime;
+
+    // gpu buffers and picking data of the held meshes
+    qint64 residentBytes;
+    // memory the extra references would have used if each had loaded its own copy
+    qint64 bytesSaved;
+
+    // vertices of the held meshes
+    qint64 vertexCount;
+    // vertex and index buffer bytes of the held meshes, packed and as they would be unpacked
+    // divided by vertexCount they give the bytes per vertex with and without packing
+    qint64 gpuBytes;
+    qint64 unpackedGpuBytes;
+};
+
+/**
+ * Shares meshes between the nodes that use the same file.
+ * Meshes are keyed by file path and mesh index, so loading a file a second time,
+ * duplicating a node or adding another primitive reuses the gpu buffers and
+ * picking triangles of the first load.
+ *
+ * Meshes are reference counted by their users through retain() and release(). A
+ * mesh whose count drops to zero stays cached so it can be reused, purgeUnused()
+ * frees files none of whose meshes are referenced.
+ * Meshes that werent created by the manager are ignored by retain() and release().
+ * Model files are cooked by MeshCooker on their first import and later loads read
+ * the cooked file instead.
+ * Must be used from the thread with the current gl context.
+ */
 class MeshManager
 {
 public:
-    void AddMesh();
+    /**
+     * Returns the mesh at index in the file at path, importing the file the first time.
+     * Resource paths (starting with ':') are supported.
+     * The reference count isnt changed, users should retain the mesh they keep.
+     * @return the mesh or nullptr if the file doesnt have a mesh with positions at index
+     */
+    static Mesh* getMesh(const QString& path, int index = 0);
+
+    /**
+     * Creates meshes from a scene that was already imported so getMesh doesnt import
+     * it again and cooks them. Does nothing if the path is already loaded.
+     */
+    static void addMeshes(const QString& path, const aiScene* scene);
+
+    static void retain(Mesh* mesh);
+    static void release(Mesh* mesh);
+
+    /**
+     * Returns true if mesh was created by the manager
+     */
+    static bool isManaged(Mesh* mesh);
+
+    /**
+     * Deletes the meshes of every file whose meshes have no references
+     */
+    static void purgeUnused();
+
+    static MeshManagerStats getStats();
+
+private:
+    static QString getKey(const QString& path);
+    static Mesh* getMeshAt(const QString& key, int index);
+
+    // meshes of each loaded file, by mesh index
+    static QHash<QString, QList<Mesh*>> files;
+    static QHash<Mesh*, int> refCounts;
+
+    static int requests;
+    static int cacheHits;
+    static int fileImports;
+    static int cookedLoads;
+    static qint64 importTime;
+    static qint64 cookedLoadTime;
 };
 
+}
+
 #endif // MESHMANAGER_H
@@ -15,12 +15,17 @@ For more information see the LICENSE file
 #include "../scenegraph/cameranode.h"
 #include "../scenegraph/viewernode.h"
 #include "../scenegraph/meshnode.h"
+#include "../scenegraph/particlesystemnode.h"
 #include "../graphics/mesh.h"
+#include "transformsystem.h"
 #include "../graphics/renderitem.h"
 #include "../materials/defaultskymaterial.h"
 #include "../geometry/trimesh.h"
+#include "../geometry/aabbtree.h"
 #include "irisutils.h"
 
+#include <QElapsedTimer>
+
 namespace iris
 {
 
@@ -49,6 +54,7 @@ Scene::Scene()
     skyRenderItem->material = skyMaterial;
     skyRenderItem->type = RenderItemType::Mesh;
     skyRenderItem->renderLayer = (int)RenderLayer::Background;
+    skyRenderItem->cullable = false;
 
     fogColor = QColor(250, 250, 250);
     fogStart = 100;
@@ -60,6 +66,28 @@ Scene::Scene()
     //reserve 1000 items initially
     geometryRenderList.reserve(1000);
     shadowRenderList.reserve(1000);
+
+    spatialIndex = new AABBTree();
+    transformSystem = nullptr;
+}
+
+Scene::~Scene()
+{
+    delete spatialIndex;
+    delete transformSystem;
+}
+
+void Scene::setTransformSystemEnabled(bool enabled)
+{
+    if (enabled == (transformSystem != nullptr))
+        return;
+
+    if (enabled) {
+        transformSystem = new TransformSystem(rootNode.data());
+    } else {
+        delete transformSystem;
+        transformSystem = nullptr;
+    }
 }
 
 void Scene::setSkyTexture(Texture2DPtr tex)
@@ -90,15 +118,36 @@ void Scene::setAmbientColor(QColor color)
     this->ambientColor = color;
 }
 
+void Scene::bakeAnimations(float rate)
+{
+    animationStats.bakeRate = qMax(rate, 0.0f);
+    animationStats.bakedSize = rootNode->bakeAnimation(animationStats.bakeRate);
+}
+
 void Scene::updateSceneAnimation(float time)
 {
+    QElapsedTimer timer;
+    timer.start();
+
     rootNode->updateAnimation(time);
+
+    if (animationStats.bakeRate > 0) {
+        animationStats.bakedUpdateTime = timer.nsecsElapsed() / 1000;
+    } else {
+        animationStats.curveUpdateTime = timer.nsecsElapsed() / 1000;
+    }
 }
 
 void Scene::update(float dt)
 {
+    if (transformSystem != nullptr)
+        transformSystem->update();
+
+    updatedParticleSystems.clear();
     rootNode->update(dt);
 
+    ParticleSystemNode::simulateParticles(updatedParticleSystems, dt);
+
     // cameras aren't always be a part of the scene hierarchy, so their matrices are updated here
     if (!!camera) {
         camera->update(dt);
@@ -117,7 +166,86 @@ void Scene::rayCast(const QVector3D& segStart,
                     const QVector3D& segEnd,
                     QList<PickingResult>& hitList)
 {
-    rayCast(rootNode, segStart, segEnd, hitList);
+    QElapsedTimer timer;
+    timer.start();
+
+    lastRayCastStats = RayCastStats();
+    lastRayCastStats.treeNodesVisited = spatialIndex->rayCast(segStart, segEnd, [&](int proxyId, float maxT) {
+        auto meshNode = static_cast<MeshNode*>(spatialIndex->getUserData(proxyId));
+        if (!meshNode->isPickable())
+            return maxT;
+
+        lastRayCastStats.meshesTested++;
+        auto triMesh = meshNode->getMesh()->getTriMesh();
+
+        // transform segment to local space
+        auto invTransform = meshNode->globalTransform.inverted();
+        auto a = invTransform * segStart;
+        auto b = invTransform * segEnd;
+
+        QList<iris::TriangleIntersectionResult> results;
+        if (triMesh->getSegmentIntersections(a, b, results)) {
+            auto hitNode = meshNode->sharedFromThis();
+            for (const auto& triResult : results) {
+                // convert hit to world space
+                auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
+
+                PickingResult pick;
+                pick.hitNode = hitNode;
+                pick.hitPoint = hitPoint;
+                pick.distanceFromStartSqrd = (hitPoint - segStart).lengthSquared();
+
+                hitList.append(pick);
+            }
+        }
+
+        return maxT;
+    });
+
+    lastRayCastStats.queryTimeMs = timer.nsecsElapsed() / 1000000.0f;
+}
+
+bool Scene::rayCastClosest(const QVector3D& segStart,
+                           const QVector3D& segEnd,
+                           PickingResult& result)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool hit = false;
+
+    lastRayCastStats = RayCastStats();
+    lastRayCastStats.treeNodesVisited = spatialIndex->rayCast(segStart, segEnd, [&](int proxyId, float maxT) {
+        auto meshNode = static_cast<MeshNode*>(spatialIndex->getUserData(proxyId));
+        if (!meshNode->isPickable())
+            return maxT;
+
+        lastRayCastStats.meshesTested++;
+        auto triMesh = meshNode->getMesh()->getTriMesh();
+
+        // transform the segment to local space, cut short at the closest hit so far
+        // t along the local segment maps to the same t along the world segment
+        auto invTransform = meshNode->globalTransform.inverted();
+        auto a = invTransform * segStart;
+        auto b = invTransform * (segStart + (segEnd - segStart) * maxT);
+
+        iris::TriangleIntersectionResult triResult;
+        if (!triMesh->getClosestSegmentIntersection(a, b, triResult))
+            return maxT;
+
+        auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
+
+        result.hitNode = meshNode->sharedFromThis();
+        result.hitPoint = hitPoint;
+        result.distanceFromStartSqrd = (hitPoint - segStart).lengthSquared();
+        hit = true;
+
+        return triResult.t * maxT;
+    });
+
+    lastRayCastStats.queryTimeMs = timer.nsecsElapsed() / 1000000.0f;
+
+    return hit;
 }
 
 void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
@@ -163,6 +291,9 @@ void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
 
 void Scene::addNode(SceneNodePtr node)
 {
+    if (transformSystem != nullptr)
+        transformSystem->invalidate();
+
     if (node->sceneNodeType == SceneNodeType::Light) {
         auto light = node.staticCast<iris::LightNode>();
         lights.append(light);
@@ -185,11 +316,55 @@ void Scene::removeNode(SceneNodePtr node)
         vrViewer.reset();
     }
 
+    if (node->sceneNodeType == SceneNodeType::Mesh) {
+        removeFromSpatialIndex(node.staticCast<iris::MeshNode>().data());
+    }
+
+    // the node updates its own transforms until it's added back
+    node->transformHandle = -1;
+    if (transformSystem != nullptr)
+        transformSystem->invalidate();
+
     for (auto& child : node->children) {
         removeNode(child);
     }
 }
 
+void Scene::updateSpatialIndex(MeshNode* node)
+{
+    auto mesh = node->getMesh();
+    if (mesh == nullptr || mesh->getTriMesh() == nullptr || mesh->getTriMesh()->bounds.isEmpty()) {
+        removeFromSpatialIndex(node);
+        return;
+    }
+
+    // nothing to do if the node hasnt moved since its bounds were last updated
+    if (node->spatialProxyId != -1 &&
+        node->spatialProxyMesh == mesh &&
+        node->spatialProxyTransformVersion == node->getTransformVersion())
+        return;
+
+    auto bounds = mesh->getTriMesh()->bounds.transformed(node->globalTransform);
+    if (node->spatialProxyId == -1) {
+        node->spatialProxyId = spatialIndex->createProxy(bounds, node);
+    } else {
+        spatialIndex->moveProxy(node->spatialProxyId, bounds);
+    }
+
+    node->spatialProxyMesh = mesh;
+    node->spatialProxyTransformVersion = node->getTransformVersion();
+}
+
+void Scene::removeFromSpatialIndex(MeshNode* node)
+{
+    if (node->spatialProxyId == -1)
+        return;
+
+    spatialIndex->destroyProxy(node->spatialProxyId);
+    node->spatialProxyId = -1;
+    node->spatialProxyMesh = nullptr;
+}
+
 void Scene::setCamera(CameraNodePtr cameraNode)
 {
     camera = cameraNode;
@@ -21,6 +21,8 @@ namespace iris
 {
 
 class RenderItem;
+class AABBTree;
+class TransformSystem;
 
 enum class SceneRenderFlags : int
 {
@@ -35,6 +37,51 @@ struct PickingResult
     float distanceFromStartSqrd;
 };
 
+/**
+ * Counters from the last ray cast against the scene's spatial index
+ */
+struct RayCastStats
+{
+    // tree nodes whose bounds were tested against the segment
+    int treeNodesVisited;
+
+    // meshes whose triangles were tested
+    int meshesTested;
+
+    float queryTimeMs;
+
+    RayCastStats()
+    {
+        treeNodesVisited = 0;
+        meshesTested = 0;
+        queryTimeMs = 0;
+    }
+};
+
+/**
+ * Memory and time the scene's animations take, to weigh baking against evaluating the curves
+ */
+struct AnimationStats
+{
+    // samples per second animations are baked at, 0 if they arent baked
+    float bakeRate;
+
+    // size of the baked samples in bytes
+    int bakedSize;
+
+    // microseconds the last animation update took with baked samples and with the curves
+    qint64 bakedUpdateTime;
+    qint64 curveUpdateTime;
+
+    AnimationStats()
+    {
+        bakeRate = 0;
+        bakedSize = 0;
+        bakedUpdateTime = 0;
+        curveUpdateTime = 0;
+    }
+};
+
 class Scene: public QEnableSharedFromThis<Scene>
 {
 public:
@@ -67,6 +114,27 @@ public:
     QVector<RenderItem*> geometryRenderList;
     QVector<RenderItem*> shadowRenderList;
 
+    /*
+     * Particle systems updated this frame. They are simulated together on the
+     * job system once the scene graph has been updated.
+     */
+    QVector<ParticleSystemNode*> updatedParticleSystems;
+
+    /*
+     * World space bounds of every mesh node in the scene. Used to skip
+     * meshes a ray cast cant possibly hit.
+     */
+    AABBTree* spatialIndex;
+    RayCastStats lastRayCastStats;
+
+    AnimationStats animationStats;
+
+    /*
+     * Updates the world transforms of the nodes in flat arrays across threads.
+     * Null unless enabled with setTransformSystemEnabled.
+     */
+    TransformSystem* transformSystem;
+
     /*
      * customizations that can be passed in and applied to a scene. ideally these
      * should or can be GLOBAL but a scene is the highest prioritized obj atm...
@@ -78,6 +146,8 @@ public:
 
     Scene();
 public:
+    ~Scene();
+
     static ScenePtr create();
 
     /**
@@ -99,14 +169,51 @@ public:
     void setSkyColor(QColor color);
     void setAmbientColor(QColor color);
 
+    /**
+     * Switches between updating node transforms with a flattened transform system that
+     * runs on the job system and the recursive update of the scene graph.
+     * The transform system pays off for scenes with many nodes.
+     */
+    void setTransformSystemEnabled(bool enabled);
+
+    TransformSystem* getTransformSystem() {
+        return transformSystem;
+    }
+
+    /**
+     * Samples the animations of every node rate times per second so playback blends
+     * samples instead of evaluating curves. A rate of 0 drops the samples.
+     */
+    void bakeAnimations(float rate);
+
+    const AnimationStats& getAnimationStats() const {
+        return animationStats;
+    }
+
     void updateSceneAnimation(float time);
     void update(float dt);
     void render();
 
+    /**
+     * Finds every pickable mesh hit by the segment. Only meshes whose bounds
+     * intersect the segment are tested.
+     */
     void rayCast(const QVector3D& segStart,
                  const QVector3D& segEnd,
                  QList<PickingResult>& hitList);
 
+    /**
+     * Finds the pickable mesh hit closest to segStart. The segment is shortened
+     * each time a hit is found so meshes behind it are skipped.
+     * Returns false if nothing was hit
+     */
+    bool rayCastClosest(const QVector3D& segStart,
+                        const QVector3D& segEnd,
+                        PickingResult& result);
+
+    /**
+     * Brute-force ray cast of a node and all its children. Doesnt use the spatial index.
+     */
     void rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
                  const QVector3D& segStart,
                  const QVector3D& segEnd,
@@ -124,6 +231,14 @@ public:
      */
     void removeNode(SceneNodePtr node);
 
+    /**
+     * Adds the mesh node's world space bounds to the spatial index or updates them if
+     * the node's transform or mesh has changed. Called from MeshNode::update.
+     * @param node
+     */
+    void updateSpatialIndex(MeshNode* node);
+    void removeFromSpatialIndex(MeshNode* node);
+
     /**
      * Sets the active camera of the scene
      * @param cameraNode
@@ -38,6 +38,12 @@ SceneNode::SceneNode():
     localTransform.setToIdentity();
     globalTransform.setToIdentity();
 
+    localTransformDirty = true;
+    transformVersion = nextTransformVersion++;
+    parentTransformVersion = 0;
+    transformHandle = -1;
+    animationBakeRate = 0;
+
     //keyFrameSet = KeyFrameSet::create();
     animation = iris::Animation::create();
 }
@@ -117,6 +123,7 @@ void SceneNode::removeChild(SceneNodePtr node)
 {
     children.removeOne(node);
     node->parent = QSharedPointer<SceneNode>(nullptr);
+    node->markTransformDirty();
     node->setScene(QSharedPointer<Scene>(nullptr));
     scene->removeNode(node);
 }
@@ -131,53 +138,52 @@ bool SceneNode::isRootNode()
 
 void SceneNode::updateAnimation(float time)
 {
-    //@todo: cache transformation animations for faster lookup
+    // compiled again if the animation was replaced or its keyframes were
     auto keyFrameSet = animation->keyFrameSet;
+    if (!animationBinding.isCompiledFrom(keyFrameSet)) {
+        animationBinding.compile(this, keyFrameSet);
+        if (animationBakeRate > 0)
+            animationBinding.bake(this, animationBakeRate);
+    }
 
-    if(keyFrameSet->hasKeyFrame("Translation X"))
-        pos.setX(keyFrameSet->getKeyFrame("Translation X")->getValueAt(time));
-    if(keyFrameSet->hasKeyFrame("Translation Y"))
-        pos.setY(keyFrameSet->getKeyFrame("Translation Y")->getValueAt(time));
-    if(keyFrameSet->hasKeyFrame("Translation Z"))
-        pos.setZ(keyFrameSet->getKeyFrame("Translation Z")->getValueAt(time));
-
-    auto rotEuler = rot.toEulerAngles();
-    if(keyFrameSet->hasKeyFrame("Rotation X"))
-        rotEuler.setX(keyFrameSet->getKeyFrame("Rotation X")->getValueAt(time));
-    if(keyFrameSet->hasKeyFrame("Rotation Y"))
-        rotEuler.setY(keyFrameSet->getKeyFrame("Rotation Y")->getValueAt(time));
-    if(keyFrameSet->hasKeyFrame("Rotation Z"))
-        rotEuler.setZ(keyFrameSet->getKeyFrame("Rotation Z")->getValueAt(time));
-    rot = QQuaternion::fromEulerAngles(rotEuler);
-
-    if(keyFrameSet->hasKeyFrame("Scale X"))
-        scale.setX(keyFrameSet->getKeyFrame("Scale X")->getValueAt(time));
-    if(keyFrameSet->hasKeyFrame("Scale Y"))
-        scale.setY(keyFrameSet->getKeyFrame("Scale Y")->getValueAt(time));
-    if(keyFrameSet->hasKeyFrame("Scale Z"))
-        scale.setZ(keyFrameSet->getKeyFrame("Scale Z")->getValueAt(time));
+    animationBinding.apply(this, time);
 
     //update children
-    for (auto child : children) {
+    for (auto& child : children) {
         child->updateAnimation(time);
     }
 }
 
-void SceneNode::update(float dt)
+int SceneNode::bakeAnimation(float rate)
 {
-    localTransform.setToIdentity();
+    animationBakeRate = rate;
 
-    localTransform.translate(pos);
-    localTransform.rotate(rot);
-    localTransform.scale(scale);
+    auto keyFrameSet = animation->keyFrameSet;
+    if (!animationBinding.isCompiledFrom(keyFrameSet))
+        animationBinding.compile(this, keyFrameSet);
 
-    if (!!parent) {
-        globalTransform = this->parent->globalTransform * localTransform;
+    if (rate > 0) {
+        animationBinding.bake(this, rate);
     } else {
-        globalTransform = localTransform;
+        animationBinding.clearBake();
+    }
+
+    int size = animationBinding.getBakedSize();
+    for (auto& child : children) {
+        size += child->bakeAnimation(rate);
     }
 
-    for (auto child : children) {
+    return size;
+}
+
+void SceneNode::update(float dt)
+{
+    // the parent was updated before its children
+    // nodes in a transform system were already updated by it
+    if (transformHandle == -1)
+        updateGlobalTransform();
+
+    for (auto& child : children) {
         child->update(dt);
     }
 
@@ -188,6 +194,46 @@ void SceneNode::update(float dt)
 void SceneNode::setParent(SceneNodePtr node)
 {
     this->parent = node;
+    localTransformDirty = true;
+}
+
+bool SceneNode::updateLocalTransform()
+{
+    if (!localTransformDirty && pos == cachedPos && rot == cachedRot && scale == cachedScale)
+        return false;
+
+    localTransform.setToIdentity();
+
+    localTransform.translate(pos);
+    localTransform.rotate(rot);
+    localTransform.scale(scale);
+
+    cachedPos = pos;
+    cachedRot = rot;
+    cachedScale = scale;
+    localTransformDirty = false;
+
+    return true;
+}
+
+void SceneNode::updateGlobalTransform()
+{
+    bool changed = updateLocalTransform();
+
+    if (!!parent) {
+        if (!changed && parentTransformVersion == parent->transformVersion)
+            return;
+
+        globalTransform = parent->globalTransform * localTransform;
+        parentTransformVersion = parent->transformVersion;
+    } else {
+        if (!changed)
+            return;
+
+        globalTransform = localTransform;
+    }
+
+    transformVersion = nextTransformVersion++;
 }
 
 void SceneNode::setScene(ScenePtr scene)
@@ -219,29 +265,18 @@ QVector3D SceneNode::getGlobalPosition()
 
 QMatrix4x4 SceneNode::getGlobalTransform()
 {
-    localTransform.setToIdentity();
+    // only the ancestors that changed since the last update are rebuilt
+    if (!parent.isNull())
+        parent->getGlobalTransform();
 
-    localTransform.translate(pos);
-    localTransform.rotate(rot);
-    localTransform.scale(scale);
-
-    if (parent.isNull()) {
-        // this is a check for the root node
-        globalTransform = localTransform;
-    } else {
-        globalTransform = parent->getGlobalTransform() * localTransform;
-    }
+    updateGlobalTransform();
 
     return globalTransform;
 }
 
 QMatrix4x4 SceneNode::getLocalTransform()
 {
-    localTransform.setToIdentity();
-
-    localTransform.translate(pos);
-    localTransform.rotate(rot);
-    localTransform.scale(scale);
+    updateLocalTransform();
 
     return localTransform;
 }
@@ -270,5 +305,6 @@ SceneNodePtr SceneNode::duplicate()
 }
 
 long SceneNode::nextId = 0;
+quint64 SceneNode::nextTransformVersion = 1;
 
 }
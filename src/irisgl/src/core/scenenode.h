@@ -16,6 +16,7 @@ For more information see the LICENSE file
 #include <QQuaternion>
 #include <QMatrix4x4>
 #include <QVector3D>
+#include "../animation/animationbinding.h"
 
 namespace iris
 {
@@ -36,6 +37,7 @@ class SceneNode : public QEnableSharedFromThis<SceneNode>
 {
 public:
     // cached local and global transform
+    // they are only rebuilt when pos, rot, scale or one of the ancestors changes
     QMatrix4x4 localTransform;
     QMatrix4x4 globalTransform;
 
@@ -53,6 +55,10 @@ public:
     QList<SceneNodePtr> children;
 
     AnimationPtr animation;
+    // animation's keyframes resolved for playback, compiled on first use
+    AnimationBinding animationBinding;
+    // samples per second of the baked animation, 0 if it isnt baked
+    float animationBakeRate;
 
     // editor specific
     bool duplicable;
@@ -64,6 +70,7 @@ public:
 
     friend class Renderer;
     friend class Scene;
+    friend class TransformSystem;
 
 public:
     SceneNode();
@@ -139,6 +146,29 @@ public:
     QMatrix4x4 getGlobalTransform();
     QMatrix4x4 getLocalTransform();
 
+    /**
+     * Forces the transforms of this node and its descendants to be rebuilt on the next update.
+     * Changes to pos, rot and scale are detected without this.
+     */
+    void markTransformDirty() {
+        localTransformDirty = true;
+    }
+
+    /**
+     * Returns a number that changes whenever globalTransform changes.
+     * Used to skip work that depends on a node's world transform, such as updating its bounds.
+     */
+    quint64 getTransformVersion() const {
+        return transformVersion;
+    }
+
+    /**
+     * Returns the node's index in its scene's transform system, -1 if it isnt in one
+     */
+    int getTransformHandle() const {
+        return transformHandle;
+    }
+
     /*
      * This function does multiple things:
      * - Calculates the transformation of the objects
@@ -147,6 +177,14 @@ public:
     virtual void update(float dt);
     virtual void updateAnimation(float time);
 
+    /**
+     * Samples the animations of this node and its descendants rate times per second
+     * so playback blends samples instead of evaluating curves. Edited keys are
+     * sampled again when they're next played. A rate of 0 goes back to evaluating the curves.
+     * @return size of the samples in bytes
+     */
+    int bakeAnimation(float rate);
+
     /*
      * This is the function used to add render items
      * to the render queues
@@ -158,8 +196,28 @@ private:
     void setParent(SceneNodePtr node);
     void setScene(ScenePtr scene);
 
+    // rebuilds localTransform if pos, rot or scale changed, returns true if it did
+    bool updateLocalTransform();
+    // rebuilds globalTransform if the local transform or the parent's global transform changed
+    // the parent's global transform must be up to date
+    void updateGlobalTransform();
+
     static long generateNodeId();
     static long nextId;
+
+    // values localTransform was last built from
+    QVector3D cachedPos;
+    QVector3D cachedScale;
+    QQuaternion cachedRot;
+    bool localTransformDirty;
+
+    quint64 transformVersion;
+    // parent's transform version when globalTransform was last built
+    quint64 parentTransformVersion;
+    static quint64 nextTransformVersion;
+
+    // index in the scene's transform system, -1 if the node updates its own transforms
+    int transformHandle;
 };
 
 
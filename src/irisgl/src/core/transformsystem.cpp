@@ -0,0 +1,170 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "transformsystem.h"
+#include "scenenode.h"
+#include "jobsystem.h"
+
+#include <QElapsedTimer>
+
+namespace iris
+{
+
+TransformSystem::TransformSystem(SceneNode* rootNode) :
+    rootNode(rootNode),
+    orderDirty(true)
+{
+    stats.nodeCount = 0;
+    stats.nodesChanged = 0;
+    stats.jobCount = 0;
+    stats.rebuilds = 0;
+    stats.updateTime = 0;
+}
+
+TransformSystem::~TransformSystem()
+{
+    // nodes go back to updating their own transforms
+    clearTransformHandles(rootNode);
+}
+
+void TransformSystem::clearTransformHandles(SceneNode* node)
+{
+    node->transformHandle = -1;
+    for (auto& child : node->children)
+        clearTransformHandles(child.data());
+}
+
+void TransformSystem::update()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (orderDirty)
+        rebuild();
+
+    int count = nodes.size();
+    if (count == 0)
+        return;
+
+    // versions are handed out up front so the jobs dont share a counter
+    quint64 baseVersion = SceneNode::nextTransformVersion;
+    SceneNode::nextTransformVersion += count;
+
+    for (auto index : serialNodes)
+        updateRange(index, index + 1, baseVersion);
+
+    JobSystem::parallelFor(ranges.size(), [&](int i) {
+        updateRange(ranges[i].begin, ranges[i].end, baseVersion);
+    });
+
+    int nodesChanged = 0;
+    for (auto c : changed)
+        nodesChanged += c;
+
+    stats.nodeCount = count;
+    stats.nodesChanged = nodesChanged;
+    stats.jobCount = serialNodes.size() + ranges.size();
+    stats.updateTime = timer.nsecsElapsed() / 1000;
+}
+
+void TransformSystem::rebuild()
+{
+    nodes.clear();
+    parents.clear();
+    subtreeSizes.clear();
+    worldTransforms.clear();
+    versions.clear();
+
+    addNode(rootNode, -1);
+    changed.fill(0, nodes.size());
+
+    // several ranges per worker so uneven subtrees still balance
+    int rangeSize = qMax(nodes.size() / (JobSystem::getWorkerCount() * 4), 1024);
+    serialNodes.clear();
+    ranges.clear();
+    buildRanges(0, rangeSize);
+
+    orderDirty = false;
+    stats.rebuilds++;
+}
+
+void TransformSystem::addNode(SceneNode* node, int parentIndex)
+{
+    int index = nodes.size();
+    node->transformHandle = index;
+
+    // the nodes' current transforms are kept, nodes that are out of date are
+    // found by their versions in the next update
+    nodes.append(node);
+    parents.append(parentIndex);
+    subtreeSizes.append(1);
+    worldTransforms.append(node->globalTransform);
+    versions.append(node->transformVersion);
+
+    for (auto& child : node->children)
+        addNode(child.data(), index);
+
+    subtreeSizes[index] = nodes.size() - index;
+}
+
+void TransformSystem::buildRanges(int index, int rangeSize)
+{
+    int size = subtreeSizes[index];
+
+    if (size <= rangeSize) {
+        // neighbouring subtrees are merged while the range stays small
+        if (!ranges.isEmpty()) {
+            auto& last = ranges.last();
+            if (last.end == index && last.end - last.begin + size <= rangeSize) {
+                last.end = index + size;
+                return;
+            }
+        }
+
+        ranges.append({index, index + size});
+        return;
+    }
+
+    // too big for one range, this node is updated on its own and its children are split
+    serialNodes.append(index);
+    for (int child = index + 1; child < index + size; child += subtreeSizes[child])
+        buildRanges(child, rangeSize);
+}
+
+void TransformSystem::updateRange(int begin, int end, quint64 baseVersion)
+{
+    for (int i = begin; i < end; i++) {
+        auto node = nodes[i];
+        int parent = parents[i];
+
+        bool dirty = node->updateLocalTransform();
+        // the node was updated outside of the system, by getGlobalTransform() for instance
+        dirty |= node->transformVersion != versions[i];
+        if (parent != -1)
+            dirty |= changed[parent] || node->parentTransformVersion != versions[parent];
+
+        changed[i] = dirty;
+        if (!dirty)
+            continue;
+
+        if (parent != -1) {
+            worldTransforms[i] = worldTransforms[parent] * node->localTransform;
+            node->parentTransformVersion = versions[parent];
+        } else {
+            worldTransforms[i] = node->localTransform;
+        }
+
+        node->globalTransform = worldTransforms[i];
+        node->transformVersion = versions[i] = baseVersion + i;
+    }
+}
+
+}
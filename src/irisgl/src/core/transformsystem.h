@@ -0,0 +1,123 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TRANSFORMSYSTEM_H
+#define TRANSFORMSYSTEM_H
+
+#include <QMatrix4x4>
+#include <QVector>
+
+namespace iris
+{
+
+class SceneNode;
+
+struct TransformSystemStats
+{
+    // nodes in the hierarchy
+    int nodeCount;
+    // nodes whose world transform changed in the last update
+    int nodesChanged;
+    // subtree ranges the last update was split into
+    int jobCount;
+    // times the flattened order was rebuilt because the hierarchy changed
+    int rebuilds;
+    // microseconds spent in the last update
+    qint64 updateTime;
+};
+
+/**
+ * Keeps the world transforms of a scene's nodes in flat arrays ordered parent before
+ * child, the order of a depth-first walk. Each subtree is then a contiguous range, so
+ * updating is a linear pass and separate subtrees are updated on the job system.
+ *
+ * Nodes hold the index of their entry as their transform handle. The order is rebuilt
+ * lazily after nodes are added or removed. Nodes still own pos, rot, scale and their
+ * local transform; the update reads them and writes the world transforms back to the
+ * nodes' globalTransform. pos, rot and scale are public members the editor writes to
+ * directly, so every update has to read them from the nodes anyway, and keeping copies
+ * of the local transforms in the arrays as well didnt make it faster.
+ */
+class TransformSystem
+{
+public:
+    TransformSystem(SceneNode* rootNode);
+    ~TransformSystem();
+
+    /**
+     * Marks the order as out of date. Called when nodes are added or removed.
+     */
+    void invalidate()
+    {
+        orderDirty = true;
+    }
+
+    /**
+     * Updates the world transform of every node whose local transform or
+     * one of its ancestors' changed.
+     */
+    void update();
+
+    const QMatrix4x4& getWorldTransform(int handle) const
+    {
+        return worldTransforms[handle];
+    }
+
+    int getNodeCount() const
+    {
+        return nodes.size();
+    }
+
+    const TransformSystemStats& getStats() const
+    {
+        return stats;
+    }
+
+private:
+    void rebuild();
+    // a member so it can reach the nodes' private transform handles
+    static void clearTransformHandles(SceneNode* node);
+    void addNode(SceneNode* node, int parentIndex);
+
+    // splits the hierarchy into contiguous ranges of about rangeSize nodes
+    // nodes above ranges that are too big are put in serialNodes and updated first
+    void buildRanges(int index, int rangeSize);
+
+    // updates nodes [begin, end), their parents must be up to date
+    void updateRange(int begin, int end, quint64 baseVersion);
+
+    SceneNode* rootNode;
+    bool orderDirty;
+
+    QVector<SceneNode*> nodes;
+    QVector<int> parents;
+    QVector<int> subtreeSizes;
+    QVector<QMatrix4x4> worldTransforms;
+    // node transform versions the world transforms were last written with
+    QVector<quint64> versions;
+    // whether the node's world transform changed in the current update
+    QVector<quint8> changed;
+
+    struct Range
+    {
+        int begin;
+        int end;
+    };
+
+    QVector<int> serialNodes;
+    QVector<Range> ranges;
+
+    TransformSystemStats stats;
+};
+
+}
+
+#endif // TRANSFORMSYSTEM_H
@@ -0,0 +1,401 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "aabbtree.h"
+
+#include <QVarLengthArray>
+#include <QPair>
+
+namespace iris
+{
+
+namespace
+{
+
+// padding added to proxy bounds, relative to the size of the bounds
+const float FAT_BOUNDS_SCALE = 0.1f;
+const float FAT_BOUNDS_MIN_MARGIN = 0.01f;
+
+// proxies whose padded box has become this much bigger than needed get reinserted
+// otherwise objects that shrink would keep their old box
+const float FAT_BOUNDS_MAX_AREA_RATIO = 4.0f;
+
+}
+
+AABBTree::AABBTree()
+{
+    root = -1;
+    freeList = -1;
+    proxyCount = 0;
+}
+
+void AABBTree::clear()
+{
+    nodes.clear();
+    root = -1;
+    freeList = -1;
+    proxyCount = 0;
+}
+
+int AABBTree::allocateNode()
+{
+    int nodeId;
+    if (freeList == -1) {
+        nodeId = nodes.size();
+        nodes.append(AABBTreeNode());
+    } else {
+        nodeId = freeList;
+        freeList = nodes[nodeId].next;
+    }
+
+    auto& node = nodes[nodeId];
+    node.bounds.clear();
+    node.userData = nullptr;
+    node.parent = -1;
+    node.left = -1;
+    node.right = -1;
+    node.next = -1;
+    node.height = 0;
+
+    return nodeId;
+}
+
+void AABBTree::freeNode(int nodeId)
+{
+    nodes[nodeId].next = freeList;
+    nodes[nodeId].height = -1;
+    freeList = nodeId;
+}
+
+BoundingBox AABBTree::fattenBounds(const BoundingBox& bounds) const
+{
+    auto size = bounds.getSize();
+    float extent = std::max(size.x(), std::max(size.y(), size.z()));
+    float margin = std::max(extent * FAT_BOUNDS_SCALE, FAT_BOUNDS_MIN_MARGIN);
+    auto pad = QVector3D(margin, margin, margin);
+
+    return BoundingBox(bounds.minPos - pad, bounds.maxPos + pad);
+}
+
+int AABBTree::createProxy(const BoundingBox& bounds, void* userData)
+{
+    int proxyId = allocateNode();
+    nodes[proxyId].bounds = fattenBounds(bounds);
+    nodes[proxyId].userData = userData;
+
+    insertLeaf(proxyId);
+    proxyCount++;
+
+    return proxyId;
+}
+
+void AABBTree::destroyProxy(int proxyId)
+{
+    Q_ASSERT(nodes[proxyId].isLeaf());
+
+    removeLeaf(proxyId);
+    freeNode(proxyId);
+    proxyCount--;
+}
+
+bool AABBTree::moveProxy(int proxyId, const BoundingBox& bounds)
+{
+    Q_ASSERT(nodes[proxyId].isLeaf());
+
+    auto fatBounds = fattenBounds(bounds);
+    const auto& currentBounds = nodes[proxyId].bounds;
+
+    if (currentBounds.contains(bounds) &&
+        currentBounds.getSurfaceArea() <= fatBounds.getSurfaceArea() * FAT_BOUNDS_MAX_AREA_RATIO)
+        return false;
+
+    removeLeaf(proxyId);
+    nodes[proxyId].bounds = fatBounds;
+    insertLeaf(proxyId);
+
+    return true;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+    if (root == -1) {
+        root = leaf;
+        nodes[root].parent = -1;
+        return;
+    }
+
+    // find the best sibling by walking down the side that grows the least
+    auto leafBounds = nodes[leaf].bounds;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        int left = nodes[index].left;
+        int right = nodes[index].right;
+
+        float area = nodes[index].bounds.getSurfaceArea();
+        float combinedArea = BoundingBox::merged(nodes[index].bounds, leafBounds).getSurfaceArea();
+
+        // cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+
+        // minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float leftArea = BoundingBox::merged(nodes[left].bounds, leafBounds).getSurfaceArea();
+        float leftCost = nodes[left].isLeaf() ?
+                         leftArea + inheritanceCost :
+                         leftArea - nodes[left].bounds.getSurfaceArea() + inheritanceCost;
+
+        float rightArea = BoundingBox::merged(nodes[right].bounds, leafBounds).getSurfaceArea();
+        float rightCost = nodes[right].isLeaf() ?
+                          rightArea + inheritanceCost :
+                          rightArea - nodes[right].bounds.getSurfaceArea() + inheritanceCost;
+
+        if (cost < leftCost && cost < rightCost)
+            break;
+
+        index = leftCost < rightCost ? left : right;
+    }
+
+    int sibling = index;
+
+    // allocateNode can resize the node list so no references are held across it
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].bounds = BoundingBox::merged(leafBounds, nodes[sibling].bounds);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].left = sibling;
+    nodes[newParent].right = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != -1) {
+        if (nodes[oldParent].left == sibling)
+            nodes[oldParent].left = newParent;
+        else
+            nodes[oldParent].right = newParent;
+    } else {
+        root = newParent;
+    }
+
+    // refit the ancestors
+    index = nodes[leaf].parent;
+    while (index != -1) {
+        index = balance(index);
+
+        int left = nodes[index].left;
+        int right = nodes[index].right;
+
+        nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+        nodes[index].bounds = BoundingBox::merged(nodes[left].bounds, nodes[right].bounds);
+
+        index = nodes[index].parent;
+    }
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    if (grandParent == -1) {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        freeNode(parent);
+        return;
+    }
+
+    // the sibling takes the parent's place
+    if (nodes[grandParent].left == parent)
+        nodes[grandParent].left = sibling;
+    else
+        nodes[grandParent].right = sibling;
+
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    int index = grandParent;
+    while (index != -1) {
+        index = balance(index);
+
+        int left = nodes[index].left;
+        int right = nodes[index].right;
+
+        nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+        nodes[index].bounds = BoundingBox::merged(nodes[left].bounds, nodes[right].bounds);
+
+        index = nodes[index].parent;
+    }
+}
+
+/**
+ * Rotates the subtree at iA if one side is more than one level taller than the other
+ * Returns the index of the subtree's new root
+ */
+int AABBTree::balance(int iA)
+{
+    if (nodes[iA].isLeaf() || nodes[iA].height < 2)
+        return iA;
+
+    int iB = nodes[iA].left;
+    int iC = nodes[iA].right;
+
+    int diff = nodes[iC].height - nodes[iB].height;
+
+    // rotate C up
+    if (diff > 1) {
+        int iF = nodes[iC].left;
+        int iG = nodes[iC].right;
+
+        nodes[iC].left = iA;
+        nodes[iC].parent = nodes[iA].parent;
+        nodes[iA].parent = iC;
+
+        if (nodes[iC].parent != -1) {
+            if (nodes[nodes[iC].parent].left == iA)
+                nodes[nodes[iC].parent].left = iC;
+            else
+                nodes[nodes[iC].parent].right = iC;
+        } else {
+            root = iC;
+        }
+
+        // the taller of C's children stays with C
+        if (nodes[iF].height > nodes[iG].height) {
+            nodes[iC].right = iF;
+            nodes[iA].right = iG;
+            nodes[iG].parent = iA;
+            nodes[iA].bounds = BoundingBox::merged(nodes[iB].bounds, nodes[iG].bounds);
+            nodes[iC].bounds = BoundingBox::merged(nodes[iA].bounds, nodes[iF].bounds);
+            nodes[iA].height = 1 + std::max(nodes[iB].height, nodes[iG].height);
+            nodes[iC].height = 1 + std::max(nodes[iA].height, nodes[iF].height);
+        } else {
+            nodes[iC].right = iG;
+            nodes[iA].right = iF;
+            nodes[iF].parent = iA;
+            nodes[iA].bounds = BoundingBox::merged(nodes[iB].bounds, nodes[iF].bounds);
+            nodes[iC].bounds = BoundingBox::merged(nodes[iA].bounds, nodes[iG].bounds);
+            nodes[iA].height = 1 + std::max(nodes[iB].height, nodes[iF].height);
+            nodes[iC].height = 1 + std::max(nodes[iA].height, nodes[iG].height);
+        }
+
+        return iC;
+    }
+
+    // rotate B up
+    if (diff < -1) {
+        int iD = nodes[iB].left;
+        int iE = nodes[iB].right;
+
+        nodes[iB].left = iA;
+        nodes[iB].parent = nodes[iA].parent;
+        nodes[iA].parent = iB;
+
+        if (nodes[iB].parent != -1) {
+            if (nodes[nodes[iB].parent].left == iA)
+                nodes[nodes[iB].parent].left = iB;
+            else
+                nodes[nodes[iB].parent].right = iB;
+        } else {
+            root = iB;
+        }
+
+        if (nodes[iD].height > nodes[iE].height) {
+            nodes[iB].right = iD;
+            nodes[iA].left = iE;
+            nodes[iE].parent = iA;
+            nodes[iA].bounds = BoundingBox::merged(nodes[iC].bounds, nodes[iE].bounds);
+            nodes[iB].bounds = BoundingBox::merged(nodes[iA].bounds, nodes[iD].bounds);
+            nodes[iA].height = 1 + std::max(nodes[iC].height, nodes[iE].height);
+            nodes[iB].height = 1 + std::max(nodes[iA].height, nodes[iD].height);
+        } else {
+            nodes[iB].right = iE;
+            nodes[iA].left = iD;
+            nodes[iD].parent = iA;
+            nodes[iA].bounds = BoundingBox::merged(nodes[iC].bounds, nodes[iD].bounds);
+            nodes[iB].bounds = BoundingBox::merged(nodes[iA].bounds, nodes[iE].bounds);
+            nodes[iA].height = 1 + std::max(nodes[iC].height, nodes[iD].height);
+            nodes[iB].height = 1 + std::max(nodes[iA].height, nodes[iE].height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+int AABBTree::getHeight() const
+{
+    if (root == -1) return 0;
+    return nodes[root].height;
+}
+
+int AABBTree::rayCast(const QVector3D& segStart, const QVector3D& segEnd, const RayCastCallback& callback) const
+{
+    if (root == -1) return 0;
+
+    auto dir = segEnd - segStart;
+    auto invDir = QVector3D(1.0f / dir.x(), 1.0f / dir.y(), 1.0f / dir.z());
+    float maxT = 1.0f;
+    int visited = 1;
+
+    float tEntry;
+    if (!nodes[root].bounds.intersectsSegment(segStart, invDir, 0.0f, maxT, tEntry))
+        return visited;
+
+    // node and the distance the segment enters it
+    QVarLengthArray<QPair<int, float>, 64> stack;
+    stack.append(qMakePair(root, tEntry));
+
+    while (!stack.isEmpty()) {
+        auto entry = stack.last();
+        stack.removeLast();
+
+        // a closer hit was found after this node was pushed
+        if (entry.second > maxT) continue;
+
+        const auto& node = nodes[entry.first];
+        if (node.isLeaf()) {
+            maxT = std::min(maxT, callback(entry.first, maxT));
+            continue;
+        }
+
+        float leftT, rightT;
+        bool hitLeft = nodes[node.left].bounds.intersectsSegment(segStart, invDir, 0.0f, maxT, leftT);
+        bool hitRight = nodes[node.right].bounds.intersectsSegment(segStart, invDir, 0.0f, maxT, rightT);
+        visited += 2;
+
+        // push the farther child first so the nearer one is visited next
+        if (hitLeft && hitRight) {
+            if (leftT < rightT) {
+                stack.append(qMakePair(node.right, rightT));
+                stack.append(qMakePair(node.left, leftT));
+            } else {
+                stack.append(qMakePair(node.left, leftT));
+                stack.append(qMakePair(node.right, rightT));
+            }
+        } else if (hitLeft) {
+            stack.append(qMakePair(node.left, leftT));
+        } else if (hitRight) {
+            stack.append(qMakePair(node.right, rightT));
+        }
+    }
+
+    return visited;
+}
+
+}
@@ -0,0 +1,116 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef AABBTREE_H
+#define AABBTREE_H
+
+#include <QVector>
+#include <QVector3D>
+#include <functional>
+#include "boundingbox.h"
+
+namespace iris
+{
+
+struct AABBTreeNode
+{
+    // fattened bounds for leaves, union of the children for interior nodes
+    BoundingBox bounds;
+    void* userData;
+
+    int parent;
+    int left;
+    int right;
+
+    // next node in the free list
+    int next;
+
+    // leaves have a height of 0, free nodes -1
+    int height;
+
+    bool isLeaf() const
+    {
+        return left == -1;
+    }
+};
+
+/**
+ * Dynamic bounding volume tree over world space boxes. Each object gets a leaf (proxy)
+ * whose box is padded a bit, so small movements dont touch the tree at all.
+ * When an object leaves its padded box its leaf is removed and reinserted and the
+ * tree is rebalanced with rotations on the way back up.
+ * Based on the dynamic tree from Box2D.
+ */
+class AABBTree
+{
+public:
+    /**
+     * Called for every leaf whose box is hit by the segment. maxT is the
+     * distance along the segment, in the range 0 and 1, past which hits are ignored.
+     * Returning a smaller value than maxT clips the segment, return maxT to keep going.
+     */
+    typedef std::function<float(int proxyId, float maxT)> RayCastCallback;
+
+    AABBTree();
+
+    int createProxy(const BoundingBox& bounds, void* userData);
+    void destroyProxy(int proxyId);
+
+    /**
+     * Updates the bounds of a proxy
+     * Returns true if the proxy had to be reinserted
+     */
+    bool moveProxy(int proxyId, const BoundingBox& bounds);
+
+    void* getUserData(int proxyId) const
+    {
+        return nodes[proxyId].userData;
+    }
+
+    const BoundingBox& getFatBounds(int proxyId) const
+    {
+        return nodes[proxyId].bounds;
+    }
+
+    /**
+     * Walks the tree front to back along the segment
+     * Returns the number of tree nodes visited
+     */
+    int rayCast(const QVector3D& segStart, const QVector3D& segEnd, const RayCastCallback& callback) const;
+
+    int getProxyCount() const
+    {
+        return proxyCount;
+    }
+
+    int getHeight() const;
+
+    void clear();
+
+private:
+    int allocateNode();
+    void freeNode(int nodeId);
+
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int nodeId);
+
+    BoundingBox fattenBounds(const BoundingBox& bounds) const;
+
+    QVector<AABBTreeNode> nodes;
+    int root;
+    int freeList;
+    int proxyCount;
+};
+
+}
+
+#endif // AABBTREE_H
@@ -0,0 +1,182 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef BOUNDINGBOX_H
+#define BOUNDINGBOX_H
+
+#include <QVector3D>
+#include <QMatrix4x4>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+namespace iris
+{
+
+/**
+ * Axis-aligned bounding box. A default constructed box is empty (min > max)
+ * so merging the first point or box into it gives that point or box.
+ */
+struct BoundingBox
+{
+    QVector3D minPos;
+    QVector3D maxPos;
+
+    BoundingBox()
+    {
+        clear();
+    }
+
+    BoundingBox(const QVector3D& minPos, const QVector3D& maxPos):
+        minPos(minPos),
+        maxPos(maxPos)
+    {
+    }
+
+    void clear()
+    {
+        const float inf = std::numeric_limits<float>::max();
+        minPos = QVector3D(inf, inf, inf);
+        maxPos = QVector3D(-inf, -inf, -inf);
+    }
+
+    bool isEmpty() const
+    {
+        return minPos.x() > maxPos.x() ||
+               minPos.y() > maxPos.y() ||
+               minPos.z() > maxPos.z();
+    }
+
+    void merge(const QVector3D& point)
+    {
+        minPos.setX(std::min(minPos.x(), point.x()));
+        minPos.setY(std::min(minPos.y(), point.y()));
+        minPos.setZ(std::min(minPos.z(), point.z()));
+
+        maxPos.setX(std::max(maxPos.x(), point.x()));
+        maxPos.setY(std::max(maxPos.y(), point.y()));
+        maxPos.setZ(std::max(maxPos.z(), point.z()));
+    }
+
+    void merge(const BoundingBox& box)
+    {
+        if (box.isEmpty()) return;
+
+        merge(box.minPos);
+        merge(box.maxPos);
+    }
+
+    bool contains(const BoundingBox& box) const
+    {
+        return minPos.x() <= box.minPos.x() && box.maxPos.x() <= maxPos.x() &&
+               minPos.y() <= box.minPos.y() && box.maxPos.y() <= maxPos.y() &&
+               minPos.z() <= box.minPos.z() && box.maxPos.z() <= maxPos.z();
+    }
+
+    static BoundingBox merged(const BoundingBox& a, const BoundingBox& b)
+    {
+        BoundingBox box = a;
+        box.merge(b);
+        return box;
+    }
+
+    /**
+     * Returns the box enclosing this box after it's transformed by matrix.
+     * Uses the center-extents form so only the absolute values of the
+     * rotation/scale part are needed instead of transforming all 8 corners.
+     */
+    BoundingBox transformed(const QMatrix4x4& matrix) const
+    {
+        if (isEmpty()) return *this;
+
+        auto center = matrix * getCenter();
+        auto extents = getSize() * 0.5f;
+
+        QVector3D newExtents;
+        for (int row = 0; row < 3; row++) {
+            newExtents[row] = std::abs(matrix(row, 0)) * extents.x() +
+                              std::abs(matrix(row, 1)) * extents.y() +
+                              std::abs(matrix(row, 2)) * extents.z();
+        }
+
+        return BoundingBox(center - newExtents, center + newExtents);
+    }
+
+    QVector3D getCenter() const
+    {
+        return (minPos + maxPos) * 0.5f;
+    }
+
+    QVector3D getSize() const
+    {
+        return maxPos - minPos;
+    }
+
+    /**
+     * Returns the surface area of the box. Used as the cost metric when building
+     * bounding volume hierarchies (SAH).
+     */
+    float getSurfaceArea() const
+    {
+        if (isEmpty()) return 0.0f;
+
+        auto size = getSize();
+        return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+    }
+
+    /**
+     * Grows the box by a small amount relative to its size. This keeps flat boxes
+     * (axis-aligned triangles) from being missed by the slab test due to rounding.
+     */
+    void inflate(float relativeAmount = 1e-5f, float minAmount = 1e-6f)
+    {
+        if (isEmpty()) return;
+
+        auto size = getSize();
+        float extent = std::max(size.x(), std::max(size.y(), size.z()));
+        float amount = std::max(extent * relativeAmount, minAmount);
+        auto pad = QVector3D(amount, amount, amount);
+
+        minPos -= pad;
+        maxPos += pad;
+    }
+
+    /**
+     * Slab test of the segment origin + dir * t for t in [tMin, tMax]
+     * invDir is the component-wise reciprocal of the segment's direction
+     * Returns the parametric distance the segment enters the box in tEntry
+     */
+    bool intersectsSegment(const QVector3D& origin,
+                           const QVector3D& invDir,
+                           float tMin,
+                           float tMax,
+                           float& tEntry) const
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            float t0 = (minPos[axis] - origin[axis]) * invDir[axis];
+            float t1 = (maxPos[axis] - origin[axis]) * invDir[axis];
+            if (t0 > t1) std::swap(t0, t1);
+
+            // written so NaNs (0 * inf) leave the interval unchanged
+            tMin = t0 > tMin ? t0 : tMin;
+            tMax = t1 < tMax ? t1 : tMax;
+
+            if (tMin > tMax) return false;
+        }
+
+        tEntry = tMin;
+        return true;
+    }
+};
+
+}
+
+#endif // BOUNDINGBOX_H
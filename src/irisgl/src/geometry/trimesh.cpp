@@ -10,10 +10,21 @@ For more information see the LICENSE file
 *************************************************************************/
 
 #include "trimesh.h"
+#include "trimeshbvh.h"
 
 namespace iris
 {
 
+TriMesh::TriMesh()
+{
+    bvh = nullptr;
+}
+
+TriMesh::~TriMesh()
+{
+    delete bvh;
+}
+
 /**
  * Adds points for triangle. Assumes points are in a counter-clockwise rotation.
  * @param a
@@ -25,49 +36,76 @@ void TriMesh::addTriangle(const QVector3D& a,const QVector3D& b,const QVector3D&
     Triangle tri = {a,b,c,QVector3D::crossProduct(b-a,c-a)};
 
     triangles.append(tri);
+
+    bounds.merge(a);
+    bounds.merge(b);
+    bounds.merge(c);
+
+    invalidateBVH();
+}
+
+TriMeshBVH* TriMesh::getBVH()
+{
+    if (bvh == nullptr) {
+        bvh = TriMeshBVH::build(this);
+    }
+
+    return bvh;
+}
+
+void TriMesh::invalidateBVH()
+{
+    delete bvh;
+    bvh = nullptr;
 }
 
 //https://github.com/qt/qt3d/blob/5476bc6b4b6a12c921da502c24c4e078b04dd3b3/src/render/jobs/pickboundingvolumejob.cpp
 //realtime rendering page 192
-//no need to get uvw, just return true at the first sign of a hit
-bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segmentEnd,QVector3D& hitPoint)
+bool TriMesh::intersectSegmentTriangle(const QVector3D& a, const QVector3D& b, const QVector3D& c,
+                                       const QVector3D& segmentStart, const QVector3D& segmentEnd,
+                                       float& t)
 {
-    for(auto tri:triangles)
-    {
-        auto ab = tri.b - tri.a;
-        auto ac = tri.c - tri.a;
-        auto qp = segmentStart-segmentEnd;
+    auto ab = b - a;
+    auto ac = c - a;
+    auto qp = segmentStart - segmentEnd;
 
-        //auto normal = tri.normal;
-        auto normal = QVector3D::crossProduct(ab, ac);
-        float d = QVector3D::dotProduct(qp, normal);
+    auto normal = QVector3D::crossProduct(ab, ac);
+    float d = QVector3D::dotProduct(qp, normal);
 
-        //if (d <= 0)
-        //    continue;
-        if (d == 0) continue;
+    // segment is parallel to or hits the back of the triangle
+    if (d <= 0)
+        return false;
 
-        auto ap = segmentStart - tri.a;
-        auto t = QVector3D::dotProduct(ap, normal);
+    auto ap = segmentStart - a;
+    t = QVector3D::dotProduct(ap, normal);
 
-        if (t < 0 || t > d)
-            continue;
+    if (t < 0 || t > d)
+        return false;
 
-        auto e = QVector3D::crossProduct(qp, ap);
-        auto v = QVector3D::dotProduct(ac, e);
+    auto e = QVector3D::crossProduct(qp, ap);
+    auto v = QVector3D::dotProduct(ac, e);
 
-        if (v < 0.0f || v > d)
-            continue;
+    if (v < 0.0f || v > d)
+        return false;
 
-        auto w = -QVector3D::dotProduct(ab, e);
+    auto w = -QVector3D::dotProduct(ab, e);
 
-        if (w < 0.0f || v + w > d)
-            continue;
+    if (w < 0.0f || v + w > d)
+        return false;
 
-        t /= d;
+    t /= d;
 
-        //all conditions have been met
-        //todo: fix please. return t instead
-        hitPoint = segmentStart + (segmentEnd-segmentStart)*t;//t is in range 0 and 1 and denotes how far along the distance the hit is
+    return true;
+}
+
+/**
+ * Returns true if the segment hits the mesh. hitPoint is set to the closest hit.
+ */
+bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segmentEnd,QVector3D& hitPoint)
+{
+    TriangleIntersectionResult result;
+    if (getBVH()->getClosestIntersection(segmentStart, segmentEnd, result)) {
+        hitPoint = result.hitPoint;
         return true;
     }
 
@@ -81,52 +119,49 @@ bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segm
  */
 int TriMesh::getSegmentIntersections(const QVector3D& segmentStart,const QVector3D& segmentEnd,QList<TriangleIntersectionResult>& results)
 {
-    int hits = 0;
-    for(auto i=0;i<triangles.size();i++)
-    {
-        //auto tri = triangles[i];
-        const Triangle& tri = triangles[i];
-        auto ab = tri.b - tri.a;
-        auto ac = tri.c - tri.a;
-        auto qp = segmentStart-segmentEnd;
-
-        //auto normal = tri.normal;
-        auto normal = QVector3D::crossProduct(ab, ac);
-        float d = QVector3D::dotProduct(qp, normal);
-
-        if (d <= 0)
-            continue;
+    return getBVH()->getAllIntersections(segmentStart, segmentEnd, results);
+}
 
-        auto ap = segmentStart - tri.a;
-        auto t = QVector3D::dotProduct(ap, normal);
+bool TriMesh::getClosestSegmentIntersection(const QVector3D& segmentStart,const QVector3D& segmentEnd,TriangleIntersectionResult& result)
+{
+    return getBVH()->getClosestIntersection(segmentStart, segmentEnd, result);
+}
 
-        if (t < 0 || t > d)
+//no need to get uvw, just return true at the first sign of a hit
+bool TriMesh::isHitBySegmentLinear(const QVector3D& segmentStart,const QVector3D& segmentEnd,QVector3D& hitPoint)
+{
+    for (const Triangle& tri : triangles)
+    {
+        float t;
+        if (!intersectSegmentTriangle(tri.a, tri.b, tri.c, segmentStart, segmentEnd, t))
             continue;
 
-        auto e = QVector3D::crossProduct(qp, ap);
-        auto v = QVector3D::dotProduct(ac, e);
+        //t is in range 0 and 1 and denotes how far along the distance the hit is
+        hitPoint = segmentStart + (segmentEnd-segmentStart)*t;
+        return true;
+    }
 
-        if (v < 0 || v > d)
-            continue;
+    return false;
+}
 
-        auto w = -QVector3D::dotProduct(ab, e);
+int TriMesh::getSegmentIntersectionsLinear(const QVector3D& segmentStart,const QVector3D& segmentEnd,QList<TriangleIntersectionResult>& results)
+{
+    int hits = 0;
+    for(auto i=0;i<triangles.size();i++)
+    {
+        const Triangle& tri = triangles[i];
 
-        if (w < 0.0f || v + w > d)
+        float t;
+        if (!intersectSegmentTriangle(tri.a, tri.b, tri.c, segmentStart, segmentEnd, t))
             continue;
 
-        t /= d;
-
         //all conditions have been met
-        hits++;
-
-        auto dist = segmentStart.distanceToPoint(segmentEnd);
         auto hitPoint = segmentStart + (segmentEnd-segmentStart)*t;
 
         TriangleIntersectionResult result;
         result.triangleIndex = i;
         result.hitPoint = hitPoint;
         result.t = t;
-        //result.hitPoint = tri.a*u + tri.b*v + tri.c*w;
         results.append(result);
         hits++;
     }
@@ -14,10 +14,13 @@ For more information see the LICENSE file
 
 #include <QVector3D>
 #include <QList>
+#include "boundingbox.h"
 
 namespace iris
 {
 
+class TriMeshBVH;
+
 struct TriangleIntersectionResult
 {
     int triangleIndex;
@@ -47,6 +50,15 @@ class TriMesh
 public:
     QList<Triangle> triangles;
 
+    // local space bounds of all triangles, grown by addTriangle
+    BoundingBox bounds;
+
+    TriMesh();
+    ~TriMesh();
+
+    // the bvh is owned, so copying would delete it twice
+    TriMesh(const TriMesh&) = delete;
+    TriMesh& operator=(const TriMesh&) = delete;
 
     /**
      * Adds points for triangle. Assumes points are in a counter-clockwise rotation.
@@ -56,9 +68,22 @@ public:
      */
     void addTriangle(const QVector3D& a, const QVector3D& b, const QVector3D& c);
 
-    //https://github.com/qt/qt3d/blob/5476bc6b4b6a12c921da502c24c4e078b04dd3b3/src/render/jobs/pickboundingvolumejob.cpp
-    //realtime rendering page 192
-    //no need to get uvw, just return true at the first sign of a hit
+    /**
+     * Returns the mesh's bounding volume hierarchy. It is built the first time it's requested,
+     * which is usually the first time the mesh is picked.
+     * @return
+     */
+    TriMeshBVH* getBVH();
+
+    /**
+     * Discards the bounding volume hierarchy. Should be called if the triangle list is
+     * modified directly.
+     */
+    void invalidateBVH();
+
+    /**
+     * Returns true if the segment hits the mesh. hitPoint is set to the closest hit.
+     */
     bool isHitBySegment(const QVector3D& segmentStart, const QVector3D& segmentEnd, QVector3D& hitPoint);
 
     /**
@@ -68,6 +93,30 @@ public:
      */
     int getSegmentIntersections(const QVector3D& segmentStart, const QVector3D& segmentEnd, QList<TriangleIntersectionResult>& results);
 
+    /**
+     * Finds the intersection closest to segmentStart
+     * Returns false if the segment doesnt hit the mesh
+     */
+    bool getClosestSegmentIntersection(const QVector3D& segmentStart, const QVector3D& segmentEnd, TriangleIntersectionResult& result);
+
+    /**
+     * Brute-force versions of the segment queries. They test every triangle and are kept
+     * as the reference the bvh queries are checked against.
+     */
+    bool isHitBySegmentLinear(const QVector3D& segmentStart, const QVector3D& segmentEnd, QVector3D& hitPoint);
+    int getSegmentIntersectionsLinear(const QVector3D& segmentStart, const QVector3D& segmentEnd, QList<TriangleIntersectionResult>& results);
+
+    /**
+     * Segment-triangle test shared by the linear and bvh paths.
+     * Only front faces (counter-clockwise when viewed from segmentStart) are hit.
+     * t is the distance along the segment in the range 0 and 1
+     */
+    static bool intersectSegmentTriangle(const QVector3D& a, const QVector3D& b, const QVector3D& c,
+                                         const QVector3D& segmentStart, const QVector3D& segmentEnd,
+                                         float& t);
+
+private:
+    TriMeshBVH* bvh;
 
 };
 
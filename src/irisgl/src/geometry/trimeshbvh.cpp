@@ -0,0 +1,353 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "trimeshbvh.h"
+#include "trimesh.h"
+
+#include <algorithm>
+
+namespace iris
+{
+
+namespace
+{
+
+const int NUM_BINS = 12;
+const int MAX_LEAF_SIZE = 4;
+const int MAX_DEPTH = 64;
+
+// stack only ever holds one pending child per level
+const int MAX_STACK_SIZE = MAX_DEPTH + 2;
+
+// relative costs used by the surface area heuristic
+const float TRAVERSAL_COST = 1.0f;
+const float INTERSECTION_COST = 1.0f;
+
+struct SplitBin
+{
+    BoundingBox bounds;
+    int count = 0;
+};
+
+inline int getBinIndex(float centroid, float binMin, float binScale)
+{
+    int bin = (int)((centroid - binMin) * binScale);
+    return std::min(std::max(bin, 0), NUM_BINS - 1);
+}
+
+inline QVector3D getInverseDir(const QVector3D& dir)
+{
+    // division by zero gives +/-inf which the slab test handles
+    return QVector3D(1.0f / dir.x(), 1.0f / dir.y(), 1.0f / dir.z());
+}
+
+}
+
+TriMeshBVH* TriMeshBVH::build(const TriMesh* triMesh)
+{
+    auto bvh = new TriMeshBVH();
+
+    int count = triMesh->triangles.size();
+    if (count == 0) return bvh;
+
+    QVector<BoundingBox> triBounds(count);
+    QVector<QVector3D> centroids(count);
+    QVector<int> indices(count);
+
+    for (int i = 0; i < count; i++) {
+        const Triangle& tri = triMesh->triangles[i];
+
+        triBounds[i].merge(tri.a);
+        triBounds[i].merge(tri.b);
+        triBounds[i].merge(tri.c);
+
+        centroids[i] = (tri.a + tri.b + tri.c) / 3.0f;
+        indices[i] = i;
+    }
+
+    // a binary tree with n leaves has 2n-1 nodes
+    bvh->nodes.reserve(2 * count - 1);
+    bvh->triangles.reserve(count);
+    bvh->buildNode(indices, triBounds, centroids, 0, count, 0);
+
+    // copy triangles in leaf order
+    for (auto& bvhTri : bvh->triangles) {
+        const Triangle& tri = triMesh->triangles[bvhTri.triangleIndex];
+        bvhTri.a = tri.a;
+        bvhTri.b = tri.b;
+        bvhTri.c = tri.c;
+    }
+
+    return bvh;
+}
+
+int TriMeshBVH::buildNode(QVector<int>& indices,
+                          const QVector<BoundingBox>& triBounds,
+                          const QVector<QVector3D>& centroids,
+                          int start,
+                          int end,
+                          int depth)
+{
+    int nodeIndex = nodes.size();
+    nodes.append(BVHNode());
+
+    BoundingBox bounds;
+    BoundingBox centroidBounds;
+    for (int i = start; i < end; i++) {
+        bounds.merge(triBounds[indices[i]]);
+        centroidBounds.merge(centroids[indices[i]]);
+    }
+
+    int count = end - start;
+    float parentArea = bounds.getSurfaceArea();
+
+    // cost of making this node a leaf
+    float bestCost = INTERSECTION_COST * count;
+    int bestAxis = -1;
+    int bestSplit = -1;
+
+    if (count > MAX_LEAF_SIZE && depth < MAX_DEPTH && parentArea > 0.0f) {
+        for (int axis = 0; axis < 3; axis++) {
+            float binMin = centroidBounds.minPos[axis];
+            float binMax = centroidBounds.maxPos[axis];
+
+            // all centroids lie on the same plane, nothing to split
+            if (binMax <= binMin) continue;
+
+            float binScale = NUM_BINS / (binMax - binMin);
+
+            SplitBin bins[NUM_BINS];
+            for (int i = start; i < end; i++) {
+                int tri = indices[i];
+                auto& bin = bins[getBinIndex(centroids[tri][axis], binMin, binScale)];
+                bin.count++;
+                bin.bounds.merge(triBounds[tri]);
+            }
+
+            // sweep from the right to get the cost of every right hand side
+            float rightArea[NUM_BINS];
+            int rightCount[NUM_BINS];
+            BoundingBox accum;
+            int accumCount = 0;
+            for (int b = NUM_BINS - 1; b > 0; b--) {
+                accum.merge(bins[b].bounds);
+                accumCount += bins[b].count;
+                rightArea[b] = accum.getSurfaceArea();
+                rightCount[b] = accumCount;
+            }
+
+            // then sweep from the left and evaluate each split plane
+            accum.clear();
+            accumCount = 0;
+            for (int b = 0; b < NUM_BINS - 1; b++) {
+                accum.merge(bins[b].bounds);
+                accumCount += bins[b].count;
+
+                if (accumCount == 0 || rightCount[b + 1] == 0) continue;
+
+                float cost = TRAVERSAL_COST +
+                             INTERSECTION_COST * (accum.getSurfaceArea() * accumCount +
+                                                  rightArea[b + 1] * rightCount[b + 1]) / parentArea;
+
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+    }
+
+    bounds.inflate();
+    nodes[nodeIndex].bounds = bounds;
+
+    if (bestAxis == -1) {
+        nodes[nodeIndex].offset = triangles.size();
+        nodes[nodeIndex].triangleCount = count;
+        nodes[nodeIndex].axis = 0;
+
+        for (int i = start; i < end; i++) {
+            BVHTriangle tri;
+            tri.triangleIndex = indices[i];
+            triangles.append(tri);
+        }
+
+        return nodeIndex;
+    }
+
+    float binMin = centroidBounds.minPos[bestAxis];
+    float binScale = NUM_BINS / (centroidBounds.maxPos[bestAxis] - binMin);
+
+    auto mid = std::partition(indices.begin() + start, indices.begin() + end, [&](int tri) {
+        return getBinIndex(centroids[tri][bestAxis], binMin, binScale) <= bestSplit;
+    });
+    int midIndex = mid - indices.begin();
+
+    // left child is always stored right after its parent
+    buildNode(indices, triBounds, centroids, start, midIndex, depth + 1);
+    int rightChild = buildNode(indices, triBounds, centroids, midIndex, end, depth + 1);
+
+    nodes[nodeIndex].offset = rightChild;
+    nodes[nodeIndex].triangleCount = 0;
+    nodes[nodeIndex].axis = bestAxis;
+
+    return nodeIndex;
+}
+
+bool TriMeshBVH::getClosestIntersection(const QVector3D& segmentStart,
+                                        const QVector3D& segmentEnd,
+                                        TriangleIntersectionResult& result) const
+{
+    if (nodes.isEmpty()) return false;
+
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = getInverseDir(dir);
+
+    bool hit = false;
+    float closestT = 1.0f;
+    int closestIndex = -1;
+
+    const BVHNode* nodeData = nodes.constData();
+    const BVHTriangle* triData = triangles.constData();
+
+    int stack[MAX_STACK_SIZE];
+    int stackSize = 0;
+    int current = 0;
+
+    while (true) {
+        const BVHNode& node = nodeData[current];
+        float tEntry;
+
+        // nodes further than the closest hit so far are skipped
+        if (node.bounds.intersectsSegment(segmentStart, invDir, 0.0f, closestT, tEntry)) {
+            if (node.triangleCount > 0) {
+                for (int i = 0; i < node.triangleCount; i++) {
+                    const BVHTriangle& tri = triData[node.offset + i];
+
+                    float t;
+                    if (!TriMesh::intersectSegmentTriangle(tri.a, tri.b, tri.c, segmentStart, segmentEnd, t))
+                        continue;
+
+                    // ties go to the lowest triangle index so the result doesnt depend on tree layout
+                    if (!hit || t < closestT || (t == closestT && tri.triangleIndex < closestIndex)) {
+                        hit = true;
+                        closestT = t;
+                        closestIndex = tri.triangleIndex;
+                    }
+                }
+            } else {
+                // visit the child nearest to the segment's start first
+                if (dir[node.axis] < 0) {
+                    stack[stackSize++] = current + 1;
+                    current = node.offset;
+                } else {
+                    stack[stackSize++] = node.offset;
+                    current = current + 1;
+                }
+                continue;
+            }
+        }
+
+        if (stackSize == 0) break;
+        current = stack[--stackSize];
+    }
+
+    if (hit) {
+        result.triangleIndex = closestIndex;
+        result.t = closestT;
+        result.hitPoint = segmentStart + dir * closestT;
+    }
+
+    return hit;
+}
+
+int TriMeshBVH::getAllIntersections(const QVector3D& segmentStart,
+                                    const QVector3D& segmentEnd,
+                                    QList<TriangleIntersectionResult>& results) const
+{
+    if (nodes.isEmpty()) return 0;
+
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = getInverseDir(dir);
+
+    int firstResult = results.size();
+    int hits = 0;
+
+    const BVHNode* nodeData = nodes.constData();
+    const BVHTriangle* triData = triangles.constData();
+
+    int stack[MAX_STACK_SIZE];
+    int stackSize = 0;
+    int current = 0;
+
+    while (true) {
+        const BVHNode& node = nodeData[current];
+        float tEntry;
+
+        if (node.bounds.intersectsSegment(segmentStart, invDir, 0.0f, 1.0f, tEntry)) {
+            if (node.triangleCount > 0) {
+                for (int i = 0; i < node.triangleCount; i++) {
+                    const BVHTriangle& tri = triData[node.offset + i];
+
+                    float t;
+                    if (!TriMesh::intersectSegmentTriangle(tri.a, tri.b, tri.c, segmentStart, segmentEnd, t))
+                        continue;
+
+                    TriangleIntersectionResult result;
+                    result.triangleIndex = tri.triangleIndex;
+                    result.hitPoint = segmentStart + dir * t;
+                    result.t = t;
+                    results.append(result);
+                    hits++;
+                }
+            } else {
+                stack[stackSize++] = node.offset;
+                current = current + 1;
+                continue;
+            }
+        }
+
+        if (stackSize == 0) break;
+        current = stack[--stackSize];
+    }
+
+    std::sort(results.begin() + firstResult, results.end(),
+              [](const TriangleIntersectionResult& a, const TriangleIntersectionResult& b) {
+        return a.triangleIndex < b.triangleIndex;
+    });
+
+    return hits;
+}
+
+int TriMeshBVH::getDepth() const
+{
+    if (nodes.isEmpty()) return 0;
+
+    // nodes are stored depth-first so the depth can be found with a single stack walk
+    QVector<QPair<int, int>> stack;
+    stack.append(qMakePair(0, 1));
+    int maxDepth = 0;
+
+    while (!stack.isEmpty()) {
+        auto entry = stack.takeLast();
+        const BVHNode& node = nodes[entry.first];
+        maxDepth = std::max(maxDepth, entry.second);
+
+        if (node.triangleCount == 0) {
+            stack.append(qMakePair(entry.first + 1, entry.second + 1));
+            stack.append(qMakePair(node.offset, entry.second + 1));
+        }
+    }
+
+    return maxDepth;
+}
+
+}
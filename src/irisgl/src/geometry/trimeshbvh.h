@@ -0,0 +1,101 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TRIMESHBVH_H
+#define TRIMESHBVH_H
+
+#include <QVector>
+#include <QList>
+#include <QVector3D>
+#include "boundingbox.h"
+
+namespace iris
+{
+
+class TriMesh;
+struct TriangleIntersectionResult;
+
+/**
+ * Node of the flattened hierarchy. Nodes are stored depth-first so the left
+ * child of an interior node is always the node right after it.
+ */
+struct BVHNode
+{
+    BoundingBox bounds;
+
+    // index of the right child for interior nodes
+    // index of the first triangle for leaf nodes
+    int offset;
+
+    // number of triangles in a leaf, 0 for interior nodes
+    int triangleCount;
+
+    // split axis of interior nodes, used to pick the nearest child first
+    int axis;
+};
+
+/**
+ * Triangle data copied out of the TriMesh in leaf order so traversal
+ * walks contiguous memory
+ */
+struct BVHTriangle
+{
+    QVector3D a, b, c;
+    int triangleIndex;
+};
+
+/**
+ * Bounding volume hierarchy over the triangles of a TriMesh.
+ * Built top-down with the surface area heuristic evaluated over binned centroids.
+ * The tree doesnt track changes to the mesh so it has to be rebuilt if the mesh's
+ * triangles change.
+ */
+class TriMeshBVH
+{
+public:
+    QVector<BVHNode> nodes;
+    QVector<BVHTriangle> triangles;
+
+    static TriMeshBVH* build(const TriMesh* triMesh);
+
+    /**
+     * Finds the hit closest to segmentStart
+     * Returns false if the segment doesnt hit the mesh
+     */
+    bool getClosestIntersection(const QVector3D& segmentStart,
+                                const QVector3D& segmentEnd,
+                                TriangleIntersectionResult& result) const;
+
+    /**
+     * Finds every hit along the segment. Results are ordered by triangle index
+     * so they match the output of the linear path.
+     * Returns number of intersections
+     */
+    int getAllIntersections(const QVector3D& segmentStart,
+                            const QVector3D& segmentEnd,
+                            QList<TriangleIntersectionResult>& results) const;
+
+    int getDepth() const;
+
+private:
+    TriMeshBVH() {}
+
+    int buildNode(QVector<int>& indices,
+                  const QVector<BoundingBox>& triBounds,
+                  const QVector<QVector3D>& centroids,
+                  int start,
+                  int end,
+                  int depth);
+};
+
+}
+
+#endif // TRIMESHBVH_H
@@ -29,6 +29,8 @@ For more information see the LICENSE file
 #include <QOpenGLFunctions_3_2_Core>
 #include <QSharedPointer>
 #include <QOpenGLTexture>
+#include <QSet>
+#include <QVector2D>
 #include "viewport.h"
 #include "utils/billboard.h"
 #include "utils/fullscreenquad.h"
@@ -39,8 +41,15 @@ For more information see the LICENSE file
 #include "../core/irisutils.h"
 #include "postprocessmanager.h"
 #include "postprocess.h"
+#include "../math/frustum.h"
+#include "renderqueue.h"
+#include "shader.h"
+#include "uniformblocks.h"
+#include "shadercache.h"
+#include "instancebuffer.h"
 
 #include <QOpenGLContext>
+#include <cstring>
 #include "../libovr/Include/OVR_CAPI_GL.h"
 #include "../libovr/Include/Extras/OVR_Math.h"
 
@@ -49,6 +58,140 @@ using namespace OVR;
 namespace iris
 {
 
+namespace
+{
+
+// casters that havent moved for this many frames go in the cached static shadow layer
+const int STATIC_CASTER_FRAMES = 30;
+
+bool isStaticCaster(const RenderItem* item)
+{
+    return item->framesUnchanged >= STATIC_CASTER_FRAMES;
+}
+
+// order independent hash of the static casters, changes when one is added, removed or replaced
+quint64 hashStaticCasters(const QVector<RenderItem*>& items)
+{
+    quint64 hash = 0;
+    for (auto item : items) {
+        if (item->type != RenderItemType::Mesh || !isStaticCaster(item))
+            continue;
+
+        quint64 h = (quint64)(quintptr)item * 0x9E3779B97F4A7C15ull;
+        h ^= (quint64)(quintptr)item->mesh + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+        h ^= item->transformVersion * 0xC2B2AE3D27D4EB4Full;
+        hash += h;
+    }
+
+    return hash;
+}
+
+/**
+ * Finds a view and projection whose frustum contains the frustums of both eyes.
+ * The eyes share their orientation so the combined frustum takes the outer sides of
+ * the two frustums and puts its apex where they meet, a little behind the eyes.
+ */
+void getStereoView(const QMatrix4x4 eyeViews[2],
+                   const QMatrix4x4 eyeProjs[2],
+                   float nearClip,
+                   float farClip,
+                   QMatrix4x4& view,
+                   QMatrix4x4& proj)
+{
+    // slopes of the sides of each eye's frustum
+    float left[2], right[2], bottom[2], top[2];
+    for (int eye = 0; eye < 2; eye++) {
+        const auto& p = eyeProjs[eye];
+        left[eye] = (p(0, 2) - 1.0f) / p(0, 0);
+        right[eye] = (p(0, 2) + 1.0f) / p(0, 0);
+        bottom[eye] = (p(1, 2) - 1.0f) / p(1, 1);
+        top[eye] = (p(1, 2) + 1.0f) / p(1, 1);
+    }
+
+    // the right eye's position in the left eye's view space
+    float eyeDistance = (eyeViews[0] * eyeViews[1].inverted()).column(3).x();
+
+    // the outer sides, from the left eye on the left and from the right eye on the right,
+    // meet behind the eyes
+    float stereoLeft = qMin(left[0], left[1]);
+    float stereoRight = qMax(right[0], right[1]);
+    float apexDepth = eyeDistance / qMax(stereoRight - stereoLeft, 0.001f);
+    QVector3D apex(stereoLeft * -apexDepth, 0.0f, apexDepth);
+
+    QMatrix4x4 apexTransform;
+    apexTransform.translate(-apex);
+    view = apexTransform * eyeViews[0];
+
+    float stereoNear = nearClip + apexDepth;
+    proj.setToIdentity();
+    proj.frustum(stereoLeft * stereoNear,
+                 stereoRight * stereoNear,
+                 qMin(bottom[0], bottom[1]) * stereoNear,
+                 qMax(top[0], top[1]) * stereoNear,
+                 stereoNear,
+                 farClip + apexDepth);
+}
+
+// the first visible directional light casts the shadows
+LightNodePtr getShadowLight(const ScenePtr& scene)
+{
+    for (auto light : scene->lights) {
+        if (light->lightType == iris::LightType::Directional && light->isVisible())
+            return light;
+    }
+
+    return LightNodePtr();
+}
+
+// items without bounds are always considered visible
+bool isInFrustum(const RenderItem* item, const Frustum& frustum)
+{
+    if (!item->cullable || item->type != RenderItemType::Mesh || item->mesh == nullptr)
+        return true;
+
+    const auto& bounds = item->mesh->boundingBox;
+    if (bounds.isEmpty())
+        return true;
+
+    return frustum.intersectsBox(bounds.transformed(item->worldMatrix));
+}
+
+// instancing needs the transforms to come from instancing.glsl and
+// transparent items have to be drawn one by one in depth order
+bool canInstance(const RenderItem* item)
+{
+    return item->type == RenderItemType::Mesh &&
+           item->mesh != nullptr &&
+           !!item->material &&
+           item->renderLayer < (int)RenderLayer::Transparent &&
+           item->material->shader->supportsInstancing();
+}
+
+bool isSameRenderStates(const RenderStates& a, const RenderStates& b)
+{
+    return a.renderLayer == b.renderLayer &&
+           a.blendType == b.blendType &&
+           a.zWrite == b.zWrite &&
+           a.depthTest == b.depthTest &&
+           a.cullMode == b.cullMode &&
+           a.fogEnabled == b.fogEnabled &&
+           a.castShadows == b.castShadows &&
+           a.receiveShadows == b.receiveShadows &&
+           a.receiveLighting == b.receiveLighting;
+}
+
+// items can share a draw call if only their transforms differ
+bool isSameBatch(const RenderItem* first, const RenderItem* item)
+{
+    return item->type == RenderItemType::Mesh &&
+           item->renderLayer == first->renderLayer &&
+           item->mesh == first->mesh &&
+           item->material == first->material &&
+           isSameRenderStates(item->renderStates, first->renderStates);
+}
+
+}
+
 ForwardRenderer::ForwardRenderer()
 {
     this->gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
@@ -61,7 +204,15 @@ ForwardRenderer::ForwardRenderer()
     createParticleShader();
     createEmitterShader();
 
-    generateShadowBuffer(4096);
+    shadowMapSize = 0;
+    staticCasterHash = 0;
+    generateShadowBuffer();
+
+    frameDataBuffer = new UniformBuffer(gl, UniformBlockBinding::FrameData, sizeof(FrameDataBlock));
+    lightDataBuffer = new UniformBuffer(gl, UniformBlockBinding::LightData, sizeof(LightDataBlock));
+    instanceBuffer = new InstanceBuffer(gl);
+    lightClusters = new LightClusters(gl);
+    stereoRendering = true;
 
     vrDevice = VrManager::getDefaultDevice();
     vrDevice->initialize();
@@ -77,20 +228,14 @@ ForwardRenderer::ForwardRenderer()
     postContext = new PostProcessContext();
 }
 
-void ForwardRenderer::generateShadowBuffer(GLuint size)
+void ForwardRenderer::generateShadowBuffer()
 {
     gl->glGenFramebuffers(1, &shadowFBO);
-
     gl->glGenTextures(1, &shadowDepthMap);
-    gl->glBindTexture(GL_TEXTURE_2D, shadowDepthMap);
-    gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32,
-                     size, size,
-                     0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
-    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->glGenFramebuffers(1, &staticShadowFBO);
+    gl->glGenTextures(1, &staticShadowDepthMap);
+
+    allocateShadowMap();
 
     gl->glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
     gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowDepthMap, 0);
@@ -98,11 +243,56 @@ void ForwardRenderer::generateShadowBuffer(GLuint size)
     gl->glDrawBuffer(GL_NONE);
     gl->glReadBuffer(GL_NONE);
 
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, staticShadowFBO);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, staticShadowDepthMap, 0);
+
+    gl->glDrawBuffer(GL_NONE);
+    gl->glReadBuffer(GL_NONE);
+
     gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // check status at end
 }
 
+void ForwardRenderer::allocateShadowMap()
+{
+    auto allocate = [this](GLuint texture, int size, GLint filter) {
+        gl->glBindTexture(GL_TEXTURE_2D, texture);
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32,
+                         size, size,
+                         0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gl->glBindTexture(GL_TEXTURE_2D, 0);
+    };
+
+    // the cascades are tiles of one atlas so existing shaders keep their single shadow sampler
+    // both atlases have the same size and format so the static one can be blitted
+    int size = ShadowCascades::getGridSize(shadowSettings.cascadeCount) * shadowSettings.cascadeResolution;
+    if (size != shadowMapSize) {
+        shadowMapSize = size;
+        allocate(shadowDepthMap, size, GL_LINEAR);
+        allocate(staticShadowDepthMap, size, GL_LINEAR);
+    }
+
+    // the tiles may have moved or changed size
+    for (int i = 0; i < SHADER_MAX_SHADOW_CASCADES; i++)
+        staticShadowValid[i] = false;
+}
+
+void ForwardRenderer::setShadowSettings(const ShadowSettings& settings)
+{
+    shadowSettings = settings;
+    shadowSettings.cascadeCount = qBound(1, settings.cascadeCount, SHADER_MAX_SHADOW_CASCADES);
+    shadowSettings.cascadeResolution = qMax(settings.cascadeResolution, 16);
+    shadowSettings.cascadeStep = qBound(0.0f, settings.cascadeStep, 1.0f);
+
+    allocateShadowMap();
+}
+
 ForwardRendererPtr ForwardRenderer::create()
 {
     return ForwardRendererPtr(new ForwardRenderer());
@@ -114,6 +304,8 @@ void ForwardRenderer::renderScene(float delta, Viewport* vp)
     auto ctx = QOpenGLContext::currentContext();
     auto cam = scene->camera;
 
+    renderStats.reset();
+
     // STEP 1: RENDER SCENE
     renderData->scene = scene;
 
@@ -130,14 +322,13 @@ void ForwardRenderer::renderScene(float delta, Viewport* vp)
     renderData->fogEnabled = scene->fogEnabled;
 
     if (scene->shadowEnabled) {
-        gl->glViewport(0, 0, 4096, 4096);
-        gl->glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
-        gl->glClear(GL_DEPTH_BUFFER_BIT);
         gl->glCullFace(GL_FRONT);
-        renderShadows(scene);
+        renderShadows(scene, cam->viewMatrix, cam->projMatrix);
         gl->glCullFace(GL_BACK);
         gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
         gl->glBindFramebuffer(GL_FRAMEBUFFER, ctx->defaultFramebufferObject());
+    } else {
+        shadowCascades.count = 0;
     }
 
     gl->glViewport(0, 0, vp->width * vp->pixelRatioScale, vp->height * vp->pixelRatioScale);
@@ -191,46 +382,123 @@ void ForwardRenderer::renderScene(float delta, Viewport* vp)
     scene->shadowRenderList.clear();
 }
 
-void ForwardRenderer::renderShadows(QSharedPointer<Scene> node)
+void ForwardRenderer::renderShadows(QSharedPointer<Scene> node,
+                                    const QMatrix4x4& viewMatrix,
+                                    const QMatrix4x4& projMatrix)
 {
-    QMatrix4x4 lightView, lightProjection;
+    auto light = getShadowLight(scene);
+    if (!light) {
+        shadowCascades.count = 0;
+        return;
+    }
 
-    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadowFBO);
-    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowDepthMap, 0);
+    auto lightDir = light->getLightDir();
+    shadowCascades.calculate(viewMatrix, projMatrix, lightDir, shadowSettings);
+
+    // the previous frame's passes leave these set, except on the first frame
+    gl->glEnable(GL_DEPTH_TEST);
+    gl->glDepthMask(GL_TRUE);
+    gl->glEnable(GL_CULL_FACE);
+
+    // every cascade's static layer is redrawn when a static caster moves, appears or goes away
+    auto hash = hashStaticCasters(scene->shadowRenderList);
+    if (hash != staticCasterHash || !shadowSettings.cacheStaticCasters) {
+        staticCasterHash = hash;
+        for (int i = 0; i < SHADER_MAX_SHADOW_CASCADES; i++)
+            staticShadowValid[i] = false;
+    }
 
+    // redraws the static layer of the cascades that moved, the light's direction is part of their matrix
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, staticShadowFBO);
     shadowShader->bind();
+    for (int cascade = 0; cascade < shadowCascades.count; cascade++) {
+        const auto& lightSpaceMatrix = shadowCascades.lightSpaceMatrices[cascade];
+        if (staticShadowValid[cascade] && staticShadowMatrices[cascade] == lightSpaceMatrix) {
+            renderStats.shadowCacheHits++;
+            continue;
+        }
 
-    for (auto light : scene->lights) {
-        if (light->lightType == iris::LightType::Directional) {
+        int viewport[4];
+        ShadowCascades::getTileViewport(cascade, shadowSettings, viewport);
+        gl->glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
 
-            lightProjection.ortho(-128.0f, 128.0f, -64.0f, 64.0f, -64.0f, 128.0f);
+        // only this cascade's tile is cleared
+        gl->glEnable(GL_SCISSOR_TEST);
+        gl->glScissor(viewport[0], viewport[1], viewport[2], viewport[3]);
+        gl->glClear(GL_DEPTH_BUFFER_BIT);
+        gl->glDisable(GL_SCISSOR_TEST);
 
-            lightView.lookAt(QVector3D(0, 0, 0),
-                             light->getLightDir(),
-                             QVector3D(0.0f, 1.0f, 0.0f));
-            QMatrix4x4 lightSpaceMatrix = lightProjection * lightView;
+        renderShadowCasters(lightSpaceMatrix, true);
 
-            shadowShader->setUniformValue("u_lightSpaceMatrix", lightSpaceMatrix);
+        staticShadowValid[cascade] = true;
+        staticShadowMatrices[cascade] = lightSpaceMatrix;
+        renderStats.shadowCacheRebuilds++;
+    }
 
-            for (auto& item : scene->shadowRenderList) {
-                shadowShader->setUniformValue("u_worldMatrix", item->worldMatrix);
+    // starts the frame's shadow atlas from the static layer
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, staticShadowFBO);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadowFBO);
+    gl->glBlitFramebuffer(0, 0, shadowMapSize, shadowMapSize,
+                          0, 0, shadowMapSize, shadowMapSize,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 
-                if (item->type == iris::RenderItemType::Mesh) {
-                    item->mesh->draw(gl, shadowShader);
-                }
-            }
-        }
+    // moving casters are drawn on top, the depth test merges them with the static ones
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    for (int cascade = 0; cascade < shadowCascades.count; cascade++) {
+        int viewport[4];
+        ShadowCascades::getTileViewport(cascade, shadowSettings, viewport);
+        gl->glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        renderShadowCasters(shadowCascades.lightSpaceMatrices[cascade], false);
     }
 
     shadowShader->release();
 }
 
+void ForwardRenderer::renderShadowCasters(const QMatrix4x4& lightSpaceMatrix, bool staticCasters)
+{
+    auto shadowLocations = ShaderCache::getShader(shadowShader);
+    int lightSpaceLocation = shadowLocations->getUniformLocation(ShaderUniform::LightSpaceMatrix);
+    int worldMatrixLocation = shadowLocations->getUniformLocation(ShaderUniform::WorldMatrix);
+
+    shadowShader->setUniformValue(lightSpaceLocation, lightSpaceMatrix);
+
+    // each cascade only draws the casters inside its own volume
+    Frustum lightFrustum(lightSpaceMatrix);
+
+    Mesh* currentMesh = nullptr;
+
+    for (auto& item : scene->shadowRenderList) {
+        if (item->type != iris::RenderItemType::Mesh || isStaticCaster(item) != staticCasters)
+            continue;
+
+        if (!isInFrustum(item, lightFrustum)) {
+            renderStats.shadowItemsCulled++;
+            continue;
+        }
+
+        shadowShader->setUniformValue(worldMatrixLocation, item->worldMatrix);
+
+        if (item->mesh != currentMesh) {
+            item->mesh->bind(gl);
+            currentMesh = item->mesh;
+        }
+
+        item->mesh->drawBound(gl);
+        renderStats.shadowItemsDrawn++;
+    }
+
+    gl->glBindVertexArray(0);
+}
+
 void ForwardRenderer::renderSceneVr(float delta, Viewport* vp)
 {
     auto ctx = QOpenGLContext::currentContext();
     if(!vrDevice->isVrSupported())
         return;
 
+    renderStats.reset();
+
     QVector3D viewerPos = scene->camera->getGlobalPosition();
     float viewScale = scene->camera->getVrViewScale();
     QMatrix4x4 viewTransform = scene->camera->globalTransform;
@@ -244,53 +512,73 @@ void ForwardRenderer::renderSceneVr(float delta, Viewport* vp)
     }
 
 
+
+    vrDevice->beginFrame();
+
+    QMatrix4x4 eyeViews[2], eyeProjs[2];
+    for (int eye = 0; eye < 2; ++eye) {
+        eyeViews[eye] = vrDevice->getEyeViewMatrix(eye, viewerPos, viewTransform);
+        eyeProjs[eye] = vrDevice->getEyeProjMatrix(eye, 0.1f, 1000.0f);
+    }
+
+    // view that covers both eyes
+    QMatrix4x4 stereoView, stereoProj;
+    getStereoView(eyeViews, eyeProjs, 0.1f, 1000.0f, stereoView, stereoProj);
+
+    // the cascades are fitted to the view of both eyes so they're rendered once
     if (scene->shadowEnabled) {
-        gl->glViewport(0, 0, 4096, 4096);
-        gl->glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
-        gl->glClear(GL_DEPTH_BUFFER_BIT);
         gl->glCullFace(GL_FRONT);
-        renderShadows(scene);
+        renderShadows(scene, stereoView, stereoProj);
         gl->glCullFace(GL_BACK);
         gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
         gl->glBindFramebuffer(GL_FRAMEBUFFER, ctx->defaultFramebufferObject());
+    } else {
+        shadowCascades.count = 0;
     }
 
-    vrDevice->beginFrame();
-
-    for (int eye = 0; eye < 2; ++eye)
-    {
-        vrDevice->beginEye(eye);
-
-        auto view = vrDevice->getEyeViewMatrix(eye, viewerPos, viewTransform);
-        renderData->eyePos = view.column(3).toVector3D();
-        renderData->viewMatrix = view;
-
-        auto proj = vrDevice->getEyeProjMatrix(eye,0.1f,1000.0f);
-        renderData->projMatrix = proj;
+    renderData->scene = scene;
 
-        //STEP 1: RENDER SCENE
-        renderData->scene = scene;
+    //renderData->eyePos = camera->globalTransform.column(3).toVector3D();
+    renderData->eyePos = viewerPos;
 
-        //camera->setAspectRatio(vp->getAspectRatio());
-        //camera->updateCameraMatrices();
+    renderData->fogColor = scene->fogColor;
+    renderData->fogStart = scene->fogStart;
+    renderData->fogEnd = scene->fogEnd;
+    renderData->fogEnabled = scene->fogEnabled;
 
-        //renderData->eyePos = camera->globalTransform.column(3).toVector3D();
-        renderData->eyePos = viewerPos;
+    if (stereoRendering) {
+        // the items are culled against and the lights binned for the combined view once,
+        // the eyes' own matrices are only used by the vertex shaders
+        vrDevice->beginStereo();
+
+        renderData->stereo = true;
+        renderData->viewMatrix = stereoView;
+        renderData->projMatrix = stereoProj;
+        for (int eye = 0; eye < 2; ++eye) {
+            renderData->eyeViewMatrices[eye] = eyeViews[eye];
+            renderData->eyeProjMatrices[eye] = eyeProjs[eye];
+        }
 
-        renderData->fogColor = scene->fogColor;
-        renderData->fogStart = scene->fogStart;
-        renderData->fogEnd = scene->fogEnd;
-        renderData->fogEnabled = scene->fogEnabled;
+        renderNode(renderData, scene);
 
-        renderNode(renderData,scene);
+        renderData->stereo = false;
+        vrDevice->endStereo();
+    } else {
+        for (int eye = 0; eye < 2; ++eye)
+        {
+            vrDevice->beginEye(eye);
 
-        //STEP 2: RENDER SKY
-        //renderSky(renderData);
+            //STEP 1: RENDER SCENE
+            renderData->viewMatrix = eyeViews[eye];
+            renderData->projMatrix = eyeProjs[eye];
 
-        //renderParticles(renderData, delta, scene->rootNode);
+            renderNode(renderData,scene);
 
+            //STEP 2: RENDER SKY
+            //renderSky(renderData);
 
-        vrDevice->endEye(eye);
+            vrDevice->endEye(eye);
+        }
     }
 
     vrDevice->endFrame();
@@ -320,174 +608,500 @@ bool ForwardRenderer::isVrSupported()
 
 void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
 {
-    QMatrix4x4 lightView, lightProjection, lightSpaceMatrix;
+    // shaders that dont use the cascades get the last one, it covers the whole shadow distance
+    QMatrix4x4 lightSpaceMatrix;
+    if (shadowCascades.count > 0)
+        lightSpaceMatrix = shadowCascades.atlasMatrices[shadowCascades.count - 1];
+
+    // cull items outside of the view frustum then sort the rest by state
+    // done per call so each eye is culled against its own frustum in vr mode,
+    // single pass stereo culls once against a frustum that covers both eyes
+    Frustum frustum(renderData->projMatrix * renderData->viewMatrix);
+
+    renderQueue.clear();
+    for (auto item : scene->geometryRenderList) {
+        if (isInFrustum(item, frustum)) {
+            renderQueue.add(item, renderData->viewMatrix);
+        } else {
+            renderStats.itemsCulled++;
+        }
+    }
 
-    for (auto light : scene->lights) {
-        if (light->lightType == iris::LightType::Directional && true) { // cast shadows
-            lightProjection.ortho(-128.0f, 128.0f, -64.0f, 64.0f, -64.0f, 128.0f);
+    renderQueue.sort();
 
-            lightView.lookAt(QVector3D(0, 0, 0),
-                             light->getLightDir(),
-                             QVector3D(0.0f, 1.0f, 0.0f));
+    updateUniformBuffers(renderData, lightSpaceMatrix);
+    buildRenderBatches();
 
-            lightSpaceMatrix = lightProjection * lightView;
-        }
-    }
+    // the shadow map, instance data and light clusters are shared by every item so they're only bound once
+    gl->glActiveTexture(GL_TEXTURE8);
+    gl->glBindTexture(GL_TEXTURE_2D, shadowDepthMap);
+    instanceBuffer->bind();
+    lightClusters->bind();
+    renderStats.textureBinds += 4;
 
-    auto lightCount = renderData->scene->lights.size();
+    resetRenderStates();
 
-    //sort render list
-    //qsort(scene->geometryRenderList,scene->geometryRenderList.size(),)
-    qSort(scene->geometryRenderList.begin(), scene->geometryRenderList.end(), [](const RenderItem* a, const RenderItem* b) {
-        return a->renderLayer < b->renderLayer;
-    });
+    Material* currentMaterial = nullptr;
+    QOpenGLShaderProgram* currentProgram = nullptr;
+    Mesh* currentMesh = nullptr;
 
-    for (auto& item : scene->geometryRenderList) {
-        if (item->type == iris::RenderItemType::Mesh) {
+    // uniforms that are the same for every item only need to be set once per program
+    QSet<QOpenGLShaderProgram*> programsWithFrameUniforms;
+
+    // programs without stereo support are drawn once per eye to its half of the target
+    GLint stereoViewport[4];
+    if (renderData->stereo) {
+        gl->glGetIntegerv(GL_VIEWPORT, stereoViewport);
+        gl->glEnable(GL_CLIP_DISTANCE0);
+    }
+
+    auto setEyeViewport = [&](int eye) {
+        int eyeWidth = stereoViewport[2] / 2;
+        gl->glViewport(stereoViewport[0] + eye * eyeWidth, stereoViewport[1], eyeWidth, stereoViewport[3]);
+    };
 
-            QOpenGLShaderProgram* program = nullptr;
-            iris::MaterialPtr mat;
+    for (const auto& batch : renderBatches) {
+        auto item = renderQueue.items[batch.start].item;
+        bool isInstanced = batch.instanceOffset >= 0;
 
+        if (item->type == iris::RenderItemType::Mesh) {
             // if a material is set then use it and gets its shaderprogram
+            auto mat = item->material.data();
+            QOpenGLShaderProgram* program = mat != nullptr ? mat->program : item->shaderProgram;
+            Shader* shader = mat != nullptr ? mat->shader.data() : ShaderCache::getShader(program).data();
+
+            // consecutive items with the same material share its textures and properties
+            if (mat != currentMaterial) {
+                if (currentMaterial != nullptr) {
+                    currentMaterial->end(gl, scene);
+                }
 
-            if (!!item->material) {
-                mat = item->material;
-                program = mat->program;
+                currentMaterial = mat;
 
-                mat->begin(gl, scene);
-            } else {
-                program = item->shaderProgram;
-            }
+                if (mat != nullptr) {
+                    // binds the material's program and textures
+                    mat->begin(gl, scene);
+                    currentProgram = program;
 
-            // send transform and light data
-            program->setUniformValue("u_worldMatrix",   item->worldMatrix);
-            program->setUniformValue("u_viewMatrix",    renderData->viewMatrix);
-            program->setUniformValue("u_projMatrix",    renderData->projMatrix);
-            program->setUniformValue("u_normalMatrix",  item->worldMatrix.normalMatrix());
+                    renderStats.programBinds++;
+                    renderStats.textureBinds += mat->textures.size();
+                }
+            }
 
-            program->setUniformValue("u_eyePos",        renderData->eyePos);
+            if (program != currentProgram) {
+                program->bind();
+                currentProgram = program;
 
-            if (item->renderStates.fogEnabled && scene->fogEnabled ) {
-                program->setUniformValue("u_fogData.color", renderData->fogColor);
-                program->setUniformValue("u_fogData.start", renderData->fogStart);
-                program->setUniformValue("u_fogData.end",   renderData->fogEnd);
+                renderStats.programBinds++;
+            }
 
-                program->setUniformValue("u_fogData.enabled", true);
-            } else {
-                program->setUniformValue("u_fogData.enabled", false);
+            if (!programsWithFrameUniforms.contains(program)) {
+                setFrameUniforms(shader, renderData, lightSpaceMatrix);
+                programsWithFrameUniforms.insert(program);
             }
 
-            if (item->renderStates.receiveShadows && scene->shadowEnabled) {
-                program->setUniformValue("u_shadowMap", 8);
-                program->setUniformValue("u_shadowEnabled", true);
+            // send transform data
+            program->setUniformValue(shader->getUniformLocation(ShaderUniform::Instanced), isInstanced);
+            if (isInstanced) {
+                program->setUniformValue(shader->getUniformLocation(ShaderUniform::InstanceOffset),
+                                         batch.instanceOffset);
             } else {
-                program->setUniformValue("u_shadowEnabled", false);
+                program->setUniformValue(shader->getUniformLocation(ShaderUniform::WorldMatrix),
+                                         item->worldMatrix);
+                program->setUniformValue(shader->getUniformLocation(ShaderUniform::NormalMatrix),
+                                         item->worldMatrix.normalMatrix());
             }
 
-            gl->glActiveTexture(GL_TEXTURE8);
-            gl->glBindTexture(GL_TEXTURE_2D, shadowDepthMap);
+            program->setUniformValue(shader->getUniformLocation(ShaderUniform::FogEnabled),
+                                     item->renderStates.fogEnabled && scene->fogEnabled);
+            program->setUniformValue(shader->getUniformLocation(ShaderUniform::ShadowEnabled),
+                                     item->renderStates.receiveShadows && scene->shadowEnabled);
 
-            program->setUniformValue("u_lightSpaceMatrix",  lightSpaceMatrix);
-            program->setUniformValue("u_lightCount",        lightCount);
+            applyRenderStates(item->renderStates);
 
-            // only materials get lights passed to it
-            if ( item->renderStates.receiveLighting ) {
-                for (int i=0;i<lightCount;i++)
-                {
-                    QString lightPrefix = QString("u_lights[%0].").arg(i);
+            if (item->mesh != currentMesh) {
+                item->mesh->bind(gl);
+                currentMesh = item->mesh;
+            }
 
-                    auto light = renderData->scene->lights[i];
-                    if(!light->isVisible())
-                    {
-                        //quick hack for now
-                        mat->setUniformValue(lightPrefix+"color", QColor(0,0,0));
-                        continue;
+            if (renderData->stereo && shader->getUniformLocation(ShaderUniform::Stereo) != -1) {
+                // every instance is drawn once for each eye
+                item->mesh->drawBoundInstanced(gl, batch.count * 2);
+                renderStats.instancedBatches++;
+            } else if (renderData->stereo) {
+                // the clip distance is only written by stereo programs
+                gl->glDisable(GL_CLIP_DISTANCE0);
+
+                // the block holds the view of both eyes, so it's uploaded again with each eye's
+                bool usesFrameBlock = shader->usesFrameBlock();
+
+                for (int eye = 0; eye < 2; eye++) {
+                    setEyeViewport(eye);
+                    if (usesFrameBlock) {
+                        updateFrameDataView(renderData->eyeViewMatrices[eye], renderData->eyeProjMatrices[eye]);
+                    } else {
+                        program->setUniformValue(shader->getUniformLocation(ShaderUniform::ViewMatrix),
+                                                 renderData->eyeViewMatrices[eye]);
+                        program->setUniformValue(shader->getUniformLocation(ShaderUniform::ProjMatrix),
+                                                 renderData->eyeProjMatrices[eye]);
                     }
 
-                    mat->setUniformValue(lightPrefix+"type", (int)light->lightType);
-                    mat->setUniformValue(lightPrefix+"position", light->globalTransform.column(3).toVector3D());
-                    //mat->setUniformValue(lightPrefix+"direction", light->getDirection());
-                    mat->setUniformValue(lightPrefix+"distance", light->distance);
-                    mat->setUniformValue(lightPrefix+"direction", light->getLightDir());
-                    mat->setUniformValue(lightPrefix+"cutOffAngle", light->spotCutOff);
-                    mat->setUniformValue(lightPrefix+"cutOffSoftness", light->spotCutOffSoftness);
-                    mat->setUniformValue(lightPrefix+"intensity", light->intensity);
-                    mat->setUniformValue(lightPrefix+"color", light->color);
-
-                    mat->setUniformValue(lightPrefix+"constantAtten", 1.0f);
-                    mat->setUniformValue(lightPrefix+"linearAtten", 0.0f);
-                    mat->setUniformValue(lightPrefix+"quadtraticAtten", 1.0f);
+                    if (isInstanced)
+                        item->mesh->drawBoundInstanced(gl, batch.count);
+                    else
+                        item->mesh->drawBound(gl);
                 }
-            }
 
-            // set culling state
-            // FaceCullingMode::Back is the default state
-            if (item->renderStates.cullMode != FaceCullingMode::Back) {
-               switch(item->renderStates.cullMode) {
-                case FaceCullingMode::Front:
-                    gl->glCullFace(GL_FRONT);
-                break;
-               case FaceCullingMode::FrontAndBack:
-                   gl->glCullFace(GL_FRONT_AND_BACK);
-               break;
-               case FaceCullingMode::None:
-                   gl->glDisable(GL_CULL_FACE);
-               break;
-               }
+                if (usesFrameBlock)
+                    updateFrameDataView(renderData->viewMatrix, renderData->projMatrix);
+
+                renderStats.drawCalls++;
+                gl->glViewport(stereoViewport[0], stereoViewport[1], stereoViewport[2], stereoViewport[3]);
+                gl->glEnable(GL_CLIP_DISTANCE0);
+            } else if (isInstanced) {
+                item->mesh->drawBoundInstanced(gl, batch.count);
+                renderStats.instancedBatches++;
+            } else {
+                item->mesh->drawBound(gl);
             }
 
-            if (!item->renderStates.zWrite) {
-                gl->glDepthMask(false);
+            renderStats.drawCalls++;
+            renderStats.itemsDrawn += batch.count;
+        }
+        else if(item->type == iris::RenderItemType::ParticleSystem) {
+            if (currentMaterial != nullptr) {
+                currentMaterial->end(gl, scene);
+                currentMaterial = nullptr;
             }
 
-            if (!item->renderStates.depthTest) {
-                gl->glDisable(GL_DEPTH_TEST);
+            auto ps = item->sceneNode.staticCast<ParticleSystemNode>();
+            // every particle of the system is drawn with one instanced call
+            if (renderData->stereo) {
+                // the particle shader has no stereo support so it's drawn once per eye
+                gl->glDisable(GL_CLIP_DISTANCE0);
+
+                RenderData eyeData = *renderData;
+                for (int eye = 0; eye < 2; eye++) {
+                    setEyeViewport(eye);
+                    eyeData.viewMatrix = renderData->eyeViewMatrices[eye];
+                    eyeData.projMatrix = renderData->eyeProjMatrices[eye];
+                    ps->renderParticles(&eyeData, particleShader);
+                }
+
+                renderStats.drawCalls++;
+                gl->glViewport(stereoViewport[0], stereoViewport[1], stereoViewport[2], stereoViewport[3]);
+                gl->glEnable(GL_CLIP_DISTANCE0);
+            } else {
+                ps->renderParticles(renderData, particleShader);
             }
+            renderStats.programBinds++;
+            renderStats.drawCalls++;
+
+            // the particle renderer binds its own program and vao
+            // and leaves blending off and depth writes on
+            currentProgram = nullptr;
+            currentMesh = nullptr;
+            currentRenderStates.blendType = BlendType::None;
+            currentRenderStates.zWrite = true;
+        }
+    }
 
-            if (item->renderStates.blendType != BlendType::None) {
-                 gl->glEnable(GL_BLEND);
+    if (currentMaterial != nullptr) {
+        currentMaterial->end(gl, scene);
+    }
 
-                 if (item->renderStates.blendType == BlendType::Normal) {
-                     gl->glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
-                 } else if(item->renderStates.blendType == BlendType::Add) {
-                     gl->glBlendFunc(GL_ONE,GL_ONE);
-                 }
+    gl->glBindVertexArray(0);
 
-                 //todo: add more types
-             }
+    if (renderData->stereo)
+        gl->glDisable(GL_CLIP_DISTANCE0);
 
-            item->mesh->draw(gl, program);
+    // the rest of the renderer expects the default states
+    applyRenderStates(RenderStates());
+}
 
-            if (!!mat) {
-                mat->end(gl,scene);
+void ForwardRenderer::buildRenderBatches()
+{
+    renderBatches.clear();
+    instanceBuffer->clear();
+
+    const auto& items = renderQueue.items;
+    for (int i = 0; i < items.size();) {
+        auto first = items[i].item;
+        int count = 1;
+
+        // the queue is sorted by material then mesh so identical items are next to each other
+        if (canInstance(first)) {
+            int maxCount = instanceBuffer->getMaxCount() - instanceBuffer->getCount();
+            while (i + count < items.size() && count < maxCount &&
+                   isSameBatch(first, items[i + count].item)) {
+                count++;
             }
+        }
+
+        RenderBatch batch;
+        batch.start = i;
+        batch.count = count;
+        batch.instanceOffset = -1;
+
+        if (count > 1) {
+            batch.instanceOffset = instanceBuffer->getCount();
+            for (int j = i; j < i + count; j++)
+                instanceBuffer->add(items[j].item->worldMatrix);
+        }
+
+        renderBatches.append(batch);
+        i += count;
+    }
+
+    instanceBuffer->upload();
+}
+
+void ForwardRenderer::updateUniformBuffers(RenderData* renderData, const QMatrix4x4& lightSpaceMatrix)
+{
+    auto scene = renderData->scene;
+
+    memcpy(frameData.viewMatrix, renderData->viewMatrix.constData(), sizeof(frameData.viewMatrix));
+    memcpy(frameData.projMatrix, renderData->projMatrix.constData(), sizeof(frameData.projMatrix));
+    memcpy(frameData.lightSpaceMatrix, lightSpaceMatrix.constData(), sizeof(frameData.lightSpaceMatrix));
+
+    frameData.eyePos[0] = renderData->eyePos.x();
+    frameData.eyePos[1] = renderData->eyePos.y();
+    frameData.eyePos[2] = renderData->eyePos.z();
+
+    frameData.fogColor[0] = renderData->fogColor.redF();
+    frameData.fogColor[1] = renderData->fogColor.greenF();
+    frameData.fogColor[2] = renderData->fogColor.blueF();
+    frameData.fogColor[3] = renderData->fogColor.alphaF();
+    frameData.fogStart = renderData->fogStart;
+    frameData.fogEnd = renderData->fogEnd;
+
+    frameData.shadowCascadeCount = shadowCascades.count;
+    for (int i = 0; i < SHADER_MAX_SHADOW_CASCADES; i++) {
+        memcpy(frameData.shadowMatrices[i], shadowCascades.atlasMatrices[i].constData(), sizeof(frameData.shadowMatrices[i]));
+
+        frameData.shadowTiles[i][0] = shadowCascades.tiles[i].x();
+        frameData.shadowTiles[i][1] = shadowCascades.tiles[i].y();
+        frameData.shadowTiles[i][2] = shadowCascades.tiles[i].z();
+        frameData.shadowTiles[i][3] = shadowCascades.tiles[i].w();
+
+        frameData.shadowSplits[i] = shadowCascades.splits[i];
+    }
+
+    LightDataBlock lightData;
+    memset(&lightData, 0, sizeof(lightData));
+
+    // directional lights reach every fragment so they stay in the block,
+    // the others are binned into the clusters of this view
+    lightClusters->clear();
+
+    for (auto light : scene->lights) {
+        if (!light->isVisible())
+            continue;
+
+        auto pos = light->globalTransform.column(3).toVector3D();
+        auto dir = light->getLightDir();
+
+        if (light->lightType != LightType::Directional) {
+            lightClusters->addLight((int)light->lightType, pos, dir, light->distance,
+                                    light->color, light->intensity,
+                                    light->spotCutOff, light->spotCutOffSoftness);
+            continue;
+        }
+
+        // the shaders' light array has a fixed size, extra lights are ignored
+        if (lightData.lightCount == SHADER_MAX_LIGHTS)
+            continue;
+
+        auto& entry = lightData.lights[lightData.lightCount++];
+
+        entry.color[0] = light->color.redF();
+        entry.color[1] = light->color.greenF();
+        entry.color[2] = light->color.blueF();
+        entry.color[3] = light->color.alphaF();
+
+        entry.position[0] = pos.x();
+        entry.position[1] = pos.y();
+        entry.position[2] = pos.z();
+        entry.type = (int)light->lightType;
 
-            if (item->renderStates.blendType!=BlendType::None) {
-                gl->glDisable(GL_BLEND);
+        entry.direction[0] = dir.x();
+        entry.direction[1] = dir.y();
+        entry.direction[2] = dir.z();
+        entry.distance = light->distance;
+
+        entry.intensity = light->intensity;
+        entry.cutOffAngle = light->spotCutOff;
+        entry.cutOffSoftness = light->spotCutOffSoftness;
+    }
+
+    lightClusters->build(renderData->viewMatrix, renderData->projMatrix);
+    lightClusters->upload();
+
+    frameData.clusterDepthScale = lightClusters->getDepthScale();
+    frameData.clusterDepthBias = lightClusters->getDepthBias();
+
+    for (int eye = 0; eye < 2; eye++) {
+        const auto& eyeView = renderData->stereo ? renderData->eyeViewMatrices[eye] : renderData->viewMatrix;
+        const auto& eyeProj = renderData->stereo ? renderData->eyeProjMatrices[eye] : renderData->projMatrix;
+        memcpy(frameData.eyeViewMatrices[eye], eyeView.constData(), sizeof(frameData.eyeViewMatrices[eye]));
+        memcpy(frameData.eyeProjMatrices[eye], eyeProj.constData(), sizeof(frameData.eyeProjMatrices[eye]));
+    }
+
+    memcpy(frameData.sharedViewMatrix, renderData->viewMatrix.constData(), sizeof(frameData.sharedViewMatrix));
+    memcpy(frameData.sharedProjMatrix, renderData->projMatrix.constData(), sizeof(frameData.sharedProjMatrix));
+
+    frameDataBuffer->update(&frameData);
+    lightDataBuffer->update(&lightData);
+
+    frameDataBuffer->bind();
+    lightDataBuffer->bind();
+}
+
+void ForwardRenderer::updateFrameDataView(const QMatrix4x4& viewMatrix, const QMatrix4x4& projMatrix)
+{
+    memcpy(frameData.viewMatrix, viewMatrix.constData(), sizeof(frameData.viewMatrix));
+    memcpy(frameData.projMatrix, projMatrix.constData(), sizeof(frameData.projMatrix));
+    frameDataBuffer->update(&frameData);
+}
+
+void ForwardRenderer::setFrameUniforms(Shader* shader,
+                                       RenderData* renderData,
+                                       const QMatrix4x4& lightSpaceMatrix)
+{
+    auto scene = renderData->scene;
+    auto program = shader->program;
+
+    // samplers cant be in a uniform block
+    program->setUniformValue(shader->getUniformLocation(ShaderUniform::ShadowMap),    8);
+    program->setUniformValue(shader->getUniformLocation(ShaderUniform::InstanceData), INSTANCE_DATA_TEXTURE_UNIT);
+    program->setUniformValue(shader->getUniformLocation(ShaderUniform::Stereo),       renderData->stereo);
+    program->setUniformValue(shader->getUniformLocation(ShaderUniform::ClusterLights), LIGHT_CLUSTER_LIGHTS_TEXTURE_UNIT);
+    program->setUniformValue(shader->getUniformLocation(ShaderUniform::ClusterData), LIGHT_CLUSTER_DATA_TEXTURE_UNIT);
+
+    if (!shader->usesFrameBlock()) {
+        program->setUniformValue(shader->getUniformLocation(ShaderUniform::ViewMatrix),   renderData->viewMatrix);
+        program->setUniformValue(shader->getUniformLocation(ShaderUniform::ProjMatrix),   renderData->projMatrix);
+        program->setUniformValue(shader->getUniformLocation(ShaderUniform::EyePos),       renderData->eyePos);
+
+        program->setUniformValue(shader->getUniformLocation(ShaderUniform::FogColor),     renderData->fogColor);
+        program->setUniformValue(shader->getUniformLocation(ShaderUniform::FogStart),     renderData->fogStart);
+        program->setUniformValue(shader->getUniformLocation(ShaderUniform::FogEnd),       renderData->fogEnd);
+
+        program->setUniformValue(shader->getUniformLocation(ShaderUniform::LightSpaceMatrix), lightSpaceMatrix);
+    }
+
+    if (shader->usesLightBlock())
+        return;
+
+    // the shaders' light array has a fixed size, extra lights are ignored
+    auto lightCount = qMin(scene->lights.size(), SHADER_MAX_LIGHTS);
+    program->setUniformValue(shader->getUniformLocation(ShaderUniform::LightCount),   lightCount);
+
+    // programs that arent lit dont have these uniforms so their locations are -1 and setting them does nothing
+    for (int i=0;i<lightCount;i++)
+    {
+        auto& loc = shader->getLightLocations(i);
+
+        auto light = scene->lights[i];
+        if(!light->isVisible())
+        {
+            //quick hack for now
+            program->setUniformValue(loc.color, QColor(0,0,0));
+            continue;
+        }
+
+        program->setUniformValue(loc.type,              (int)light->lightType);
+        program->setUniformValue(loc.position,          light->globalTransform.column(3).toVector3D());
+        program->setUniformValue(loc.distance,          light->distance);
+        program->setUniformValue(loc.direction,         light->getLightDir());
+        program->setUniformValue(loc.cutOffAngle,       light->spotCutOff);
+        program->setUniformValue(loc.cutOffSoftness,    light->spotCutOffSoftness);
+        program->setUniformValue(loc.intensity,         light->intensity);
+        program->setUniformValue(loc.color,             light->color);
+
+        program->setUniformValue(loc.constantAtten,     1.0f);
+        program->setUniformValue(loc.linearAtten,       0.0f);
+        program->setUniformValue(loc.quadraticAtten,    1.0f);
+    }
+}
+
+void ForwardRenderer::resetRenderStates()
+{
+    gl->glEnable(GL_CULL_FACE);
+    gl->glCullFace(GL_BACK);
+    gl->glDisable(GL_BLEND);
+    gl->glDepthMask(true);
+    gl->glEnable(GL_DEPTH_TEST);
+
+    currentRenderStates = RenderStates();
+}
+
+void ForwardRenderer::applyRenderStates(const RenderStates& states)
+{
+    // FaceCullingMode::Back is the default state
+    if (states.cullMode != currentRenderStates.cullMode) {
+        if (states.cullMode == FaceCullingMode::None) {
+            gl->glDisable(GL_CULL_FACE);
+        } else {
+            if (currentRenderStates.cullMode == FaceCullingMode::None) {
+                gl->glEnable(GL_CULL_FACE);
             }
 
-            // change back culling state
-            if (item->renderStates.cullMode != FaceCullingMode::Back) {
+            switch(states.cullMode) {
+            case FaceCullingMode::Front:
+                gl->glCullFace(GL_FRONT);
+                break;
+            case FaceCullingMode::FrontAndBack:
+                gl->glCullFace(GL_FRONT_AND_BACK);
+                break;
+            default:
                 gl->glCullFace(GL_BACK);
-            } else if(item->renderStates.cullMode != FaceCullingMode::None) {
-                gl->glEnable(GL_CULL_FACE);
+                break;
             }
+        }
+
+        currentRenderStates.cullMode = states.cullMode;
+        renderStats.stateChanges++;
+    }
 
-            if (!item->renderStates.zWrite) {
-                gl->glDepthMask(true);
+    if (states.blendType != currentRenderStates.blendType) {
+        if (states.blendType == BlendType::None) {
+            gl->glDisable(GL_BLEND);
+        } else {
+            if (currentRenderStates.blendType == BlendType::None) {
+                gl->glEnable(GL_BLEND);
             }
 
-            if (!item->renderStates.depthTest) {
-                gl->glEnable(GL_DEPTH_TEST);
+            if (states.blendType == BlendType::Normal) {
+                gl->glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+            } else if(states.blendType == BlendType::Add) {
+                gl->glBlendFunc(GL_ONE,GL_ONE);
             }
-        }
-        else if(item->type == iris::RenderItemType::ParticleSystem) {
 
-            auto ps = item->sceneNode.staticCast<ParticleSystemNode>();
-            ps->renderParticles(renderData, particleShader);
+            //todo: add more types
         }
+
+        currentRenderStates.blendType = states.blendType;
+        renderStats.stateChanges++;
+    }
+
+    if (states.zWrite != currentRenderStates.zWrite) {
+        gl->glDepthMask(states.zWrite);
+
+        currentRenderStates.zWrite = states.zWrite;
+        renderStats.stateChanges++;
     }
 
+    if (states.depthTest != currentRenderStates.depthTest) {
+        if (states.depthTest) {
+            gl->glEnable(GL_DEPTH_TEST);
+        } else {
+            gl->glDisable(GL_DEPTH_TEST);
+        }
+
+        currentRenderStates.depthTest = states.depthTest;
+        renderStats.stateChanges++;
+    }
 }
 
 void ForwardRenderer::renderSky(RenderData* renderData)
@@ -628,17 +1242,10 @@ void ForwardRenderer::createShadowShader()
 
 void ForwardRenderer::createParticleShader()
 {
-    QOpenGLShader *vshader = new QOpenGLShader(QOpenGLShader::Vertex);
-    vshader->compileSourceFile(":app/shaders/particle.vert");
-
-    QOpenGLShader *fshader = new QOpenGLShader(QOpenGLShader::Fragment);
-    fshader->compileSourceFile(":app/shaders/particle.frag");
-
-    particleShader = new QOpenGLShaderProgram;
-    particleShader->addShader(vshader);
-    particleShader->addShader(fshader);
-
-    particleShader->link();
+    // loaded through the helper so it's cached like the other built-in programs
+    // the particle renderer expects a_pos at 0 and a_texCoord at 1, which the helper binds
+    particleShader = GraphicsHelper::loadShader(":app/shaders/particle.vert",
+                                                ":app/shaders/particle.frag");
 
     particleShader->bind();
 }
@@ -651,7 +1258,16 @@ void ForwardRenderer::createEmitterShader()
 
 ForwardRenderer::~ForwardRenderer()
 {
-    delete vrDevice;
+    gl->glDeleteTextures(1, &shadowDepthMap);
+    gl->glDeleteFramebuffers(1, &shadowFBO);
+    gl->glDeleteTextures(1, &staticShadowDepthMap);
+    gl->glDeleteFramebuffers(1, &staticShadowFBO);
+
+    // the device is shared by every renderer, VrManager owns it
+    delete frameDataBuffer;
+    delete lightDataBuffer;
+    delete instanceBuffer;
+    delete lightClusters;
 }
 
 }
@@ -17,8 +17,12 @@ For more information see the LICENSE file
 //#include "../libovr/Include/OVR_CAPI_GL.h"
 #include "../irisglfwd.h"
 
-#include "particle.h"
 #include "particlerender.h"
+#include "renderitem.h"
+#include "renderqueue.h"
+#include "shadowcascades.h"
+#include "lightclusters.h"
+#include "uniformblocks.h"
 
 #define OUTLINE_STENCIL_CHANNEL 1
 
@@ -40,6 +44,73 @@ class FullScreenQuad;
 class VrDevice;
 class PostProcessManager;
 class PostProcessContext;
+class RenderItem;
+class UniformBuffer;
+class InstanceBuffer;
+
+/**
+ * Counters for the last rendered frame. In vr mode without single pass stereo the scene counters
+ * are summed over both eyes.
+ */
+struct RenderStats
+{
+    // mesh items that passed the frustum test and were drawn
+    int itemsDrawn;
+    // mesh items outside of the camera's frustum
+    int itemsCulled;
+
+    int shadowItemsDrawn;
+    // shadow casters outside of the light's frustum
+    int shadowItemsCulled;
+
+    // glUseProgram calls made by the scene pass
+    int programBinds;
+    // textures bound by the scene pass
+    int textureBinds;
+    // cull, blend, depth write and depth test changes
+    int stateChanges;
+
+    // draw calls made by the scene pass
+    int drawCalls;
+    // draw calls that drew several items at once
+    int instancedBatches;
+
+    // cascades whose static shadow layer was redrawn and cascades that reused it
+    int shadowCacheRebuilds;
+    int shadowCacheHits;
+
+    RenderStats()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        itemsDrawn = 0;
+        itemsCulled = 0;
+        shadowItemsDrawn = 0;
+        shadowItemsCulled = 0;
+        programBinds = 0;
+        textureBinds = 0;
+        stateChanges = 0;
+        drawCalls = 0;
+        instancedBatches = 0;
+        shadowCacheRebuilds = 0;
+        shadowCacheHits = 0;
+    }
+};
+
+/**
+ * A run of consecutive render queue items that is drawn with one draw call.
+ * Items that cant be instanced are batches of one.
+ */
+struct RenderBatch
+{
+    int start;
+    int count;
+    // index of the first item's transforms in the instance buffer, -1 if not instanced
+    int instanceOffset;
+};
 
 /**
  * This is a basic forward renderer.
@@ -75,6 +146,32 @@ class ForwardRenderer
     Texture2DPtr depthRenderTexture;
     Texture2DPtr finalRenderTexture;
 
+    // items from the scene's geometry list that survived frustum culling
+    RenderQueue renderQueue;
+    RenderStats renderStats;
+
+    // gl states as last set by the scene pass
+    RenderStates currentRenderStates;
+
+    // per-frame camera, fog and light data shared by every program that declares the blocks
+    UniformBuffer* frameDataBuffer;
+    UniformBuffer* lightDataBuffer;
+    // contents of frameDataBuffer as last uploaded
+    FrameDataBlock frameData;
+
+    // transforms of the instanced batches of the current pass
+    InstanceBuffer* instanceBuffer;
+    QVector<RenderBatch> renderBatches;
+
+    // point and spot lights binned into the clusters of the current view
+    LightClusters* lightClusters;
+
+    bool stereoRendering;
+
+    // cascades of the shadow casting light fitted to the current view
+    ShadowSettings shadowSettings;
+    ShadowCascades shadowCascades;
+
 public:
 
     /**
@@ -98,6 +195,53 @@ public:
 
     PostProcessManagerPtr getPostProcessManager();
 
+    const RenderStats& getRenderStats() const
+    {
+        return renderStats;
+    }
+
+    /**
+     * Returns the light counts and binning time of the last view rendered
+     */
+    const LightClusterStats& getLightClusterStats() const
+    {
+        return lightClusters->getStats();
+    }
+
+    /**
+     * Sets the number, resolution and range of the shadow cascades.
+     * The shadow atlas is reallocated if its size changes.
+     */
+    void setShadowSettings(const ShadowSettings& settings);
+
+    const ShadowSettings& getShadowSettings() const
+    {
+        return shadowSettings;
+    }
+
+    /**
+     * Returns the shadow atlas of the last frame, a depth texture with a tile per cascade
+     */
+    GLuint getShadowMap() const
+    {
+        return shadowDepthMap;
+    }
+
+    /**
+     * Draws both eyes in one pass in vr. Items are culled and submitted once and drawn
+     * to both halves of a side by side target with instancing. Programs that dont
+     * include instancing.glsl are drawn once per eye instead. On by default.
+     */
+    void setStereoRenderingEnabled(bool enabled)
+    {
+        stereoRendering = enabled;
+    }
+
+    bool isStereoRenderingEnabled() const
+    {
+        return stereoRendering;
+    }
+
     static ForwardRendererPtr create();
 
     bool isVrSupported();
@@ -108,6 +252,23 @@ private:
     ForwardRenderer();
 
     void renderNode(RenderData* renderData, ScenePtr node);
+    // fills the uniform buffers, called once per frame or once per eye in vr
+    void updateUniformBuffers(RenderData* renderData, const QMatrix4x4& lightSpaceMatrix);
+    // uploads the FrameData block with another view and projection, for drawing one eye in stereo
+    void updateFrameDataView(const QMatrix4x4& viewMatrix, const QMatrix4x4& projMatrix);
+
+    // sets the per-frame data as plain uniforms for programs that dont use the uniform blocks
+    void setFrameUniforms(Shader* shader,
+                          RenderData* renderData,
+                          const QMatrix4x4& lightSpaceMatrix);
+
+    // groups the sorted render queue into batches and fills the instance buffer
+    void buildRenderBatches();
+
+    // puts gl in the default states and syncs currentRenderStates with it
+    void resetRenderStates();
+    // only changes the states that differ from currentRenderStates
+    void applyRenderStates(const RenderStates& states);
     void renderSky(RenderData* renderData);
     void renderBillboardIcons(RenderData* renderData);
     void renderSelectedNode(RenderData* renderData, QSharedPointer<SceneNode> node);
@@ -120,8 +281,23 @@ private:
     GLuint shadowDepthMap;
 
     void createShadowShader();
-    void renderShadows(ScenePtr node);
-    void generateShadowBuffer(GLuint size = 1024);
+    // renders the cascades of the first directional light fitted to the given view
+    void renderShadows(ScenePtr node, const QMatrix4x4& viewMatrix, const QMatrix4x4& projMatrix);
+    // draws either the static or the dynamic casters inside the light space volume
+    void renderShadowCasters(const QMatrix4x4& lightSpaceMatrix, bool staticCasters);
+    void generateShadowBuffer();
+    // (re)allocates the shadow atlas for the current settings
+    void allocateShadowMap();
+    int shadowMapSize;
+
+    // depth of the casters that havent moved for a while, copied into the shadow atlas
+    // every frame before the moving casters are drawn on top.
+    // a cascade's layer is redrawn when its light space matrix or the static casters change
+    GLuint staticShadowFBO;
+    GLuint staticShadowDepthMap;
+    bool staticShadowValid[SHADER_MAX_SHADOW_CASCADES];
+    QMatrix4x4 staticShadowMatrices[SHADER_MAX_SHADOW_CASCADES];
+    quint64 staticCasterHash;
 
     //editor-specific
     iris::Billboard* billboard;
@@ -11,6 +11,8 @@ For more information see the LICENSE file
 
 #include "graphicshelper.h"
 #include <QOpenGLShaderProgram>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
 
 #include "../graphics/mesh.h"
 #include "assimp/postprocess.h"
@@ -23,48 +25,120 @@ For more information see the LICENSE file
 
 #include <QFile>
 #include <QFileInfo>
+#include <QElapsedTimer>
 
 #include "../graphics/vertexlayout.h"
+#include "../graphics/uniformblocks.h"
+#include "../graphics/shadercache.h"
+#include "../graphics/programbinarycache.h"
 
 namespace iris
 {
 
+namespace
+{
+
+struct AttribBinding
+{
+    const char* name;
+    VertexAttribUsage usage;
+};
+
+// attribute locations every program is linked with
+const AttribBinding attribBindings[] = {
+    {"a_pos",       VertexAttribUsage::Position},
+    {"a_texCoord",  VertexAttribUsage::TexCoord0},
+    {"a_texCoord1", VertexAttribUsage::TexCoord1},
+    {"a_texCoord2", VertexAttribUsage::TexCoord2},
+    {"a_texCoord3", VertexAttribUsage::TexCoord3},
+    {"a_normal",    VertexAttribUsage::Normal},
+    {"a_tangent",   VertexAttribUsage::Tangent}
+};
+
+const int attribBindingCount = sizeof(attribBindings) / sizeof(attribBindings[0]);
+
+// the bindings are part of a program's identity in the shader cache
+QString getAttribBindingsKey()
+{
+    QString key;
+    for (int i = 0; i < attribBindingCount; i++) {
+        key += QString("%1=%2;").arg(attribBindings[i].name).arg((int)attribBindings[i].usage);
+    }
+
+    return key;
+}
+
+}
+
 QOpenGLShaderProgram* GraphicsHelper::loadShader(QString vsPath,QString fsPath)
 {
-    QOpenGLShader *vshader = new QOpenGLShader(QOpenGLShader::Vertex);
     auto vsShader = loadAndProcessShader(vsPath);
-    vshader->compileSourceCode(vsShader);
-
-    QOpenGLShader *fshader = new QOpenGLShader(QOpenGLShader::Fragment);
     auto fsShader = loadAndProcessShader(fsPath);
-    fshader->compileSourceCode(fsShader);
+    auto bindingsKey = getAttribBindingsKey();
+
+    // materials loading the same files share one program
+    auto key = ShaderCache::createProgramKey(vsShader, fsShader, bindingsKey);
+    auto program = ShaderCache::findProgram(key);
+    if (program != nullptr)
+        return program;
+
+    program = new QOpenGLShaderProgram;
+
+    // a binary saved by a previous run skips compiling and linking
+    auto binaryKey = ProgramBinaryCache::createKey(vsShader, fsShader, bindingsKey);
+    if (!ProgramBinaryCache::load(program, binaryKey)) {
+        QElapsedTimer timer;
+        timer.start();
 
-    auto program = new QOpenGLShaderProgram;
-    program->addShader(vshader);
-    program->addShader(fshader);
+        QOpenGLShader *vshader = new QOpenGLShader(QOpenGLShader::Vertex);
+        vshader->compileSourceCode(vsShader);
 
-    program->bindAttributeLocation("a_pos",(int)VertexAttribUsage::Position);
-    program->bindAttributeLocation("a_texCoord",(int)VertexAttribUsage::TexCoord0);
-    program->bindAttributeLocation("a_texCoord1",(int)VertexAttribUsage::TexCoord1);
-    program->bindAttributeLocation("a_texCoord2",(int)VertexAttribUsage::TexCoord2);
-    program->bindAttributeLocation("a_texCoord3",(int)VertexAttribUsage::TexCoord3);
-    program->bindAttributeLocation("a_normal",(int)VertexAttribUsage::Normal);
-    program->bindAttributeLocation("a_tangent",(int)VertexAttribUsage::Tangent);
+        QOpenGLShader *fshader = new QOpenGLShader(QOpenGLShader::Fragment);
+        fshader->compileSourceCode(fsShader);
 
-    program->link();
+        program->addShader(vshader);
+        program->addShader(fshader);
+
+        for (int i = 0; i < attribBindingCount; i++) {
+            program->bindAttributeLocation(attribBindings[i].name, (int)attribBindings[i].usage);
+        }
+
+        ProgramBinaryCache::prepare(program);
+        program->link();
+
+        ProgramBinaryCache::addCompileTime(timer.nsecsElapsed() / 1000000.0f);
+        ProgramBinaryCache::save(program, binaryKey);
+    }
+
+    bindUniformBlocks(program);
+
+    ShaderCache::addProgram(key, program);
 
     return program;
 }
 
+void GraphicsHelper::bindUniformBlocks(QOpenGLShaderProgram* program)
+{
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+    auto programId = program->programId();
+
+    // shaders written without the blocks keep using plain uniforms
+    GLuint frameIndex = gl->glGetUniformBlockIndex(programId, "FrameData");
+    if (frameIndex != GL_INVALID_INDEX)
+        gl->glUniformBlockBinding(programId, frameIndex, (GLuint)UniformBlockBinding::FrameData);
+
+    GLuint lightIndex = gl->glGetUniformBlockIndex(programId, "LightData");
+    if (lightIndex != GL_INVALID_INDEX)
+        gl->glUniformBlockBinding(programId, lightIndex, (GLuint)UniformBlockBinding::LightData);
+}
+
 QString GraphicsHelper::loadAndProcessShader(QString shaderPath)
 {
     QRegExp internalFileInclude("\\<(.+\\\\)*((.+)\\.(.+))\\>");
     QRegExp externalFileInclude("\\\"(.+\\\\)*((.+)\\.(.+))\\\"");
 
-    QFile file(shaderPath);
-    file.open(QIODevice::ReadOnly | QIODevice::Text);
-
-    auto text = file.readAll();
+    // includes are usually shared by many shaders so files are only read once
+    auto text = ShaderCache::readFile(shaderPath);
     auto lines = text.split('\n');
 
     for (int i = 0; i < lines.count(); ++i) {
@@ -28,6 +28,13 @@ public:
 
     static QString loadAndProcessShader(QString shaderPath);
 
+    /**
+     * Assigns the engine's uniform blocks in program to their binding points.
+     * Blocks the program doesnt declare are skipped.
+     * @param program a linked program
+     */
+    static void bindUniformBlocks(QOpenGLShaderProgram* program);
+
     /**
      * Loads all meshes from mesh file
      * Useful for loading a mesh file containing multiple meshes
@@ -0,0 +1,97 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "instancebuffer.h"
+#include <QOpenGLFunctions_3_2_Core>
+#include <cstring>
+
+namespace iris
+{
+
+InstanceBuffer::InstanceBuffer(QOpenGLFunctions_3_2_Core* gl)
+{
+    this->gl = gl;
+    count = 0;
+    capacity = 0;
+
+    GLint maxTexels = 0;
+    gl->glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    maxCount = maxTexels / texelsPerInstance;
+
+    gl->glGenBuffers(1, &bufferId);
+    gl->glGenTextures(1, &textureId);
+
+    // the texture is a view of the buffer, it stays attached when the storage is reallocated
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, bufferId);
+    gl->glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, textureId);
+    gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, bufferId);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, 0);
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    gl->glDeleteTextures(1, &textureId);
+    gl->glDeleteBuffers(1, &bufferId);
+}
+
+void InstanceBuffer::clear()
+{
+    data.resize(0);
+    count = 0;
+}
+
+int InstanceBuffer::add(const QMatrix4x4& worldMatrix)
+{
+    auto normalMatrix = worldMatrix.normalMatrix();
+
+    int offset = data.size();
+    data.resize(offset + texelsPerInstance * 4);
+    auto dest = data.data() + offset;
+
+    // both matrices are stored column-major like their gl counterparts
+    std::memcpy(dest, worldMatrix.constData(), sizeof(float) * 16);
+    dest += 16;
+
+    for (int column = 0; column < 3; column++) {
+        dest[0] = normalMatrix(0, column);
+        dest[1] = normalMatrix(1, column);
+        dest[2] = normalMatrix(2, column);
+        dest[3] = 0.0f;
+        dest += 4;
+    }
+
+    return count++;
+}
+
+void InstanceBuffer::upload()
+{
+    if (count == 0)
+        return;
+
+    // grows to the largest frame seen so far
+    capacity = qMax(capacity, count);
+    int size = capacity * texelsPerInstance * 4 * sizeof(float);
+
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, bufferId);
+    gl->glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    gl->glBufferSubData(GL_TEXTURE_BUFFER, 0, data.size() * sizeof(float), data.constData());
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void InstanceBuffer::bind()
+{
+    gl->glActiveTexture(GL_TEXTURE0 + INSTANCE_DATA_TEXTURE_UNIT);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, textureId);
+}
+
+}
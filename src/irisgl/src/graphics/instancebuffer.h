@@ -0,0 +1,90 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef INSTANCEBUFFER_H
+#define INSTANCEBUFFER_H
+
+#include <qopengl.h>
+#include <QMatrix4x4>
+#include <QVector>
+
+class QOpenGLFunctions_3_2_Core;
+
+// texture unit u_instanceData is read from, the shadow map uses unit 8
+#define INSTANCE_DATA_TEXTURE_UNIT 9
+
+namespace iris
+{
+
+/**
+ * Per-frame transforms of instanced draws.
+ * gl 3.2 has no vertex attribute divisors so the transforms are kept in a texture
+ * buffer and fetched with gl_InstanceID in the vertex shader (see instancing.glsl).
+ * Each instance is seven rgba32f texels: the columns of its world matrix followed
+ * by the columns of its normal matrix.
+ */
+class InstanceBuffer
+{
+public:
+    static const int texelsPerInstance = 7;
+
+    InstanceBuffer(QOpenGLFunctions_3_2_Core* gl);
+    ~InstanceBuffer();
+
+    /**
+     * Removes every instance, the gpu storage is kept
+     */
+    void clear();
+
+    /**
+     * Adds an instance and returns its index in the buffer
+     */
+    int add(const QMatrix4x4& worldMatrix);
+
+    int getCount() const
+    {
+        return count;
+    }
+
+    /**
+     * Returns the number of instances the gpu's texture buffer size limit allows
+     */
+    int getMaxCount() const
+    {
+        return maxCount;
+    }
+
+    /**
+     * Uploads the instances added since the last clear. The storage is orphaned
+     * so updating more than once per frame (once per eye in vr) doesnt stall.
+     */
+    void upload();
+
+    /**
+     * Binds the buffer's texture to INSTANCE_DATA_TEXTURE_UNIT
+     */
+    void bind();
+
+private:
+    QOpenGLFunctions_3_2_Core* gl;
+    GLuint bufferId;
+    GLuint textureId;
+
+    QVector<float> data;
+    int count;
+    // instances the gpu storage can hold
+    int capacity;
+    int maxCount;
+};
+
+}
+
+#endif // INSTANCEBUFFER_H
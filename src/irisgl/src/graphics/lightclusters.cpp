@@ -0,0 +1,314 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "lightclusters.h"
+#include "../core/jobsystem.h"
+#include <QOpenGLFunctions_3_2_Core>
+#include <QElapsedTimer>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace iris
+{
+
+LightClusters::LightClusters(QOpenGLFunctions_3_2_Core* gl)
+{
+    this->gl = gl;
+    nearClip = 0.1f;
+    farClip = 1000.0f;
+    depthScale = 0;
+    depthBias = 0;
+    lightCapacity = 0;
+    clusterCapacity = 0;
+
+    std::memset(&stats, 0, sizeof(stats));
+
+    gl->glGenBuffers(1, &lightBufferId);
+    gl->glGenTextures(1, &lightTextureId);
+    gl->glGenBuffers(1, &clusterBufferId);
+    gl->glGenTextures(1, &clusterTextureId);
+
+    // the textures are views of the buffers, they stay attached when the storage is reallocated
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, lightBufferId);
+    gl->glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, lightTextureId);
+    gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightBufferId);
+
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, clusterBufferId);
+    gl->glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, clusterTextureId);
+    gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, clusterBufferId);
+
+    gl->glBindTexture(GL_TEXTURE_BUFFER, 0);
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+LightClusters::~LightClusters()
+{
+    gl->glDeleteTextures(1, &lightTextureId);
+    gl->glDeleteBuffers(1, &lightBufferId);
+    gl->glDeleteTextures(1, &clusterTextureId);
+    gl->glDeleteBuffers(1, &clusterBufferId);
+}
+
+void LightClusters::clear()
+{
+    lightData.resize(0);
+    lightBounds.resize(0);
+}
+
+int LightClusters::addLight(int type,
+                            const QVector3D& position,
+                            const QVector3D& direction,
+                            float distance,
+                            const QColor& color,
+                            float intensity,
+                            float cutOffAngle,
+                            float cutOffSoftness)
+{
+    int offset = lightData.size();
+    lightData.resize(offset + texelsPerLight * 4);
+    auto dest = lightData.data() + offset;
+
+    // same fields as the Light struct in uniform_blocks.glsl
+    dest[0] = color.redF();
+    dest[1] = color.greenF();
+    dest[2] = color.blueF();
+    dest[3] = color.alphaF();
+
+    dest[4] = position.x();
+    dest[5] = position.y();
+    dest[6] = position.z();
+    dest[7] = type;
+
+    dest[8] = direction.x();
+    dest[9] = direction.y();
+    dest[10] = direction.z();
+    dest[11] = distance;
+
+    dest[12] = intensity;
+    dest[13] = cutOffAngle;
+    dest[14] = cutOffSoftness;
+    dest[15] = 0.0f;
+
+    // spot lights are binned by their whole sphere, the cone is only tested per fragment
+    lightBounds.append(QVector4D(position, distance));
+
+    return lightBounds.size() - 1;
+}
+
+void LightClusters::build(const QMatrix4x4& viewMatrix, const QMatrix4x4& projMatrix)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // near and far planes of a perspective projection
+    nearClip = projMatrix(2, 3) / (projMatrix(2, 2) - 1.0f);
+    farClip = projMatrix(2, 3) / (projMatrix(2, 2) + 1.0f);
+    depthScale = gridDepth / std::log(farClip / nearClip);
+    depthBias = -std::log(nearClip) * depthScale;
+
+    auto getSlice = [this](float depth) {
+        return qBound(0, (int)(std::log(depth) * depthScale + depthBias), gridDepth - 1);
+    };
+
+    // rays through the corners of the tiles, scaled to a depth of 1
+    auto invProj = projMatrix.inverted();
+    for (int y = 0; y <= gridHeight; y++) {
+        for (int x = 0; x <= gridWidth; x++) {
+            auto nearPoint = invProj.map(QVector3D(x * 2.0f / gridWidth - 1.0f,
+                                                   y * 2.0f / gridHeight - 1.0f,
+                                                   -1.0f));
+            tileRays[y * (gridWidth + 1) + x] = nearPoint / -nearPoint.z();
+        }
+    }
+
+    int lightCount = lightBounds.size();
+    int visibleLights = 0;
+    viewLights.resize(lightCount);
+
+    for (int i = 0; i < lightCount; i++) {
+        auto& light = viewLights[i];
+        light.center = viewMatrix.map(lightBounds[i].toVector3D());
+        light.radius = lightBounds[i].w();
+
+        // the camera looks down -z
+        float minDepth = -light.center.z() - light.radius;
+        float maxDepth = -light.center.z() + light.radius;
+        if (maxDepth < nearClip || minDepth > farClip) {
+            light.firstSlice = 1;
+            light.lastSlice = 0;
+            continue;
+        }
+
+        light.firstSlice = getSlice(qMax(minDepth, nearClip));
+        light.lastSlice = getSlice(qMin(maxDepth, farClip));
+        visibleLights++;
+    }
+
+    clusterLists.resize(clusterCount * maxLightsPerCluster);
+    clusterCounts.fill(0, clusterCount);
+    sliceOverflows.fill(0, gridDepth);
+
+    JobSystem::parallelFor(gridDepth, [&](int slice) {
+        buildSlice(slice, projMatrix);
+    });
+
+    // the fixed size lists are packed after the cluster headers
+    int indexCount = 0;
+    int clustersUsed = 0;
+    for (auto count : clusterCounts) {
+        indexCount += count;
+        clustersUsed += count > 0;
+    }
+
+    clusterData.resize(clusterCount * 2 + indexCount);
+    int offset = clusterCount * 2;
+    for (int i = 0; i < clusterCount; i++) {
+        int count = clusterCounts[i];
+        clusterData[i * 2] = offset;
+        clusterData[i * 2 + 1] = count;
+
+        std::memcpy(clusterData.data() + offset,
+                    clusterLists.constData() + i * maxLightsPerCluster,
+                    count * sizeof(quint32));
+        offset += count;
+    }
+
+    int overflowCount = 0;
+    for (auto overflow : sliceOverflows)
+        overflowCount += overflow;
+
+    stats.lightCount = lightCount;
+    stats.visibleLights = visibleLights;
+    stats.clustersUsed = clustersUsed;
+    stats.indexCount = indexCount;
+    stats.overflowCount = overflowCount;
+    stats.buildTime = timer.nsecsElapsed() / 1000;
+}
+
+void LightClusters::buildSlice(int slice, const QMatrix4x4& projMatrix)
+{
+    float sliceNear = nearClip * std::pow(farClip / nearClip, slice / (float)gridDepth);
+    float sliceFar = nearClip * std::pow(farClip / nearClip, (slice + 1) / (float)gridDepth);
+
+    // view space bounds of the slice's clusters
+    QVector3D clusterMin[gridWidth * gridHeight];
+    QVector3D clusterMax[gridWidth * gridHeight];
+    for (int y = 0; y < gridHeight; y++) {
+        for (int x = 0; x < gridWidth; x++) {
+            QVector3D minPoint(FLT_MAX, FLT_MAX, -sliceFar);
+            QVector3D maxPoint(-FLT_MAX, -FLT_MAX, -sliceNear);
+            for (int corner = 0; corner < 4; corner++) {
+                const auto& ray = tileRays[(y + corner / 2) * (gridWidth + 1) + x + corner % 2];
+                for (auto depth : {sliceNear, sliceFar}) {
+                    minPoint.setX(qMin(minPoint.x(), ray.x() * depth));
+                    minPoint.setY(qMin(minPoint.y(), ray.y() * depth));
+                    maxPoint.setX(qMax(maxPoint.x(), ray.x() * depth));
+                    maxPoint.setY(qMax(maxPoint.y(), ray.y() * depth));
+                }
+            }
+
+            clusterMin[y * gridWidth + x] = minPoint;
+            clusterMax[y * gridWidth + x] = maxPoint;
+        }
+    }
+
+    int firstCluster = slice * gridWidth * gridHeight;
+    int overflows = 0;
+
+    for (int i = 0; i < viewLights.size(); i++) {
+        const auto& light = viewLights[i];
+        if (slice < light.firstSlice || slice > light.lastSlice)
+            continue;
+
+        const auto& center = light.center;
+        float radius = light.radius;
+
+        // the tiles the light can touch, from its bounding box cut to the slice
+        float nearDepth = qMax(sliceNear, -center.z() - radius);
+        float farDepth = qMin(sliceFar, -center.z() + radius);
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+        for (int corner = 0; corner < 8; corner++) {
+            QVector3D point(center.x() + ((corner & 1) ? radius : -radius),
+                            center.y() + ((corner & 2) ? radius : -radius),
+                            (corner & 4) ? -farDepth : -nearDepth);
+            auto ndc = projMatrix.map(point);
+            minX = qMin(minX, ndc.x());
+            minY = qMin(minY, ndc.y());
+            maxX = qMax(maxX, ndc.x());
+            maxY = qMax(maxY, ndc.y());
+        }
+
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+            continue;
+
+        int firstX = qBound(0, (int)std::floor((minX * 0.5f + 0.5f) * gridWidth), gridWidth - 1);
+        int lastX = qBound(0, (int)std::floor((maxX * 0.5f + 0.5f) * gridWidth), gridWidth - 1);
+        int firstY = qBound(0, (int)std::floor((minY * 0.5f + 0.5f) * gridHeight), gridHeight - 1);
+        int lastY = qBound(0, (int)std::floor((maxY * 0.5f + 0.5f) * gridHeight), gridHeight - 1);
+
+        for (int y = firstY; y <= lastY; y++) {
+            for (int x = firstX; x <= lastX; x++) {
+                int tile = y * gridWidth + x;
+
+                // distance from the light to the closest point of the cluster's box
+                const auto& minPoint = clusterMin[tile];
+                const auto& maxPoint = clusterMax[tile];
+                float dx = qMax(qMax(minPoint.x() - center.x(), center.x() - maxPoint.x()), 0.0f);
+                float dy = qMax(qMax(minPoint.y() - center.y(), center.y() - maxPoint.y()), 0.0f);
+                float dz = qMax(qMax(minPoint.z() - center.z(), center.z() - maxPoint.z()), 0.0f);
+                if (dx * dx + dy * dy + dz * dz > radius * radius)
+                    continue;
+
+                int cluster = firstCluster + tile;
+                int& count = clusterCounts[cluster];
+                if (count == maxLightsPerCluster) {
+                    overflows++;
+                    continue;
+                }
+
+                clusterLists[cluster * maxLightsPerCluster + count] = i;
+                count++;
+            }
+        }
+    }
+
+    sliceOverflows[slice] = overflows;
+}
+
+void LightClusters::upload()
+{
+    // grows to the largest frame seen so far, an empty light buffer still gets a light's worth
+    lightCapacity = qMax(lightCapacity, qMax(lightBounds.size(), 1));
+    clusterCapacity = qMax(clusterCapacity, clusterData.size());
+
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, lightBufferId);
+    gl->glBufferData(GL_TEXTURE_BUFFER, lightCapacity * texelsPerLight * 4 * sizeof(float), nullptr, GL_STREAM_DRAW);
+    gl->glBufferSubData(GL_TEXTURE_BUFFER, 0, lightData.size() * sizeof(float), lightData.constData());
+
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, clusterBufferId);
+    gl->glBufferData(GL_TEXTURE_BUFFER, clusterCapacity * sizeof(quint32), nullptr, GL_STREAM_DRAW);
+    gl->glBufferSubData(GL_TEXTURE_BUFFER, 0, clusterData.size() * sizeof(quint32), clusterData.constData());
+
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::bind()
+{
+    gl->glActiveTexture(GL_TEXTURE0 + LIGHT_CLUSTER_LIGHTS_TEXTURE_UNIT);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, lightTextureId);
+    gl->glActiveTexture(GL_TEXTURE0 + LIGHT_CLUSTER_DATA_TEXTURE_UNIT);
+    gl->glBindTexture(GL_TEXTURE_BUFFER, clusterTextureId);
+}
+
+}
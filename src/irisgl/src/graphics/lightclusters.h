@@ -0,0 +1,186 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include <qopengl.h>
+#include <QColor>
+#include <QMatrix4x4>
+#include <QVector>
+#include <QVector3D>
+#include <QVector4D>
+
+class QOpenGLFunctions_3_2_Core;
+
+// texture units u_clusterLights and u_clusterData are read from
+#define LIGHT_CLUSTER_LIGHTS_TEXTURE_UNIT 10
+#define LIGHT_CLUSTER_DATA_TEXTURE_UNIT 11
+
+namespace iris
+{
+
+struct LightClusterStats
+{
+    // point and spot lights added this frame
+    int lightCount;
+    // lights within the view's depth range
+    int visibleLights;
+    // clusters with at least one light
+    int clustersUsed;
+    // entries in the clusters' light lists
+    int indexCount;
+    // light references dropped because a cluster was full
+    int overflowCount;
+    // microseconds spent binning the lights
+    qint64 buildTime;
+};
+
+/**
+ * Point and spot lights binned into a grid of froxels, view space cells that are tiles
+ * of the screen split into slices along the depth. The slices get exponentially
+ * thicker away from the camera so each cluster has a similar shape.
+ *
+ * Shaders find the cluster of a fragment and only light it with the lights in its
+ * list (see light_clusters.glsl). Both are kept in texture buffers:
+ * u_clusterLights has four rgba32f texels per light and u_clusterData is r32ui,
+ * an offset and count per cluster followed by the light lists.
+ */
+class LightClusters
+{
+public:
+    static const int gridWidth = 16;
+    static const int gridHeight = 9;
+    static const int gridDepth = 24;
+    static const int clusterCount = gridWidth * gridHeight * gridDepth;
+    // lights past this many in one cluster are ignored
+    static const int maxLightsPerCluster = 128;
+    static const int texelsPerLight = 4;
+
+    LightClusters(QOpenGLFunctions_3_2_Core* gl);
+    ~LightClusters();
+
+    /**
+     * Removes every light, the gpu storage is kept
+     */
+    void clear();
+
+    /**
+     * Adds a point or spot light in world space and returns its index
+     * @param distance the light's range, it has no effect past it
+     */
+    int addLight(int type,
+                 const QVector3D& position,
+                 const QVector3D& direction,
+                 float distance,
+                 const QColor& color,
+                 float intensity,
+                 float cutOffAngle,
+                 float cutOffSoftness);
+
+    int getLightCount() const
+    {
+        return lightBounds.size();
+    }
+
+    /**
+     * Bins the lights into the clusters of a perspective view.
+     * The slices are binned in parallel on the job system.
+     */
+    void build(const QMatrix4x4& viewMatrix, const QMatrix4x4& projMatrix);
+
+    /**
+     * Uploads the lights and clusters. The storage is orphaned so updating more
+     * than once per frame (once per eye in vr) doesnt stall.
+     */
+    void upload();
+
+    /**
+     * Binds the light texture to LIGHT_CLUSTER_LIGHTS_TEXTURE_UNIT
+     * and the cluster texture to LIGHT_CLUSTER_DATA_TEXTURE_UNIT
+     */
+    void bind();
+
+    /**
+     * The shaders find a fragment's slice as log(depth) * scale + bias
+     */
+    float getDepthScale() const
+    {
+        return depthScale;
+    }
+
+    float getDepthBias() const
+    {
+        return depthBias;
+    }
+
+    /**
+     * Returns the offset and count of every cluster followed by the light lists,
+     * as build() left them for upload()
+     */
+    const QVector<quint32>& getClusterData() const
+    {
+        return clusterData;
+    }
+
+    const LightClusterStats& getStats() const
+    {
+        return stats;
+    }
+
+private:
+    // bins the lights into one slice of the grid, the slices dont share any data
+    void buildSlice(int slice, const QMatrix4x4& projMatrix);
+
+    // sphere bounding a light in view space with the slices it covers
+    struct ViewLight
+    {
+        QVector3D center;
+        float radius;
+        int firstSlice;
+        int lastSlice;
+    };
+
+    QOpenGLFunctions_3_2_Core* gl;
+    GLuint lightBufferId;
+    GLuint lightTextureId;
+    GLuint clusterBufferId;
+    GLuint clusterTextureId;
+
+    // texels of u_clusterLights
+    QVector<float> lightData;
+    // world space position and range of each light
+    QVector<QVector4D> lightBounds;
+
+    QVector<ViewLight> viewLights;
+    // view space directions through the corners of the screen tiles
+    QVector3D tileRays[(gridWidth + 1) * (gridHeight + 1)];
+    float nearClip;
+    float farClip;
+    float depthScale;
+    float depthBias;
+
+    // fixed size light lists of every cluster, compacted into clusterData after binning
+    QVector<quint32> clusterLists;
+    QVector<int> clusterCounts;
+    QVector<int> sliceOverflows;
+    // offset and count of every cluster followed by the light lists
+    QVector<quint32> clusterData;
+
+    int lightCapacity;
+    int clusterCapacity;
+
+    LightClusterStats stats;
+};
+
+}
+
+#endif // LIGHTCLUSTERS_H
@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include <QOpenGLFunctions_3_2_Core>
 #include "texture2d.h"
 #include "graphicshelper.h"
+#include "shadercache.h"
 
 namespace iris
 {
@@ -67,7 +68,7 @@ void Material::bindTextures(QOpenGLFunctions_3_2_Core* gl)
 
         if (tex->texture != nullptr) {
             tex->texture->bind();
-            program->setUniformValue(it.key().toStdString().c_str(), count);
+            program->setUniformValue(shader->getUniformLocation(it.key()), count);
         } else {
             gl->glBindTexture(GL_TEXTURE_2D,0);
         }
@@ -92,7 +93,7 @@ void Material::bindCubeTextures(QOpenGLFunctions_3_2_Core* gl)
         if(tex->texture!=nullptr)
         {
             tex->texture->bind();
-            program->setUniformValue(it.key().toStdString().c_str(), count);
+            program->setUniformValue(shader->getUniformLocation(it.key()), count);
         }
         else
         {
@@ -120,6 +121,7 @@ void Material::unbindTextures(QOpenGLFunctions_3_2_Core* gl)
 void Material::createProgramFromShaderSource(QString vsFile,QString fsFile)
 {
     program = GraphicsHelper::loadShader(vsFile, fsFile);
+    shader = ShaderCache::getShader(program);
 }
 
 void Material::setTextureCount(int count)
@@ -127,4 +129,11 @@ void Material::setTextureCount(int count)
     numTextures = count;
 }
 
+long Material::generateMaterialId()
+{
+    return nextMaterialId++;
+}
+
+long Material::nextMaterialId = 0;
+
 }
@@ -14,6 +14,7 @@ For more information see the LICENSE file
 
 #include "../irisglfwd.h"
 #include "renderitem.h"
+#include "shader.h"
 #include <QOpenGLShaderProgram>
 
 class QOpenGLShaderProgram;
@@ -42,15 +43,22 @@ class Material
 public:
     int renderLayer;
     QOpenGLShaderProgram* program;
+    // wraps program and caches its uniform locations
+    ShaderPtr shader;
     QMap<QString, Texture2DPtr> textures;
 
     bool acceptsLighting;
     int numTextures;
     RenderStates renderStates;
 
+    // unique id used by the render queue to group items by material
+    long materialId;
+
     Material() {
+        program = nullptr;
         acceptsLighting = true;
         numTextures = 0;
+        materialId = generateMaterialId();
     }
 
     virtual ~Material() {}
@@ -106,7 +114,7 @@ public:
 
     template<typename T>
     void setUniformValue(QString name,T value) {
-        program->setUniformValue(name.toStdString().c_str(), value);
+        program->setUniformValue(shader->getUniformLocation(name), value);
     }
 
 protected:
@@ -118,6 +126,10 @@ protected:
      * @param count
      */
     void setTextureCount(int count);
+
+private:
+    static long generateMaterialId();
+    static long nextMaterialId;
 };
 
 }
@@ -24,6 +24,7 @@ For more information see the LICENSE file
 #include <QOpenGLTexture>
 
 #include "vertexlayout.h"
+#include "meshcooker.h"
 #include "../geometry/trimesh.h"
 
 namespace iris
@@ -31,65 +32,33 @@ namespace iris
 
 Mesh::Mesh(aiMesh* mesh)
 {
-    lastShaderId = -1;
-    gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
-
-    triMesh = new TriMesh();
-
-    this->vertexLayout = nullptr;
-    numVerts = mesh->mNumFaces*3;
-    numFaces = mesh->mNumFaces;
-
-    gl->glGenVertexArrays(1,&vao);
-
     if(!mesh->HasPositions())
         throw QString("Mesh has no positions!!");
 
-    this->addVertexArray(VertexAttribUsage::Position, (void*)mesh->mVertices, sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-
-
-    if(mesh->HasTextureCoords(0))
-        this->addVertexArray(VertexAttribUsage::TexCoord0, (void*)mesh->mTextureCoords[0], sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-    if(mesh->HasTextureCoords(1))
-        this->addVertexArray(VertexAttribUsage::TexCoord1, (void*)mesh->mTextureCoords[1], sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-    if(mesh->HasNormals())
-        this->addVertexArray(VertexAttribUsage::Normal, (void*)mesh->mNormals, sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-    if(mesh->HasTangentsAndBitangents())
-        this->addVertexArray(VertexAttribUsage::Tangent, (void*)mesh->mTangents, sizeof(aiVector3D) * mesh->mNumVertices, GL_FLOAT,3);
-
-    gl->glBindVertexArray(vao);
-    // Assimp doesnt give the indices in an array
-    // So some calculation still has to be done
-    QVector<unsigned int> indices;
-    indices.reserve(mesh->mNumFaces * 3);
-    triMesh->triangles.reserve(mesh->mNumFaces);
-    for(unsigned i = 0; i < mesh->mNumFaces; i++)
-    {
-
-        auto face = mesh->mFaces[i];
-
-        if (face.mNumIndices!=3)
-            continue;
-
-        indices.append(face.mIndices[0]);
-        indices.append(face.mIndices[1]);
-        indices.append(face.mIndices[2]);
-
-        auto a = mesh->mVertices[face.mIndices[0]];
-        auto b = mesh->mVertices[face.mIndices[1]];
-        auto c = mesh->mVertices[face.mIndices[2]];
-
-        triMesh->addTriangle(QVector3D(a.x, a.y, a.z),
-                             QVector3D(b.x, b.y, b.z),
-                             QVector3D(c.x, c.y, c.z));
-    }
-
-    gl->glGenBuffers(1, &indexBuffer);
-    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-    gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
-    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    usesIndexBuffer = true;
+    PackedMesh packed;
+    MeshCooker::pack(mesh, packed);
+
+    auto layout = new VertexLayout();
+    for (const auto& attrib : packed.attribs)
+        layout->addAttrib(attrib.usage, attrib.type, attrib.count, attrib.sizeInBytes, attrib.normalized);
+
+    InterleavedMeshData data;
+    data.layout = layout;
+    data.vertexCount = packed.vertexCount;
+    data.vertexData = packed.vertexData.constData();
+    data.indexType = packed.indexType;
+    data.indexCount = packed.indexCount;
+    data.indexData = packed.indexData.constData();
+    data.triangleCount = packed.triangleCount;
+    data.triangleData = (const float*)packed.triangleData.constData();
+    data.bounds = packed.bounds;
+
+    upload(data);
+}
 
+Mesh::Mesh(const InterleavedMeshData& data)
+{
+    upload(data);
 }
 
 //todo: extract trimesh from data
@@ -101,14 +70,18 @@ Mesh::Mesh(void* data,int dataSize,int numElements,VertexLayout* vertexLayout)
 
     triMesh = nullptr;
     this->vertexLayout = vertexLayout;
+    this->vbo = nullptr;
+    indexType = GL_UNSIGNED_INT;
+    gpuMemorySize = dataSize;
+    unpackedMemorySize = dataSize;
     numVerts = numElements;
+    vertexCount = numElements;
 
     gl->glGenVertexArrays(1,&vao);
     gl->glBindVertexArray(vao);
 
-    GLuint vbo;
-    gl->glGenBuffers(1, &vbo);
-    gl->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl->glGenBuffers(1, &interleavedBuffer);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, interleavedBuffer);
     gl->glBufferData(GL_ARRAY_BUFFER,dataSize,data,GL_STATIC_DRAW);
 
     vertexLayout->bind();
@@ -119,6 +92,54 @@ Mesh::Mesh(void* data,int dataSize,int numElements,VertexLayout* vertexLayout)
     usesIndexBuffer = false;
 }
 
+void Mesh::upload(const InterleavedMeshData& data)
+{
+    lastShaderId = -1;
+    gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+
+    triMesh = new TriMesh();
+
+    vertexLayout = data.layout;
+    vbo = nullptr;
+    vertexCount = data.vertexCount;
+    numVerts = data.indexCount;
+    numFaces = data.indexCount / 3;
+    boundingBox = data.bounds;
+
+    gl->glGenVertexArrays(1, &vao);
+    gl->glBindVertexArray(vao);
+
+    int vertexSize = vertexLayout->getStride() * data.vertexCount;
+    gl->glGenBuffers(1, &interleavedBuffer);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, interleavedBuffer);
+    gl->glBufferData(GL_ARRAY_BUFFER, vertexSize, data.vertexData, GL_STATIC_DRAW);
+    vertexLayout->bind();
+
+    int indexSize = data.indexType == GL_UNSIGNED_SHORT ? sizeof(quint16) : sizeof(quint32);
+    gl->glGenBuffers(1, &indexBuffer);
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * data.indexCount, data.indexData, GL_STATIC_DRAW);
+    indexType = data.indexType;
+    usesIndexBuffer = true;
+
+    // the index buffer stays bound so it becomes part of the vao's state
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    gl->glBindVertexArray(0);
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    gpuMemorySize = vertexSize + indexSize * data.indexCount;
+    unpackedMemorySize = sizeof(float) * 3 * vertexLayout->getAttribs().size() * data.vertexCount +
+                         sizeof(quint32) * data.indexCount;
+
+    triMesh->triangles.reserve(data.triangleCount);
+    for (int i = 0; i < data.triangleCount; i++) {
+        auto p = data.triangleData + i * 9;
+        triMesh->addTriangle(QVector3D(p[0], p[1], p[2]),
+                             QVector3D(p[3], p[4], p[5]),
+                             QVector3D(p[6], p[7], p[8]));
+    }
+}
+
 void Mesh::draw(QOpenGLFunctions_3_2_Core* gl,Material* mat,GLenum primitiveMode)
 {
     draw(gl,mat->program,primitiveMode);
@@ -132,9 +153,7 @@ void Mesh::draw(QOpenGLFunctions_3_2_Core* gl,QOpenGLShaderProgram* program,GLen
     gl->glBindVertexArray(vao);
     if(usesIndexBuffer)
     {
-        gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,indexBuffer);
-        gl->glDrawElements(GL_TRIANGLES,numVerts,GL_UNSIGNED_INT,0);
-        gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+        gl->glDrawElements(GL_TRIANGLES,numVerts,indexType,0);
     }
     else
     {
@@ -143,6 +162,29 @@ void Mesh::draw(QOpenGLFunctions_3_2_Core* gl,QOpenGLShaderProgram* program,GLen
     gl->glBindVertexArray(0);
 }
 
+void Mesh::bind(QOpenGLFunctions_3_2_Core* gl)
+{
+    gl->glBindVertexArray(vao);
+}
+
+void Mesh::drawBound(QOpenGLFunctions_3_2_Core* gl, GLenum primitiveMode)
+{
+    if (usesIndexBuffer) {
+        gl->glDrawElements(primitiveMode, numVerts, indexType, 0);
+    } else {
+        gl->glDrawArrays(primitiveMode, 0, numVerts);
+    }
+}
+
+void Mesh::drawBoundInstanced(QOpenGLFunctions_3_2_Core* gl, int instanceCount, GLenum primitiveMode)
+{
+    if (usesIndexBuffer) {
+        gl->glDrawElementsInstanced(primitiveMode, numVerts, indexType, 0, instanceCount);
+    } else {
+        gl->glDrawArraysInstanced(primitiveMode, 0, numVerts, instanceCount);
+    }
+}
+
 Mesh* Mesh::loadMesh(QString filePath)
 {
     Assimp::Importer importer;
@@ -171,35 +213,30 @@ Mesh* Mesh::create(void* data,int dataSize,int numVerts,VertexLayout* vertexLayo
     return new Mesh(data,dataSize,numVerts,vertexLayout);
 }
 
-Mesh::~Mesh()
+int Mesh::getMemorySize() const
 {
-    delete vertexLayout;
-    delete vbo;
-    delete triMesh;
+    int size = gpuMemorySize;
+    if (triMesh != nullptr)
+        size += triMesh->triangles.size() * sizeof(Triangle);
+
+    return size;
 }
 
-void Mesh::addVertexArray(VertexAttribUsage usage,void* dataPtr,int size,GLenum type,int numComponents)
+Mesh::~Mesh()
 {
-    gl->glBindVertexArray(vao);
-
-    GLuint bufferId;
-    gl->glGenBuffers(1, &bufferId);
-    gl->glBindBuffer(GL_ARRAY_BUFFER, bufferId);
-    gl->glBufferData(GL_ARRAY_BUFFER, size, dataPtr, GL_STATIC_DRAW);
-
-    auto data = VertexArrayData();
-    data.usage = usage;
-    data.numComponents = numComponents;
-    data.type = type;
-    data.bufferId = bufferId;
+    // gl objects can only be deleted while the context is current
+    if (QOpenGLContext::currentContext() != nullptr) {
+        gl->glDeleteBuffers(1, &interleavedBuffer);
 
-    vertexArrays[(int)usage] = data;
+        if (usesIndexBuffer)
+            gl->glDeleteBuffers(1, &indexBuffer);
 
-    gl->glVertexAttribPointer((GLuint)usage,numComponents,type,GL_FALSE,0,0);
-    gl->glEnableVertexAttribArray((int)usage);
+        gl->glDeleteVertexArrays(1, &vao);
+    }
 
-    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
-    gl->glBindVertexArray(0);
+    delete vertexLayout;
+    delete vbo;
+    delete triMesh;
 }
 
 void Mesh::addIndexArray(void* data,int size,GLenum type)
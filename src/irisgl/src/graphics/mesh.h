@@ -15,6 +15,7 @@ For more information see the LICENSE file
 #include <QString>
 #include <qopengl.h>
 #include "../irisglfwd.h"
+#include "../geometry/boundingbox.h"
 
 class aiMesh;
 class QOpenGLBuffer;
@@ -38,20 +39,27 @@ enum class VertexAttribUsage : int
     Count = 8
 };
 
-class VertexArrayData
+/**
+ * Interleaved vertex data and indices of a mesh, such as the meshes packed by
+ * MeshCooker. The pointers arent owned by the struct.
+ */
+struct InterleavedMeshData
 {
-public:
+    // describes the vertices, the mesh takes ownership of it
+    VertexLayout* layout;
+    int vertexCount;
+    const void* vertexData;
 
-    GLuint bufferId;
-    VertexAttribUsage usage;
-    int numComponents;
-    GLenum type;
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum indexType;
+    int indexCount;
+    const void* indexData;
 
-    VertexArrayData()
-    {
-        bufferId = 0;
-    }
+    // picking triangles, nine floats each
+    int triangleCount;
+    const float* triangleData;
 
+    BoundingBox bounds;
 };
 
 class Mesh
@@ -62,28 +70,68 @@ public:
     GLuint vao;
     GLuint indexBuffer;
     bool usesIndexBuffer;
+    GLenum indexType;
+
+    // buffer holding the interleaved vertices
+    GLuint interleavedBuffer;
 
     // will cause problems if a shader was freed and gl gives the
     // id to another shader
     GLuint lastShaderId;
 
-    VertexArrayData vertexArrays[(int)VertexAttribUsage::Count];
-
     QOpenGLBuffer* vbo;
 
     VertexLayout* vertexLayout;
     int numVerts;
     int numFaces;
 
+    // local space bounds of the vertices, used for frustum culling
+    // meshes created from raw vertex data have empty bounds and are never culled
+    BoundingBox boundingBox;
+
     TriMesh* triMesh;
     TriMesh* getTriMesh()
     {
         return triMesh;
     }
 
+    // bytes uploaded to the mesh's vertex and index buffers
+    int gpuMemorySize;
+
+    int vertexCount;
+    // bytes the vertex and index buffers would take with a float buffer per attribute
+    // and 32 bit indices, the format meshes had before they were packed
+    int unpackedMemorySize;
+
+    /**
+     * Returns the memory used by the mesh's gpu buffers and picking triangles in bytes
+     */
+    int getMemorySize() const;
+
     void draw(QOpenGLFunctions_3_2_Core* gl, Material* mat, GLenum primitiveMode = GL_TRIANGLES);
     void draw(QOpenGLFunctions_3_2_Core* gl, QOpenGLShaderProgram* mat, GLenum primitiveMode = GL_TRIANGLES);
 
+    /**
+     * Binds the mesh's vertex array. Used with drawBound so consecutive draws of
+     * the same mesh dont have to rebind it. The index buffer is part of the vao's state.
+     * @param gl
+     */
+    void bind(QOpenGLFunctions_3_2_Core* gl);
+
+    /**
+     * Draws the mesh without binding anything. The mesh and a shader program
+     * should already be bound.
+     * @param gl
+     * @param primitiveMode
+     */
+    void drawBound(QOpenGLFunctions_3_2_Core* gl, GLenum primitiveMode = GL_TRIANGLES);
+
+    /**
+     * Draws instanceCount copies of the mesh without binding anything, like drawBound.
+     * The vertex shader tells the copies apart with gl_InstanceID.
+     */
+    void drawBoundInstanced(QOpenGLFunctions_3_2_Core* gl, int instanceCount, GLenum primitiveMode = GL_TRIANGLES);
+
     static Mesh* loadMesh(QString filePath);
 
     //assumed ownership of vertexLayout
@@ -91,6 +139,12 @@ public:
 
     Mesh(aiMesh* mesh);
 
+    /**
+     * Uploads interleaved vertex and index data, usually straight from a memory-mapped
+     * cooked mesh file.
+     */
+    Mesh(const InterleavedMeshData& data);
+
     /**
      *
      * @param data
@@ -103,7 +157,7 @@ public:
     ~Mesh();
 
 private:
-    void addVertexArray(VertexAttribUsage usage,void* data,int size,GLenum type,int numComponents);
+    void upload(const InterleavedMeshData& data);
     void addIndexArray(void* data,int size,GLenum type);
 };
 
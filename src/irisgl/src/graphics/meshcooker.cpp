@@ -0,0 +1,514 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "meshcooker.h"
+#include "mesh.h"
+
+#include "assimp/scene.h"
+#include "assimp/mesh.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+
+namespace iris
+{
+
+namespace
+{
+
+// written at the start of every cooked file, followed by one CookedMeshEntry per mesh
+struct CookedFileHeader
+{
+    char magic[8];
+    quint32 meshCount;
+    quint32 reserved;
+
+    // identifies the model file the meshes were cooked from
+    qint64 sourceModified;
+    qint64 sourceSize;
+    char sourceHash[20];
+    quint32 reserved2;
+};
+
+struct CookedAttrib
+{
+    quint32 usage;
+    quint32 type;
+    quint32 count;
+    quint32 normalized;
+};
+
+const int maxCookedAttribs = 5;
+
+// offsets are from the start of the file and 4 byte aligned
+struct CookedMeshEntry
+{
+    // 0 for meshes without positions
+    quint32 attribCount;
+    quint32 stride;
+    CookedAttrib attribs[maxCookedAttribs];
+
+    quint32 vertexCount;
+    quint32 indexCount;
+    // 2 or 4
+    quint32 indexSize;
+    quint32 triangleCount;
+
+    float boundsMin[3];
+    float boundsMax[3];
+
+    quint64 vertexOffset;
+    quint64 indexOffset;
+    quint64 triangleOffset;
+};
+
+// the version is part of the magic, bump it when the layout changes
+const char cookedMagic[8] = {'I', 'R', 'I', 'S', 'M', 'S', 'H', '2'};
+
+// half floats have 10 mantissa bits, up to 2 that is a step of 1/1024
+const float maxHalfTexCoord = 2.0f;
+
+struct SourceInfo
+{
+    qint64 modified;
+    qint64 size;
+    QByteArray hash;
+};
+
+bool getSourceInfo(const QString& sourcePath, SourceInfo& info)
+{
+    QFileInfo fileInfo(sourcePath);
+    if (!fileInfo.exists())
+        return false;
+
+    info.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    info.size = fileInfo.size();
+    return true;
+}
+
+bool hashSource(const QString& sourcePath, SourceInfo& info)
+{
+    QFile file(sourcePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file))
+        return false;
+
+    info.hash = hash.result();
+    return true;
+}
+
+bool matchesSource(const CookedFileHeader& header, const SourceInfo& info)
+{
+    return header.sourceModified == info.modified &&
+           header.sourceSize == info.size &&
+           std::memcmp(header.sourceHash, info.hash.constData(), sizeof(header.sourceHash)) == 0;
+}
+
+int getTypeSize(quint32 type)
+{
+    switch (type) {
+    case GL_FLOAT:
+        return sizeof(float);
+    case GL_HALF_FLOAT:
+        return sizeof(quint16);
+    case GL_BYTE:
+        return sizeof(qint8);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Converts a float to a half float, rounding to the nearest value.
+ * Values too large for a half become infinity, texture coordinates are range checked
+ * before so this never happens in practice.
+ */
+quint16 toHalfFloat(float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    quint32 sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    quint32 mantissa = bits & 0x7FFFFF;
+
+    if (exponent >= 31)
+        return sign | 0x7C00;
+
+    if (exponent <= 0) {
+        // too small even for a denormal half
+        if (exponent < -10)
+            return sign;
+
+        // denormal, the implicit leading one becomes explicit
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        quint32 half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            half++;
+
+        return sign | half;
+    }
+
+    // a carry out of the mantissa correctly bumps the exponent
+    quint32 half = sign | (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        half++;
+
+    return half;
+}
+
+qint8 toNormalizedByte(float value)
+{
+    return (qint8)qRound(qBound(-1.0f, value, 1.0f) * 127.0f);
+}
+
+bool canUseHalfFloats(const aiVector3D* texCoords, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++) {
+        if (qAbs(texCoords[i].x) > maxHalfTexCoord || qAbs(texCoords[i].y) > maxHalfTexCoord)
+            return false;
+    }
+
+    return true;
+}
+
+void addPackedAttrib(PackedMesh& packed, VertexAttribUsage usage, int type, int count, bool normalized)
+{
+    VertexAttribute attrib = {usage, type, count, getTypeSize(type) * count, normalized};
+    packed.attribs.append(attrib);
+    packed.stride += attrib.sizeInBytes;
+}
+
+char* writeAttrib(char* dest, const VertexAttribute& attrib, const aiVector3D& value)
+{
+    const float components[] = {value.x, value.y, value.z, 0.0f};
+
+    for (int i = 0; i < attrib.count; i++) {
+        if (attrib.type == GL_FLOAT) {
+            std::memcpy(dest, &components[i], sizeof(float));
+        } else if (attrib.type == GL_HALF_FLOAT) {
+            quint16 half = toHalfFloat(components[i]);
+            std::memcpy(dest, &half, sizeof(half));
+        } else {
+            *dest = (char)toNormalizedByte(components[i]);
+        }
+
+        dest += getTypeSize(attrib.type);
+    }
+
+    return dest;
+}
+
+void alignTo4(QByteArray& data)
+{
+    while (data.size() % 4 != 0)
+        data.append('\0');
+}
+
+bool isEntryValid(const CookedMeshEntry& entry, qint64 fileSize)
+{
+    if (entry.attribCount == 0)
+        return true;
+
+    if (entry.attribCount > maxCookedAttribs)
+        return false;
+
+    // positions are always first
+    if (entry.attribs[0].usage != (quint32)VertexAttribUsage::Position)
+        return false;
+
+    quint32 stride = 0;
+    for (quint32 i = 0; i < entry.attribCount; i++) {
+        const auto& attrib = entry.attribs[i];
+        if (attrib.usage >= (quint32)VertexAttribUsage::Count || getTypeSize(attrib.type) == 0 ||
+            attrib.count < 1 || attrib.count > 4)
+            return false;
+
+        stride += getTypeSize(attrib.type) * attrib.count;
+    }
+
+    if (entry.stride != stride)
+        return false;
+
+    if (entry.indexSize != sizeof(quint16) && entry.indexSize != sizeof(quint32))
+        return false;
+
+    auto fits = [fileSize](quint64 offset, quint64 size) {
+        return offset % 4 == 0 && offset <= (quint64)fileSize && size <= (quint64)fileSize - offset;
+    };
+
+    return fits(entry.vertexOffset, (quint64)entry.stride * entry.vertexCount) &&
+           fits(entry.indexOffset, (quint64)entry.indexSize * entry.indexCount) &&
+           fits(entry.triangleOffset, (quint64)sizeof(float) * 9 * entry.triangleCount);
+}
+
+}
+
+QString MeshCooker::getCookedPath(const QString& sourcePath)
+{
+    return sourcePath + ".irismesh";
+}
+
+void MeshCooker::pack(const aiMesh* mesh, PackedMesh& packed)
+{
+    packed.attribs.clear();
+    packed.stride = 0;
+    packed.vertexCount = mesh->mNumVertices;
+
+    // the source array of each attribute, in the order they are interleaved
+    QList<const aiVector3D*> sources;
+
+    addPackedAttrib(packed, VertexAttribUsage::Position, GL_FLOAT, 3, false);
+    sources.append(mesh->mVertices);
+
+    for (int set = 0; set < 2; set++) {
+        if (!mesh->HasTextureCoords(set))
+            continue;
+
+        auto texCoords = mesh->mTextureCoords[set];
+        auto usage = set == 0 ? VertexAttribUsage::TexCoord0 : VertexAttribUsage::TexCoord1;
+        bool useHalfFloats = canUseHalfFloats(texCoords, mesh->mNumVertices);
+        addPackedAttrib(packed, usage, useHalfFloats ? GL_HALF_FLOAT : GL_FLOAT, 2, false);
+        sources.append(texCoords);
+    }
+
+    // four bytes keep the attributes 4 byte aligned, the shader ignores w
+    if (mesh->HasNormals()) {
+        addPackedAttrib(packed, VertexAttribUsage::Normal, GL_BYTE, 4, true);
+        sources.append(mesh->mNormals);
+    }
+
+    if (mesh->HasTangentsAndBitangents()) {
+        addPackedAttrib(packed, VertexAttribUsage::Tangent, GL_BYTE, 4, true);
+        sources.append(mesh->mTangents);
+    }
+
+    packed.vertexData.resize(packed.stride * mesh->mNumVertices);
+    packed.bounds = BoundingBox();
+
+    auto dest = packed.vertexData.data();
+    for (unsigned i = 0; i < mesh->mNumVertices; i++) {
+        for (int j = 0; j < packed.attribs.size(); j++)
+            dest = writeAttrib(dest, packed.attribs[j], sources[j][i]);
+
+        auto v = mesh->mVertices[i];
+        packed.bounds.merge(QVector3D(v.x, v.y, v.z));
+    }
+
+    // 16 bit indices halve the index buffer of most meshes
+    packed.indexType = mesh->mNumVertices <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    packed.indexCount = 0;
+    packed.triangleCount = 0;
+    packed.indexData.clear();
+    packed.triangleData.clear();
+
+    int indexSize = packed.indexType == GL_UNSIGNED_SHORT ? sizeof(quint16) : sizeof(quint32);
+    packed.indexData.reserve(indexSize * mesh->mNumFaces * 3);
+    packed.triangleData.reserve(sizeof(float) * 9 * mesh->mNumFaces);
+
+    for (unsigned i = 0; i < mesh->mNumFaces; i++) {
+        auto face = mesh->mFaces[i];
+        if (face.mNumIndices != 3)
+            continue;
+
+        for (int j = 0; j < 3; j++) {
+            auto index = face.mIndices[j];
+            if (packed.indexType == GL_UNSIGNED_SHORT) {
+                quint16 shortIndex = index;
+                packed.indexData.append((const char*)&shortIndex, sizeof(shortIndex));
+            } else {
+                quint32 longIndex = index;
+                packed.indexData.append((const char*)&longIndex, sizeof(longIndex));
+            }
+
+            auto v = mesh->mVertices[index];
+            const float position[] = {v.x, v.y, v.z};
+            packed.triangleData.append((const char*)position, sizeof(position));
+        }
+
+        packed.indexCount += 3;
+        packed.triangleCount++;
+    }
+}
+
+bool MeshCooker::load(const QString& sourcePath, QList<Mesh*>& meshes)
+{
+    SourceInfo source;
+    if (!getSourceInfo(sourcePath, source))
+        return false;
+
+    QFile file(getCookedPath(sourcePath));
+    if (!file.open(QIODevice::ReadOnly) || file.size() < (qint64)sizeof(CookedFileHeader))
+        return false;
+
+    auto fileSize = file.size();
+    auto data = (const char*)file.map(0, fileSize);
+    if (data == nullptr)
+        return false;
+
+    CookedFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    // the timestamp and size are checked first so stale files dont cost a hash
+    bool isValid = std::memcmp(header.magic, cookedMagic, sizeof(cookedMagic)) == 0 &&
+                   header.sourceModified == source.modified &&
+                   header.sourceSize == source.size &&
+                   sizeof(header) + (qint64)header.meshCount * sizeof(CookedMeshEntry) <= (quint64)fileSize &&
+                   hashSource(sourcePath, source) &&
+                   matchesSource(header, source);
+
+    QList<CookedMeshEntry> entries;
+    for (quint32 i = 0; isValid && i < header.meshCount; i++) {
+        CookedMeshEntry entry;
+        std::memcpy(&entry, data + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        isValid = isEntryValid(entry, fileSize);
+        entries.append(entry);
+    }
+
+    if (isValid) {
+        for (const auto& entry : entries) {
+            if (entry.attribCount == 0) {
+                meshes.append(nullptr);
+                continue;
+            }
+
+            auto layout = new VertexLayout();
+            for (quint32 i = 0; i < entry.attribCount; i++) {
+                const auto& attrib = entry.attribs[i];
+                layout->addAttrib((VertexAttribUsage)attrib.usage, attrib.type, attrib.count,
+                                  getTypeSize(attrib.type) * attrib.count, attrib.normalized != 0);
+            }
+
+            InterleavedMeshData meshData;
+            meshData.layout = layout;
+            meshData.vertexCount = entry.vertexCount;
+            meshData.vertexData = data + entry.vertexOffset;
+            meshData.indexType = entry.indexSize == sizeof(quint16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            meshData.indexCount = entry.indexCount;
+            meshData.indexData = data + entry.indexOffset;
+            meshData.triangleCount = entry.triangleCount;
+            meshData.triangleData = (const float*)(data + entry.triangleOffset);
+            meshData.bounds = BoundingBox(QVector3D(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]),
+                                          QVector3D(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]));
+
+            meshes.append(new Mesh(meshData));
+        }
+    }
+
+    file.unmap((uchar*)data);
+    return isValid;
+}
+
+bool MeshCooker::save(const QString& sourcePath, const aiScene* scene)
+{
+    if (scene == nullptr)
+        return false;
+
+    SourceInfo source;
+    if (!getSourceInfo(sourcePath, source) || !hashSource(sourcePath, source))
+        return false;
+
+    auto cookedPath = getCookedPath(sourcePath);
+
+    // only the header is needed to tell if the existing file is up to date
+    QFile existingFile(cookedPath);
+    if (existingFile.open(QIODevice::ReadOnly)) {
+        CookedFileHeader existingHeader;
+        if (existingFile.read((char*)&existingHeader, sizeof(existingHeader)) == sizeof(existingHeader) &&
+            std::memcmp(existingHeader.magic, cookedMagic, sizeof(cookedMagic)) == 0 &&
+            matchesSource(existingHeader, source))
+            return true;
+    }
+
+    CookedFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, cookedMagic, sizeof(cookedMagic));
+    header.meshCount = scene->mNumMeshes;
+    header.sourceModified = source.modified;
+    header.sourceSize = source.size;
+    std::memcpy(header.sourceHash, source.hash.constData(), sizeof(header.sourceHash));
+
+    QList<CookedMeshEntry> entries;
+    QByteArray body;
+    quint64 bodyOffset = sizeof(header) + scene->mNumMeshes * sizeof(CookedMeshEntry);
+
+    for (unsigned i = 0; i < scene->mNumMeshes; i++) {
+        CookedMeshEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+
+        auto mesh = scene->mMeshes[i];
+        if (mesh->HasPositions()) {
+            PackedMesh packed;
+            pack(mesh, packed);
+
+            entry.attribCount = packed.attribs.size();
+            entry.stride = packed.stride;
+            for (int j = 0; j < packed.attribs.size(); j++) {
+                const auto& attrib = packed.attribs[j];
+                entry.attribs[j].usage = (quint32)attrib.usage;
+                entry.attribs[j].type = attrib.type;
+                entry.attribs[j].count = attrib.count;
+                entry.attribs[j].normalized = attrib.normalized ? 1 : 0;
+            }
+
+            entry.vertexCount = packed.vertexCount;
+            entry.indexCount = packed.indexCount;
+            entry.indexSize = packed.indexType == GL_UNSIGNED_SHORT ? sizeof(quint16) : sizeof(quint32);
+            entry.triangleCount = packed.triangleCount;
+
+            entry.boundsMin[0] = packed.bounds.minPos.x();
+            entry.boundsMin[1] = packed.bounds.minPos.y();
+            entry.boundsMin[2] = packed.bounds.minPos.z();
+            entry.boundsMax[0] = packed.bounds.maxPos.x();
+            entry.boundsMax[1] = packed.bounds.maxPos.y();
+            entry.boundsMax[2] = packed.bounds.maxPos.z();
+
+            // every block stays 4 byte aligned
+            alignTo4(packed.vertexData);
+            alignTo4(packed.indexData);
+
+            entry.vertexOffset = bodyOffset + body.size();
+            body.append(packed.vertexData);
+            entry.indexOffset = bodyOffset + body.size();
+            body.append(packed.indexData);
+            entry.triangleOffset = bodyOffset + body.size();
+            body.append(packed.triangleData);
+        }
+
+        entries.append(entry);
+    }
+
+    // written to a temporary file first so a failed write never leaves a truncated file behind
+    QSaveFile file(cookedPath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write((const char*)&header, sizeof(header));
+    for (const auto& entry : entries)
+        file.write((const char*)&entry, sizeof(entry));
+    file.write(body);
+
+    return file.commit();
+}
+
+}
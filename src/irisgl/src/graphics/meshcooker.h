@@ -0,0 +1,93 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef MESHCOOKER_H
+#define MESHCOOKER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include "vertexlayout.h"
+
+struct aiMesh;
+struct aiScene;
+
+namespace iris
+{
+
+class Mesh;
+
+/**
+ * A mesh in its compact upload format: interleaved vertices described by attribs
+ * and 16 or 32 bit indices.
+ */
+struct PackedMesh
+{
+    QList<VertexAttribute> attribs;
+    int stride;
+    int vertexCount;
+    QByteArray vertexData;
+
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum indexType;
+    int indexCount;
+    QByteArray indexData;
+
+    // picking triangles, nine floats each
+    int triangleCount;
+    QByteArray triangleData;
+
+    BoundingBox bounds;
+};
+
+/**
+ * Packs, writes and reads cooked meshes. A cooked mesh file holds every mesh of a
+ * model file ready for upload: packed vertices, 16 or 32 bit indices, bounds and
+ * the picking triangles. It is written next to the model as "<model>.irismesh".
+ *
+ * Loading memory-maps the cooked file and uploads straight from the mapping, so
+ * opening a scene doesnt run assimp for models that were cooked before.
+ * The cooked file stores the model's modification time, size and sha-1 and is
+ * ignored once any of them changes.
+ */
+class MeshCooker
+{
+public:
+    static QString getCookedPath(const QString& sourcePath);
+
+    /**
+     * Converts mesh to the compact vertex format:
+     * positions stay floats, normals and tangents become normalized bytes and texture
+     * coordinates become half floats when they are within the range where half floats
+     * keep about a texel of precision on a 1024 texture, floats otherwise.
+     * Indices are 16 bit for meshes with up to 65535 vertices.
+     * Faces that arent triangles are skipped.
+     */
+    static void pack(const aiMesh* mesh, PackedMesh& packed);
+
+    /**
+     * Creates meshes from the cooked file of sourcePath.
+     * Meshes without positions are added as nullptr so the others keep their indices.
+     * @return false if there is no cooked file, it is out of date or it is invalid
+     */
+    static bool load(const QString& sourcePath, QList<Mesh*>& meshes);
+
+    /**
+     * Cooks the meshes of scene, which was imported from sourcePath.
+     * Does nothing if the cooked file is already up to date.
+     * @return false if the file couldnt be written, e.g. the folder is read-only
+     */
+    static bool save(const QString& sourcePath, const aiScene* scene);
+};
+
+}
+
+#endif // MESHCOOKER_H
@@ -0,0 +1,162 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "particlepool.h"
+
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define PARTICLE_RESTRICT __restrict
+#else
+#define PARTICLE_RESTRICT
+#endif
+
+namespace iris
+{
+
+namespace
+{
+
+/**
+ * Applies gravity and velocity to count particles.
+ * The arrays dont alias so the compiler is free to vectorize the loop.
+ */
+void integrate(int count, float delta,
+               float* PARTICLE_RESTRICT posX, float* PARTICLE_RESTRICT posY, float* PARTICLE_RESTRICT posZ,
+               const float* PARTICLE_RESTRICT velX, float* PARTICLE_RESTRICT velY, const float* PARTICLE_RESTRICT velZ,
+               const float* PARTICLE_RESTRICT gravityEffect, float* PARTICLE_RESTRICT elapsedTime)
+{
+    const float gravityStep = ParticlePool::gravity * delta;
+
+    for (int i = 0; i < count; i++) {
+        velY[i] += gravityStep * gravityEffect[i];
+
+        posX[i] += velX[i] * delta;
+        posY[i] += velY[i] * delta;
+        posZ[i] += velZ[i] * delta;
+
+        elapsedTime[i] += delta;
+    }
+}
+
+void shrink(int count, float* PARTICLE_RESTRICT scale,
+            const float* PARTICLE_RESTRICT elapsedTime, const float* PARTICLE_RESTRICT lifeLength)
+{
+    for (int i = 0; i < count; i++)
+        scale[i] *= 1.0f - elapsedTime[i] / lifeLength[i];
+}
+
+void grow(int count, float baseScale, float* PARTICLE_RESTRICT scale,
+          const float* PARTICLE_RESTRICT elapsedTime, const float* PARTICLE_RESTRICT lifeLength)
+{
+    for (int i = 0; i < count; i++)
+        scale[i] = baseScale * (elapsedTime[i] / lifeLength[i]);
+}
+
+}
+
+ParticlePool::ParticlePool(int capacity)
+{
+    this->capacity = 0;
+    count = 0;
+    setCapacity(capacity);
+}
+
+void ParticlePool::setCapacity(int capacity)
+{
+    this->capacity = qMax(capacity, 0);
+    count = qMin(count, this->capacity);
+
+    for (auto array : {&positionX, &positionY, &positionZ,
+                       &velocityX, &velocityY, &velocityZ,
+                       &gravityEffect, &lifeLength, &elapsedTime,
+                       &rotation, &scale}) {
+        array->resize(this->capacity);
+    }
+}
+
+bool ParticlePool::emit(const QVector3D& position, const QVector3D& velocity,
+                        float gravityEffect, float lifeLength, float rotation, float scale)
+{
+    if (count == capacity)
+        return false;
+
+    int i = count++;
+    positionX[i] = position.x();
+    positionY[i] = position.y();
+    positionZ[i] = position.z();
+    velocityX[i] = velocity.x();
+    velocityY[i] = velocity.y();
+    velocityZ[i] = velocity.z();
+    this->gravityEffect[i] = gravityEffect;
+    this->lifeLength[i] = lifeLength;
+    elapsedTime[i] = 0.0f;
+    this->rotation[i] = rotation;
+    this->scale[i] = scale;
+
+    return true;
+}
+
+void ParticlePool::update(float delta, ParticleDissipation dissipation, float baseScale)
+{
+    simulate(0, count, delta, dissipation, baseScale);
+    removeDeadParticles();
+}
+
+void ParticlePool::simulate(int begin, int end, float delta, ParticleDissipation dissipation, float baseScale)
+{
+    end = qMin(end, count);
+    int rangeCount = end - begin;
+    if (rangeCount <= 0)
+        return;
+
+    integrate(rangeCount, delta,
+              positionX.data() + begin, positionY.data() + begin, positionZ.data() + begin,
+              velocityX.constData() + begin, velocityY.data() + begin, velocityZ.constData() + begin,
+              gravityEffect.constData() + begin, elapsedTime.data() + begin);
+
+    // in the future we can add more forces here, such as wind
+    if (dissipation == ParticleDissipation::Shrink) {
+        shrink(rangeCount, scale.data() + begin, elapsedTime.constData() + begin, lifeLength.constData() + begin);
+    } else if (dissipation == ParticleDissipation::Grow) {
+        grow(rangeCount, baseScale, scale.data() + begin, elapsedTime.constData() + begin, lifeLength.constData() + begin);
+    }
+}
+
+void ParticlePool::clear()
+{
+    count = 0;
+}
+
+void ParticlePool::removeDeadParticles()
+{
+    // the last particle is moved into the dead one's slot, so the slot is checked again
+    int i = 0;
+    while (i < count) {
+        if (elapsedTime[i] <= lifeLength[i]) {
+            i++;
+            continue;
+        }
+
+        int last = --count;
+        positionX[i] = positionX[last];
+        positionY[i] = positionY[last];
+        positionZ[i] = positionZ[last];
+        velocityX[i] = velocityX[last];
+        velocityY[i] = velocityY[last];
+        velocityZ[i] = velocityZ[last];
+        gravityEffect[i] = gravityEffect[last];
+        lifeLength[i] = lifeLength[last];
+        elapsedTime[i] = elapsedTime[last];
+        rotation[i] = rotation[last];
+        scale[i] = scale[last];
+    }
+}
+
+}
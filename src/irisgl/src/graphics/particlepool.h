@@ -0,0 +1,121 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef PARTICLEPOOL_H
+#define PARTICLEPOOL_H
+
+#include <QVector>
+#include <QVector3D>
+
+namespace iris
+{
+
+enum class ParticleDissipation
+{
+    None,
+    // scale shrinks towards 0 over the particle's life
+    Shrink,
+    // scale grows from 0 to the base scale over the particle's life
+    Grow
+};
+
+/**
+ * Fixed capacity particle storage. Each property is kept in its own array so
+ * the update loops run over contiguous floats and can be vectorized.
+ * Live particles are always packed at the start of the arrays, dead ones are
+ * replaced by the last live particle.
+ */
+class ParticlePool
+{
+public:
+    // acceleration of particles with a gravity effect of 1
+    static constexpr float gravity = -50.0f;
+
+    ParticlePool(int capacity = 0);
+
+    /**
+     * Changes the maximum number of particles. Particles beyond the new capacity are removed.
+     */
+    void setCapacity(int capacity);
+
+    int getCapacity() const
+    {
+        return capacity;
+    }
+
+    int getCount() const
+    {
+        return count;
+    }
+
+    /**
+     * Adds a particle
+     * @return false if the pool is full
+     */
+    bool emit(const QVector3D& position, const QVector3D& velocity,
+              float gravityEffect, float lifeLength, float rotation, float scale);
+
+    /**
+     * Moves the particles by delta seconds then removes the ones that outlived their life length
+     * @param baseScale scale that ParticleDissipation::Grow grows towards
+     */
+    void update(float delta, ParticleDissipation dissipation, float baseScale);
+
+    /**
+     * Moves the particles in [begin, end) without removing dead ones.
+     * Disjoint ranges can be simulated on different threads.
+     */
+    void simulate(int begin, int end, float delta, ParticleDissipation dissipation, float baseScale);
+
+    /**
+     * Removes the particles that outlived their life length
+     */
+    void removeDeadParticles();
+
+    void clear();
+
+    QVector3D getPosition(int index) const
+    {
+        return QVector3D(positionX[index], positionY[index], positionZ[index]);
+    }
+
+    float getRotation(int index) const
+    {
+        return rotation[index];
+    }
+
+    float getScale(int index) const
+    {
+        return scale[index];
+    }
+
+    // seconds until the particle dies
+    float getLife(int index) const
+    {
+        return lifeLength[index] - elapsedTime[index];
+    }
+
+private:
+    int capacity;
+    int count;
+
+    QVector<float> positionX, positionY, positionZ;
+    QVector<float> velocityX, velocityY, velocityZ;
+    QVector<float> gravityEffect;
+    QVector<float> lifeLength;
+    QVector<float> elapsedTime;
+    QVector<float> rotation;
+    QVector<float> scale;
+};
+
+}
+
+#endif // PARTICLEPOOL_H
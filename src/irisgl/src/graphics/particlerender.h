@@ -13,22 +13,33 @@ For more information see the LICENSE file
 #define PARTICLERENDER_H
 
 #include <QMatrix4x4>
+#include <QVector>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions_3_2_Core>
 #include <QOpenGLContext>
-#include "particle.h"
+#include "particlepool.h"
 #include "renderdata.h"
 #include "texture2d.h"
 #include "../core/irisutils.h"
 
 namespace iris {
 
+/**
+ * Draws a particle system with one instanced call.
+ * The particles are streamed into a texture buffer each frame and the vertex
+ * shader (particle.vert) reads its particle with gl_InstanceID and billboards the quad.
+ */
 class ParticleRenderer {
 
 private:
     GLuint quadVAO, quadVBO;
     QOpenGLFunctions_3_2_Core* gl;
 
+    // per-particle data read by particle.vert, two rgba32f texels per particle
+    GLuint particleBuffer, particleTexture;
+    QVector<float> particleData;
+    int maxParticles;
+
 public:
     bool useAdditive;
 
@@ -56,35 +67,27 @@ public:
                                   (GLvoid*) (3 * sizeof(GLfloat)));
         gl->glBindVertexArray(0);
 
-        useAdditive = true;
-    }
-
-    void updateModelViewMatrix(QOpenGLShaderProgram *shader,
-                               QVector3D pos,
-                               float rot,
-                               float scale,
-                               QMatrix4x4 viewMatrix)
-    {
-        QMatrix4x4 modelMatrix;
-        modelMatrix.translate(pos);
+        GLint maxTexels = 0;
+        gl->glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        maxParticles = maxTexels / 2;
 
-        modelMatrix(0, 0) = viewMatrix(0, 0);
-        modelMatrix(0, 1) = viewMatrix(1, 0);
-        modelMatrix(0, 2) = viewMatrix(2, 0);
+        gl->glGenBuffers(1, &particleBuffer);
+        gl->glBindBuffer(GL_TEXTURE_BUFFER, particleBuffer);
+        gl->glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+        gl->glGenTextures(1, &particleTexture);
+        gl->glBindTexture(GL_TEXTURE_BUFFER, particleTexture);
+        gl->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, particleBuffer);
+        gl->glBindTexture(GL_TEXTURE_BUFFER, 0);
+        gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
-        modelMatrix(1, 0) = viewMatrix(0, 1);
-        modelMatrix(1, 1) = viewMatrix(1, 1);
-        modelMatrix(1, 2) = viewMatrix(2, 1);
-
-        modelMatrix(2, 0) = viewMatrix(0, 2);
-        modelMatrix(2, 1) = viewMatrix(1, 2);
-        modelMatrix(2, 2) = viewMatrix(2, 2);
-
-        modelMatrix.rotate((float) rot, QVector3D(0, 0, 1));
-        modelMatrix.scale(scale, scale, scale);
+        useAdditive = true;
+    }
 
-        QMatrix4x4 modelViewMatrix = viewMatrix * modelMatrix;
-        shader->setUniformValue("modelViewMatrix", modelViewMatrix);
+    ~ParticleRenderer() {
+        gl->glDeleteTextures(1, &particleTexture);
+        gl->glDeleteBuffers(1, &particleBuffer);
+        gl->glDeleteBuffers(1, &quadVBO);
+        gl->glDeleteVertexArrays(1, &quadVAO);
     }
 
     void setIcon(QSharedPointer<iris::Texture2D> icon) {
@@ -93,12 +96,46 @@ public:
 
     void render(QOpenGLShaderProgram *shader,
                 iris::RenderData* renderData,
-                std::list<Particle*>& particles)
+                const ParticlePool& particles)
     {
+        int count = qMin(particles.getCount(), maxParticles);
+        if (count == 0) return;
+
+        particleData.resize(count * 8);
+        auto dest = particleData.data();
+        for (int i = 0; i < count; i++) {
+            auto pos = particles.getPosition(i);
+            dest[0] = pos.x();
+            dest[1] = pos.y();
+            dest[2] = pos.z();
+            dest[3] = particles.getRotation(i);
+            dest[4] = particles.getScale(i);
+            dest[5] = particles.getLife(i);
+            dest[6] = 0.0f;
+            dest[7] = 0.0f;
+            dest += 8;
+        }
+
+        // orphaned so the upload doesnt wait on last frame's draw
+        gl->glBindBuffer(GL_TEXTURE_BUFFER, particleBuffer);
+        gl->glBufferData(GL_TEXTURE_BUFFER, particleData.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        gl->glBufferSubData(GL_TEXTURE_BUFFER, 0, particleData.size() * sizeof(float), particleData.constData());
+        gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
         shader->bind();
 
         shader->setUniformValue("projectionMatrix", renderData->projMatrix);
-        QMatrix4x4 viewMatrix = renderData->viewMatrix;
+        shader->setUniformValue("viewMatrix", renderData->viewMatrix);
+        shader->setUniformValue("pTex", 0);
+        shader->setUniformValue("u_particleData", 1);
+
+        if (!!icon) {
+            gl->glActiveTexture(GL_TEXTURE0);
+            icon->texture->bind();
+        }
+
+        gl->glActiveTexture(GL_TEXTURE1);
+        gl->glBindTexture(GL_TEXTURE_BUFFER, particleTexture);
 
         gl->glBindVertexArray(quadVAO);
         gl->glEnable(GL_BLEND);
@@ -111,26 +148,15 @@ public:
 
         gl->glDepthMask(GL_FALSE);
 
-        for (auto particle : particles) {
-            updateModelViewMatrix(
-                        shader,
-                        particle->getPosition(),
-                        particle->getRotation(),
-                        particle->getScale(),
-                        viewMatrix
-                    );
-
-            if (!!icon) {
-                gl->glActiveTexture(GL_TEXTURE0);
-                icon->texture->bind();
-            }
-            gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-        }
+        gl->glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
 
         gl->glDepthMask(GL_TRUE);
         gl->glDisable(GL_BLEND);
         gl->glBindVertexArray(0);
 
+        gl->glBindTexture(GL_TEXTURE_BUFFER, 0);
+        gl->glActiveTexture(GL_TEXTURE0);
+
         shader->release();
     }
 };
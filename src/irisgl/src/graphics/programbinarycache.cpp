@@ -0,0 +1,258 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "programbinarycache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QOpenGLShaderProgram>
+#include <cstring>
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace iris
+{
+
+namespace
+{
+
+typedef void (QOPENGLF_APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length,
+                                                      GLenum* binaryFormat, void* binary);
+typedef void (QOPENGLF_APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat,
+                                                   const void* binary, GLsizei length);
+typedef void (QOPENGLF_APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+struct BinaryFunctions
+{
+    QOpenGLFunctions_3_2_Core* gl;
+    GetProgramBinaryProc getProgramBinary;
+    ProgramBinaryProc programBinary;
+    ProgramParameteriProc programParameteri;
+
+    bool isValid() const
+    {
+        return getProgramBinary != nullptr && programBinary != nullptr && programParameteri != nullptr;
+    }
+};
+
+// written at the start of every binary file
+struct BinaryHeader
+{
+    char magic[8];
+    quint32 format;
+    quint32 length;
+};
+
+const char binaryMagic[8] = {'I', 'R', 'I', 'S', 'P', 'R', 'G', '1'};
+
+BinaryFunctions getBinaryFunctions()
+{
+    BinaryFunctions funcs;
+    funcs.gl = nullptr;
+    funcs.getProgramBinary = nullptr;
+    funcs.programBinary = nullptr;
+    funcs.programParameteri = nullptr;
+
+    auto context = QOpenGLContext::currentContext();
+    if (context == nullptr)
+        return funcs;
+
+    auto format = context->format();
+    bool isCore41 = format.majorVersion() > 4 || (format.majorVersion() == 4 && format.minorVersion() >= 1);
+    if (!isCore41 && !context->hasExtension("GL_ARB_get_program_binary"))
+        return funcs;
+
+    funcs.gl = context->versionFunctions<QOpenGLFunctions_3_2_Core>();
+    funcs.getProgramBinary = (GetProgramBinaryProc)context->getProcAddress("glGetProgramBinary");
+    funcs.programBinary = (ProgramBinaryProc)context->getProcAddress("glProgramBinary");
+    funcs.programParameteri = (ProgramParameteriProc)context->getProcAddress("glProgramParameteri");
+
+    // some drivers expose the extension but dont support any binary format
+    if (funcs.isValid()) {
+        GLint numFormats = 0;
+        funcs.gl->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        if (numFormats == 0)
+            funcs.getProgramBinary = nullptr;
+    }
+
+    return funcs;
+}
+
+}
+
+bool ProgramBinaryCache::isSupported()
+{
+    return getBinaryFunctions().isValid();
+}
+
+QByteArray ProgramBinaryCache::createKey(const QString& vertexSource,
+                                         const QString& fragmentSource,
+                                         const QString& attribBindings)
+{
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexSource.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(fragmentSource.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(attribBindings.toUtf8());
+
+    // binaries are only valid for the driver that created them
+    hash.addData((const char*)gl->glGetString(GL_VENDOR));
+    hash.addData((const char*)gl->glGetString(GL_RENDERER));
+    hash.addData((const char*)gl->glGetString(GL_VERSION));
+
+    return hash.result().toHex();
+}
+
+bool ProgramBinaryCache::load(QOpenGLShaderProgram* program, const QByteArray& key)
+{
+    auto funcs = getBinaryFunctions();
+    if (!funcs.isValid())
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(getBinaryPath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        stats.binaryMisses++;
+        return false;
+    }
+
+    auto data = file.readAll();
+    file.close();
+
+    BinaryHeader header;
+    if (data.size() < (int)sizeof(header)) {
+        stats.binaryMisses++;
+        QFile::remove(getBinaryPath(key));
+        return false;
+    }
+
+    memcpy(&header, data.constData(), sizeof(header));
+    if (memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0 ||
+        (int)header.length != data.size() - (int)sizeof(header)) {
+        stats.binaryMisses++;
+        QFile::remove(getBinaryPath(key));
+        return false;
+    }
+
+    program->create();
+    funcs.programBinary(program->programId(),
+                        header.format,
+                        data.constData() + sizeof(header),
+                        header.length);
+
+    // with no shaders attached link() only checks the link status set by glProgramBinary
+    if (!program->link()) {
+        stats.binaryRejected++;
+        QFile::remove(getBinaryPath(key));
+        return false;
+    }
+
+    stats.binaryHits++;
+    stats.loadTimeMs += timer.nsecsElapsed() / 1000000.0f;
+
+    return true;
+}
+
+void ProgramBinaryCache::prepare(QOpenGLShaderProgram* program)
+{
+    auto funcs = getBinaryFunctions();
+    if (!funcs.isValid())
+        return;
+
+    program->create();
+    funcs.programParameteri(program->programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramBinaryCache::save(QOpenGLShaderProgram* program, const QByteArray& key)
+{
+    auto funcs = getBinaryFunctions();
+    if (!funcs.isValid() || !program->isLinked())
+        return;
+
+    auto programId = program->programId();
+
+    GLint length = 0;
+    funcs.gl->glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    QByteArray data(sizeof(BinaryHeader) + length, 0);
+
+    BinaryHeader header;
+    memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+
+    GLenum format = 0;
+    GLsizei written = 0;
+    funcs.getProgramBinary(programId, length, &written, &format, data.data() + sizeof(header));
+    if (written <= 0)
+        return;
+
+    header.format = format;
+    header.length = written;
+    memcpy(data.data(), &header, sizeof(header));
+    data.resize(sizeof(header) + written);
+
+    QDir().mkpath(getCacheDir());
+
+    // a half written file would be rejected on load anyway but QSaveFile avoids writing one
+    QSaveFile file(getBinaryPath(key));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    file.write(data);
+    file.commit();
+}
+
+QString ProgramBinaryCache::getCacheDir()
+{
+    if (cacheDir.isEmpty()) {
+        auto base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        cacheDir = QDir(base).filePath("shaders");
+    }
+
+    return cacheDir;
+}
+
+void ProgramBinaryCache::setCacheDir(const QString& dir)
+{
+    cacheDir = dir;
+}
+
+QString ProgramBinaryCache::getBinaryPath(const QByteArray& key)
+{
+    return QDir(getCacheDir()).filePath(QString::fromLatin1(key) + ".bin");
+}
+
+QString ProgramBinaryCache::cacheDir;
+ProgramBinaryCacheStats ProgramBinaryCache::stats;
+
+}
@@ -0,0 +1,115 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef PROGRAMBINARYCACHE_H
+#define PROGRAMBINARYCACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+class QOpenGLShaderProgram;
+
+namespace iris
+{
+
+struct ProgramBinaryCacheStats
+{
+    // programs restored from a binary on disk
+    int binaryHits;
+    // programs with no binary on disk
+    int binaryMisses;
+    // binaries the driver refused, usually after a driver update
+    int binaryRejected;
+
+    // time spent restoring binaries
+    float loadTimeMs;
+    // time spent compiling and linking programs from source
+    float compileTimeMs;
+
+    ProgramBinaryCacheStats()
+    {
+        binaryHits = 0;
+        binaryMisses = 0;
+        binaryRejected = 0;
+        loadTimeMs = 0;
+        compileTimeMs = 0;
+    }
+};
+
+/**
+ * Stores linked programs on disk with glGetProgramBinary so later runs can skip
+ * compiling and linking.
+ * Binaries are keyed by the preprocessed sources, the attribute bindings and the gl
+ * vendor, renderer and version strings, so a driver or gpu change never picks up an
+ * incompatible binary. If the driver refuses a binary anyway, the caller compiles the
+ * program from source.
+ * GL_ARB_get_program_binary isnt part of gl 3.2 so every function does nothing
+ * when the current context doesnt expose it.
+ */
+class ProgramBinaryCache
+{
+public:
+    /**
+     * Returns true if the current context can save and load program binaries
+     */
+    static bool isSupported();
+
+    static QByteArray createKey(const QString& vertexSource,
+                                const QString& fragmentSource,
+                                const QString& attribBindings);
+
+    /**
+     * Tries to restore program from the binary stored for key.
+     * @param program a program with no shaders attached
+     * @return true if program is linked and ready to use
+     */
+    static bool load(QOpenGLShaderProgram* program, const QByteArray& key);
+
+    /**
+     * Must be called before linking a program that will be saved
+     */
+    static void prepare(QOpenGLShaderProgram* program);
+
+    /**
+     * Writes the binary of a linked program to disk
+     */
+    static void save(QOpenGLShaderProgram* program, const QByteArray& key);
+
+    /**
+     * Adds the time it took to compile a program that wasnt cached to the stats
+     */
+    static void addCompileTime(float timeMs)
+    {
+        stats.compileTimeMs += timeMs;
+    }
+
+    /**
+     * Directory the binaries are written to.
+     * Defaults to a "shaders" folder in the user's cache location.
+     */
+    static QString getCacheDir();
+    static void setCacheDir(const QString& dir);
+
+    static const ProgramBinaryCacheStats& getStats()
+    {
+        return stats;
+    }
+
+private:
+    static QString getBinaryPath(const QByteArray& key);
+
+    static QString cacheDir;
+    static ProgramBinaryCacheStats stats;
+};
+
+}
+
+#endif // PROGRAMBINARYCACHE_H
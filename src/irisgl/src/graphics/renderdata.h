@@ -26,6 +26,12 @@ struct RenderData
     QMatrix4x4 viewMatrix;
     QMatrix4x4 projMatrix;
 
+    // both eyes are drawn in one pass to the halves of a side by side target
+    // viewMatrix and projMatrix then hold a view that covers both eyes, it's used for culling
+    bool stereo;
+    QMatrix4x4 eyeViewMatrices[2];
+    QMatrix4x4 eyeProjMatrices[2];
+
     QVector3D eyePos;
 
     //fog properties
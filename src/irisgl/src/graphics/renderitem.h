@@ -88,10 +88,25 @@ struct RenderItem
     //used if no material is specified
     int renderLayer;
 
+    // items whose mesh is positioned in the vertex shader (such as the sky)
+    // should turn this off so they arent culled by their mesh's bounds
+    bool cullable;
+
+    // transform version of the node worldMatrix was taken from
+    quint64 transformVersion;
+    // frames in a row the item has been submitted without moving
+    // shadow casters that havent moved for a while are drawn into the cached static shadow layer
+    int framesUnchanged;
+
     RenderItem() {
         type = RenderItemType::None,
-        //renderLayer = (int)RenderLayer::Opaque;
+        renderLayer = 2000; // RenderLayer::Opaque
+        shaderProgram = nullptr;
+        mesh = nullptr;
         worldMatrix.setToIdentity();
+        cullable = true;
+        transformVersion = 0;
+        framesUnchanged = 0;
     }
 };
 
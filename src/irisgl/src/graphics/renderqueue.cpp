@@ -0,0 +1,102 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "renderqueue.h"
+#include "renderitem.h"
+#include "material.h"
+#include "mesh.h"
+
+#include <QOpenGLShaderProgram>
+#include <algorithm>
+#include <cstring>
+
+namespace iris
+{
+
+namespace
+{
+
+/**
+ * Returns the bits of a non-negative float. For positive floats the bit
+ * pattern increases with the value so its upper bits can be used as a
+ * quantized depth without knowing the depth range.
+ */
+inline quint32 getDepthBits(float depth)
+{
+    if (!(depth > 0.0f)) depth = 0.0f;
+
+    quint32 bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+}
+
+quint64 RenderQueue::createSortKey(int renderLayer,
+                                   unsigned int programId,
+                                   unsigned int materialId,
+                                   unsigned int vaoId,
+                                   float viewDepth)
+{
+    quint64 layer = (quint64)std::min(std::max(renderLayer, 0), 0xFFFF);
+    quint64 program = programId & 0xFFF;
+    quint64 material = materialId & 0xFFF;
+    quint64 depthBits = getDepthBits(viewDepth);
+
+    if (renderLayer >= (int)RenderLayer::Transparent) {
+        // far items first
+        quint64 invertedDepth = (~depthBits >> 8) & 0xFFFFFF;
+        return (layer << 48) | (invertedDepth << 24) | (program << 12) | material;
+    }
+
+    quint64 vao = vaoId & 0xFF;
+    quint64 depth = depthBits >> 16;
+    return (layer << 48) | (program << 36) | (material << 24) | (vao << 16) | depth;
+}
+
+void RenderQueue::add(RenderItem* item, const QMatrix4x4& viewMatrix)
+{
+    unsigned int programId = 0;
+    unsigned int materialId = 0;
+    unsigned int vaoId = 0;
+
+    if (!!item->material) {
+        programId = item->material->program->programId();
+        materialId = item->material->materialId;
+    } else if (item->shaderProgram != nullptr) {
+        programId = item->shaderProgram->programId();
+    }
+
+    QVector3D center = item->worldMatrix.column(3).toVector3D();
+    if (item->mesh != nullptr) {
+        vaoId = item->mesh->vao;
+
+        if (!item->mesh->boundingBox.isEmpty())
+            center = item->worldMatrix * item->mesh->boundingBox.getCenter();
+    }
+
+    // the camera looks down -z in view space
+    float viewDepth = -(viewMatrix * center).z();
+
+    RenderQueueItem queueItem;
+    queueItem.sortKey = createSortKey(item->renderLayer, programId, materialId, vaoId, viewDepth);
+    queueItem.item = item;
+    items.append(queueItem);
+}
+
+void RenderQueue::sort()
+{
+    std::sort(items.begin(), items.end(), [](const RenderQueueItem& a, const RenderQueueItem& b) {
+        return a.sortKey < b.sortKey;
+    });
+}
+
+}
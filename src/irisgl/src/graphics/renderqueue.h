@@ -0,0 +1,70 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <QVector>
+#include <QMatrix4x4>
+#include "../irisglfwd.h"
+
+namespace iris
+{
+
+struct RenderQueueItem
+{
+    quint64 sortKey;
+    RenderItem* item;
+};
+
+/**
+ * Orders render items so that items sharing the same state are drawn one after another.
+ * Each item gets a 64 bit key and the queue is sorted by it.
+ *
+ * Layers below RenderLayer::Transparent are sorted by state then front to back:
+ * | layer 16 | program 12 | material 12 | vao 8 | depth 16 |
+ *
+ * Transparent layers and above have to be blended in order so depth comes first, back to front:
+ * | layer 16 | inverted depth 24 | program 12 | material 12 |
+ *
+ * Ids are truncated to fit their fields. Two different ids sharing a field value only
+ * means their items may not be grouped together, it never affects correctness.
+ */
+class RenderQueue
+{
+public:
+    QVector<RenderQueueItem> items;
+
+    void clear()
+    {
+        items.clear();
+    }
+
+    /**
+     * Adds item to queue. viewMatrix is used to calculate the item's distance
+     * from the eye.
+     * @param item
+     * @param viewMatrix
+     */
+    void add(RenderItem* item, const QMatrix4x4& viewMatrix);
+
+    void sort();
+
+    static quint64 createSortKey(int renderLayer,
+                                 unsigned int programId,
+                                 unsigned int materialId,
+                                 unsigned int vaoId,
+                                 float viewDepth);
+};
+
+}
+
+#endif // RENDERQUEUE_H
@@ -17,10 +17,43 @@ For more information see the LICENSE file
 #include "texture.h"
 #include <QOpenGLTexture>
 #include "mesh.h"
+#include "graphicshelper.h"
 
 namespace iris
 {
 
+namespace
+{
+
+// names of the ShaderUniform values, in order
+const char* standardUniformNames[(int)ShaderUniform::Count] = {
+    "u_worldMatrix",
+    "u_normalMatrix",
+    "u_viewMatrix",
+    "u_projMatrix",
+    "u_eyePos",
+
+    "u_fogData.color",
+    "u_fogData.start",
+    "u_fogData.end",
+    "u_fogData.enabled",
+
+    "u_shadowMap",
+    "u_shadowEnabled",
+    "u_lightSpaceMatrix",
+
+    "u_lightCount",
+
+    "u_instanced",
+    "u_instanceOffset",
+    "u_instanceData",
+    "u_stereo",
+
+    "u_clusterLights",
+    "u_clusterData"
+};
+
+}
 
 Shader::~Shader()
 {
@@ -39,7 +72,8 @@ Shader::~Shader()
         delete iter.value();
     }
 
-    delete program;
+    if (ownsProgram)
+        delete program;
 }
 
 ShaderPtr Shader::load(QOpenGLFunctions_3_2_Core* gl,QString vertexShaderFile,QString fragmentShaderFile)
@@ -61,9 +95,28 @@ ShaderPtr Shader::create(QOpenGLFunctions_3_2_Core* gl,QString vertexShader,QStr
     return ShaderPtr(new Shader(gl,vertexShader,fragmentShader));
 }
 
+ShaderPtr Shader::createFromProgram(QOpenGLFunctions_3_2_Core* gl,
+                                    QOpenGLShaderProgram* program,
+                                    bool ownsProgram)
+{
+    return ShaderPtr(new Shader(gl, program, ownsProgram));
+}
+
+Shader::Shader(QOpenGLFunctions_3_2_Core* gl, QOpenGLShaderProgram* program, bool ownsProgram)
+{
+    this->gl = gl;
+    this->program = program;
+    this->ownsProgram = ownsProgram;
+    shaderId = generateNodeId();
+
+    reflectProgram();
+    resolveStandardLocations();
+}
+
 Shader::Shader(QOpenGLFunctions_3_2_Core* gl,QString vertexShader,QString fragmentShader)
 {
     this->gl = gl;
+    this->ownsProgram = true;
     shaderId = generateNodeId();
 
     QOpenGLShader *vshader = new QOpenGLShader(QOpenGLShader::Vertex);
@@ -88,6 +141,14 @@ Shader::Shader(QOpenGLFunctions_3_2_Core* gl,QString vertexShader,QString fragme
 
     //todo: check for errors
 
+    GraphicsHelper::bindUniformBlocks(program);
+
+    reflectProgram();
+    resolveStandardLocations();
+}
+
+void Shader::reflectProgram()
+{
     //get attribs, uniforms and samplers
     //http://stackoverflow.com/questions/440144/in-opengl-is-there-a-way-to-get-a-list-of-all-uniforms-attribs-used-by-a-shade
     auto programId = program->programId();
@@ -193,6 +254,50 @@ ShaderValue* Shader::getUniform(QString name)
     return nullptr;
 }
 
+int Shader::getUniformLocation(const QString& name)
+{
+    auto iter = namedLocations.constFind(name);
+    if (iter != namedLocations.constEnd())
+        return iter.value();
+
+    int location = program->uniformLocation(name);
+    namedLocations.insert(name, location);
+    return location;
+}
+
+void Shader::resolveStandardLocations()
+{
+    for (int i = 0; i < (int)ShaderUniform::Count; i++) {
+        standardLocations[i] = program->uniformLocation(standardUniformNames[i]);
+    }
+
+    // shaders using the uniform blocks cant keep the flag in the u_fogData struct
+    if (standardLocations[(int)ShaderUniform::FogEnabled] == -1)
+        standardLocations[(int)ShaderUniform::FogEnabled] = program->uniformLocation("u_fogEnabled");
+
+    auto programId = program->programId();
+    hasFrameBlock = gl->glGetUniformBlockIndex(programId, "FrameData") != GL_INVALID_INDEX;
+    hasLightBlock = gl->glGetUniformBlockIndex(programId, "LightData") != GL_INVALID_INDEX;
+
+    for (int i = 0; i < SHADER_MAX_LIGHTS; i++) {
+        auto prefix = QString("u_lights[%0].").arg(i);
+        auto& light = lightLocations[i];
+
+        light.type              = program->uniformLocation(prefix + "type");
+        light.position          = program->uniformLocation(prefix + "position");
+        light.distance          = program->uniformLocation(prefix + "distance");
+        light.direction         = program->uniformLocation(prefix + "direction");
+        light.cutOffAngle       = program->uniformLocation(prefix + "cutOffAngle");
+        light.cutOffSoftness    = program->uniformLocation(prefix + "cutOffSoftness");
+        light.intensity         = program->uniformLocation(prefix + "intensity");
+        light.color             = program->uniformLocation(prefix + "color");
+
+        light.constantAtten     = program->uniformLocation(prefix + "constantAtten");
+        light.linearAtten       = program->uniformLocation(prefix + "linearAtten");
+        light.quadraticAtten    = program->uniformLocation(prefix + "quadtraticAtten");
+    }
+}
+
 long Shader::generateNodeId()
 {
     return nextId++;
@@ -14,6 +14,7 @@ For more information see the LICENSE file
 
 #include "../irisglfwd.h"
 #include <QVariant>
+#include <QHash>
 #include <qopengl.h>
 
 class QOpenGLShaderProgram;
@@ -23,6 +24,62 @@ class QOpenGLTexture;
 namespace iris
 {
 
+// size of the u_lights array in the built-in shaders
+#define SHADER_MAX_LIGHTS 8
+
+/**
+ * Uniforms the renderer sets on every program it draws with.
+ * Their locations are resolved when the Shader is created.
+ */
+enum class ShaderUniform : int
+{
+    WorldMatrix = 0,
+    NormalMatrix,
+    ViewMatrix,
+    ProjMatrix,
+    EyePos,
+
+    FogColor,
+    FogStart,
+    FogEnd,
+    FogEnabled,
+
+    ShadowMap,
+    ShadowEnabled,
+    LightSpaceMatrix,
+
+    LightCount,
+
+    Instanced,
+    InstanceOffset,
+    InstanceData,
+    Stereo,
+
+    ClusterLights,
+    ClusterData,
+
+    Count
+};
+
+/**
+ * Locations of the fields of one element of u_lights
+ */
+struct ShaderLightLocations
+{
+    int type;
+    int position;
+    int distance;
+    int direction;
+    int cutOffAngle;
+    int cutOffSoftness;
+    int intensity;
+    int color;
+
+    int constantAtten;
+    int linearAtten;
+    int quadraticAtten;
+};
+
 class ShaderValue
 {
 
@@ -70,6 +127,16 @@ public:
     static ShaderPtr load(QOpenGLFunctions_3_2_Core* gl, QString vertexShaderFile, QString fragmentShaderFile);
     static ShaderPtr create(QOpenGLFunctions_3_2_Core* gl, QString vertexShader, QString fragmentShader);
 
+    /**
+     * Wraps an already linked program so its uniform locations can be cached.
+     * @param gl
+     * @param program
+     * @param ownsProgram if true, the program is deleted with the shader
+     */
+    static ShaderPtr createFromProgram(QOpenGLFunctions_3_2_Core* gl,
+                                       QOpenGLShaderProgram* program,
+                                       bool ownsProgram = false);
+
     QOpenGLShaderProgram* program;
     long shaderId;
 
@@ -80,6 +147,56 @@ public:
 
     ShaderValue* getUniform(QString name);
 
+    /**
+     * Returns the location of an engine uniform or -1 if the program doesnt use it.
+     * Setting a uniform at location -1 is a no-op so the result can be used directly.
+     */
+    int getUniformLocation(ShaderUniform uniform) const
+    {
+        return standardLocations[(int)uniform];
+    }
+
+    /**
+     * Returns the locations of u_lights[index]'s fields
+     * @param index must be less than SHADER_MAX_LIGHTS
+     */
+    const ShaderLightLocations& getLightLocations(int index) const
+    {
+        return lightLocations[index];
+    }
+
+    /**
+     * Returns the location of a uniform by name. The location is queried
+     * from gl the first time a name is asked for and cached after that.
+     * @param name
+     */
+    int getUniformLocation(const QString& name);
+
+    /**
+     * Returns true if the program gets its camera and fog data from the FrameData block
+     */
+    bool usesFrameBlock() const
+    {
+        return hasFrameBlock;
+    }
+
+    /**
+     * Returns true if the program gets its lights from the LightData block
+     */
+    bool usesLightBlock() const
+    {
+        return hasLightBlock;
+    }
+
+    /**
+     * Returns true if the program reads its transforms through instancing.glsl
+     * and so can be drawn instanced
+     */
+    bool supportsInstancing() const
+    {
+        return standardLocations[(int)ShaderUniform::InstanceData] != -1;
+    }
+
     template <typename T>
     void setUniformValue(QString name, T value)
     {
@@ -102,7 +219,20 @@ public:
 
 private:
     Shader(QOpenGLFunctions_3_2_Core* gl, QString vertexShader, QString fragmentShader);
+    Shader(QOpenGLFunctions_3_2_Core* gl, QOpenGLShaderProgram* program, bool ownsProgram);
     QOpenGLFunctions_3_2_Core* gl;
+    bool ownsProgram;
+
+    void reflectProgram();
+    void resolveStandardLocations();
+
+    int standardLocations[(int)ShaderUniform::Count];
+    bool hasFrameBlock;
+    bool hasLightBlock;
+    ShaderLightLocations lightLocations[SHADER_MAX_LIGHTS];
+
+    // lazily resolved locations, misses are cached as -1 too
+    QHash<QString, int> namedLocations;
 
     static long generateNodeId();
     static long nextId;
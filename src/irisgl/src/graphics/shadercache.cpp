@@ -0,0 +1,103 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "shadercache.h"
+#include "shader.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QOpenGLShaderProgram>
+
+namespace iris
+{
+
+QOpenGLShaderProgram* ShaderCache::findProgram(const QByteArray& key)
+{
+    auto iter = programs.constFind(key);
+    if (iter != programs.constEnd()) {
+        stats.programHits++;
+        return iter.value();
+    }
+
+    stats.programMisses++;
+    return nullptr;
+}
+
+void ShaderCache::addProgram(const QByteArray& key, QOpenGLShaderProgram* program)
+{
+    programs.insert(key, program);
+}
+
+QByteArray ShaderCache::createProgramKey(const QString& vertexSource,
+                                         const QString& fragmentSource,
+                                         const QString& attribBindings)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexSource.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(fragmentSource.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(attribBindings.toUtf8());
+
+    auto shareGroup = QOpenGLContext::currentContext()->shareGroup();
+    hash.addData((const char*)&shareGroup, sizeof(shareGroup));
+
+    return hash.result();
+}
+
+QByteArray ShaderCache::readFile(const QString& path)
+{
+    bool isResource = path.startsWith(":") || path.startsWith("qrc:");
+    qint64 lastModified = 0;
+    if (!isResource)
+        lastModified = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+
+    auto iter = files.constFind(path);
+    if (iter != files.constEnd() && iter.value().lastModified == lastModified) {
+        stats.fileHits++;
+        return iter.value().contents;
+    }
+
+    stats.fileMisses++;
+
+    QFile file(path);
+    file.open(QIODevice::ReadOnly | QIODevice::Text);
+
+    FileEntry entry;
+    entry.contents = file.readAll();
+    entry.lastModified = lastModified;
+    files.insert(path, entry);
+
+    return entry.contents;
+}
+
+ShaderPtr ShaderCache::getShader(QOpenGLShaderProgram* program)
+{
+    auto iter = shaders.constFind(program);
+    if (iter != shaders.constEnd())
+        return iter.value();
+
+    auto gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
+    auto shader = Shader::createFromProgram(gl, program);
+    shaders.insert(program, shader);
+    return shader;
+}
+
+QHash<QByteArray, QOpenGLShaderProgram*> ShaderCache::programs;
+QHash<QOpenGLShaderProgram*, ShaderPtr> ShaderCache::shaders;
+QHash<QString, ShaderCache::FileEntry> ShaderCache::files;
+ShaderCacheStats ShaderCache::stats;
+
+}
@@ -0,0 +1,110 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QHash>
+#include "../irisglfwd.h"
+
+class QOpenGLShaderProgram;
+
+namespace iris
+{
+
+struct ShaderCacheStats
+{
+    // programs returned from the cache
+    int programHits;
+    // programs that had to be compiled and linked
+    int programMisses;
+
+    // shader and include files served from memory
+    int fileHits;
+    // shader and include files read from disk or resources
+    int fileMisses;
+
+    ShaderCacheStats()
+    {
+        programHits = 0;
+        programMisses = 0;
+        fileHits = 0;
+        fileMisses = 0;
+    }
+};
+
+/**
+ * Process-wide cache of linked shader programs.
+ * Programs are keyed by a hash of their fully preprocessed sources, their attribute
+ * bindings and the gl share group they were created in, so materials loading the same
+ * shader files share one QOpenGLShaderProgram.
+ * The cache owns the programs it holds, they live until the end of the process.
+ * Programs are shared so materials must set all of their uniforms in begin().
+ * All functions must be called from the thread with the current gl context.
+ */
+class ShaderCache
+{
+public:
+    /**
+     * Returns the cached program for key or nullptr
+     */
+    static QOpenGLShaderProgram* findProgram(const QByteArray& key);
+
+    /**
+     * Adds a linked program to the cache. The cache takes ownership of it.
+     */
+    static void addProgram(const QByteArray& key, QOpenGLShaderProgram* program);
+
+    /**
+     * Creates the key of a program from its preprocessed sources and attribute bindings.
+     * The current context's share group is part of the key since programs cant be used
+     * in contexts that dont share with the one they were made in.
+     */
+    static QByteArray createProgramKey(const QString& vertexSource,
+                                       const QString& fragmentSource,
+                                       const QString& attribBindings);
+
+    /**
+     * Returns the contents of a shader file, reading it only the first time it's asked for.
+     * Resource files never change so they're always served from the cache. Files on disk
+     * are read again if their modification time changed.
+     */
+    static QByteArray readFile(const QString& path);
+
+    /**
+     * Returns the uniform location cache of a program, creating it on first use.
+     * Every material using the same program shares it.
+     */
+    static ShaderPtr getShader(QOpenGLShaderProgram* program);
+
+    static const ShaderCacheStats& getStats()
+    {
+        return stats;
+    }
+
+private:
+    struct FileEntry
+    {
+        QByteArray contents;
+        qint64 lastModified;
+    };
+
+    static QHash<QByteArray, QOpenGLShaderProgram*> programs;
+    static QHash<QOpenGLShaderProgram*, ShaderPtr> shaders;
+    static QHash<QString, FileEntry> files;
+    static ShaderCacheStats stats;
+};
+
+}
+
+#endif // SHADERCACHE_H
@@ -0,0 +1,140 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "shadowcascades.h"
+
+#include <cmath>
+
+namespace iris
+{
+
+ShadowCascades::ShadowCascades()
+{
+    count = 0;
+    for (int i = 0; i < SHADER_MAX_SHADOW_CASCADES; i++)
+        splits[i] = 0;
+}
+
+void ShadowCascades::calculate(const QMatrix4x4& viewMatrix,
+                               const QMatrix4x4& projMatrix,
+                               const QVector3D& lightDir,
+                               const ShadowSettings& settings)
+{
+    count = qBound(1, settings.cascadeCount, SHADER_MAX_SHADOW_CASCADES);
+    int gridSize = getGridSize(count);
+
+    // near and far planes of a perspective projection
+    float nearClip = projMatrix(2, 3) / (projMatrix(2, 2) - 1.0f);
+    float farClip = projMatrix(2, 3) / (projMatrix(2, 2) + 1.0f);
+    float shadowFar = qMin(farClip, settings.shadowDistance);
+
+    // corners of the near and far planes in world space
+    QVector3D nearCorners[4], farCorners[4];
+    auto invViewProj = (projMatrix * viewMatrix).inverted();
+    for (int i = 0; i < 4; i++) {
+        float x = (i & 1) ? 1.0f : -1.0f;
+        float y = (i & 2) ? 1.0f : -1.0f;
+        nearCorners[i] = invViewProj.map(QVector3D(x, y, -1.0f));
+        farCorners[i] = invViewProj.map(QVector3D(x, y, 1.0f));
+    }
+
+    // rotation only, so moving the camera only translates the cascades in light space
+    QMatrix4x4 lightView = getLightView(lightDir);
+
+    float sliceStart = nearClip;
+    for (int i = 0; i < count; i++) {
+        // practical split scheme, blends logarithmic and uniform splits
+        float p = (i + 1) / (float)count;
+        float logSplit = nearClip * std::pow(shadowFar / nearClip, p);
+        float uniformSplit = nearClip + (shadowFar - nearClip) * p;
+        float sliceEnd = settings.splitLambda * logSplit + (1.0f - settings.splitLambda) * uniformSplit;
+        splits[i] = sliceEnd;
+
+        // corners of the slice, the frustum's edges are lines so they can be interpolated
+        QVector3D corners[8];
+        QVector3D center;
+        float tStart = (sliceStart - nearClip) / (farClip - nearClip);
+        float tEnd = (sliceEnd - nearClip) / (farClip - nearClip);
+        for (int c = 0; c < 4; c++) {
+            corners[c] = nearCorners[c] + (farCorners[c] - nearCorners[c]) * tStart;
+            corners[c + 4] = nearCorners[c] + (farCorners[c] - nearCorners[c]) * tEnd;
+        }
+        for (int c = 0; c < 8; c++)
+            center += corners[c];
+        center /= 8.0f;
+
+        // a bounding sphere keeps the cascade the same size however the camera is rotated
+        float radius = 0;
+        for (int c = 0; c < 8; c++)
+            radius = qMax(radius, (corners[c] - center).length());
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // snapping to whole texels keeps shadow edges still as the camera moves
+        // the center can be snapped up to half a step away, so the cascade is grown by that much
+        // and a couple of texels, for steps of a single texel
+        float halfSize = radius * (1.0f + settings.cascadeStep * 0.5f + 2.0f / settings.cascadeResolution);
+        float texelSize = (2.0f * halfSize) / settings.cascadeResolution;
+        float step = qMax(std::floor(radius * settings.cascadeStep / texelSize), 1.0f) * texelSize;
+
+        // depth is snapped too, so the whole matrix stays the same within a step
+        QVector3D lightCenter = lightView.map(center);
+        lightCenter.setX(std::round(lightCenter.x() / step) * step);
+        lightCenter.setY(std::round(lightCenter.y() / step) * step);
+        lightCenter.setZ(std::round(lightCenter.z() / step) * step);
+
+        QMatrix4x4 lightProj;
+        lightProj.ortho(lightCenter.x() - halfSize, lightCenter.x() + halfSize,
+                        lightCenter.y() - halfSize, lightCenter.y() + halfSize,
+                        -lightCenter.z() - halfSize - settings.casterDistance,
+                        -lightCenter.z() + halfSize);
+
+        lightSpaceMatrices[i] = lightProj * lightView;
+
+        // maps the cascade's clip space onto its tile of the atlas
+        int col = i % gridSize;
+        int row = i / gridSize;
+        QMatrix4x4 tileMatrix;
+        tileMatrix.translate((2 * col + 1) / (float)gridSize - 1.0f,
+                             (2 * row + 1) / (float)gridSize - 1.0f,
+                             0.0f);
+        tileMatrix.scale(1.0f / gridSize, 1.0f / gridSize, 1.0f);
+        atlasMatrices[i] = tileMatrix * lightSpaceMatrices[i];
+
+        tiles[i] = QVector4D(col / (float)gridSize,
+                             row / (float)gridSize,
+                             (col + 1) / (float)gridSize,
+                             (row + 1) / (float)gridSize);
+
+        sliceStart = sliceEnd;
+    }
+}
+
+QMatrix4x4 ShadowCascades::getLightView(const QVector3D& lightDir)
+{
+    QVector3D dir = lightDir.normalized();
+    QVector3D up = qAbs(dir.y()) > 0.99f ? QVector3D(1, 0, 0) : QVector3D(0, 1, 0);
+    QMatrix4x4 lightView;
+    lightView.lookAt(QVector3D(0, 0, 0), dir, up);
+
+    return lightView;
+}
+
+void ShadowCascades::getTileViewport(int cascade, const ShadowSettings& settings, int viewport[4])
+{
+    int gridSize = getGridSize(settings.cascadeCount);
+
+    viewport[0] = (cascade % gridSize) * settings.cascadeResolution;
+    viewport[1] = (cascade / gridSize) * settings.cascadeResolution;
+    viewport[2] = settings.cascadeResolution;
+    viewport[3] = settings.cascadeResolution;
+}
+
+}
@@ -0,0 +1,111 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SHADOWCASCADES_H
+#define SHADOWCASCADES_H
+
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QVector4D>
+
+// size of the u_shadowMatrices array in the built-in shaders
+#define SHADER_MAX_SHADOW_CASCADES 4
+
+namespace iris
+{
+
+struct ShadowSettings
+{
+    // number of slices the view frustum is split into, 1 to SHADER_MAX_SHADOW_CASCADES
+    int cascadeCount;
+    // width and height of each cascade in texels
+    int cascadeResolution;
+
+    // how far from the camera shadows are drawn
+    float shadowDistance;
+    // blends uniform splits (0) with logarithmic ones (1)
+    // higher values put more resolution close to the camera
+    float splitLambda;
+    // how far behind a cascade casters are still drawn into it
+    float casterDistance;
+    // cascades move in steps of this fraction of their radius rather than a texel at a time,
+    // so a cascade's cached static casters are reused while the camera moves within a step.
+    // each cascade is grown by half a step to still cover its slice, 0 moves them by texels
+    float cascadeStep;
+    // keeps the depth of casters that havent moved between frames
+    bool cacheStaticCasters;
+
+    ShadowSettings()
+    {
+        cascadeCount = 4;
+        cascadeResolution = 2048;
+        shadowDistance = 200.0f;
+        splitLambda = 0.75f;
+        casterDistance = 200.0f;
+        cascadeStep = 0.125f;
+        cacheStaticCasters = true;
+    }
+};
+
+/**
+ * Shadow cascades of a directional light for one view.
+ * Every cascade is a tile of one shadow atlas: cascades are laid out in a grid of
+ * getGridSize() by getGridSize() tiles of cascadeResolution texels each.
+ */
+class ShadowCascades
+{
+public:
+    int count;
+
+    // light space matrices each cascade is rendered with
+    QMatrix4x4 lightSpaceMatrices[SHADER_MAX_SHADOW_CASCADES];
+    // the same matrices mapped to the cascade's tile of the atlas, for sampling
+    QMatrix4x4 atlasMatrices[SHADER_MAX_SHADOW_CASCADES];
+    // texture coordinates of the tiles as min x, min y, max x, max y
+    QVector4D tiles[SHADER_MAX_SHADOW_CASCADES];
+    // view space distance at which each cascade ends
+    float splits[SHADER_MAX_SHADOW_CASCADES];
+
+    ShadowCascades();
+
+    /**
+     * Splits the view frustum up to the shadow distance and fits a cascade to each slice.
+     * Each cascade bounds its slice with a sphere so its size doesnt change as the camera
+     * turns, and its position is snapped to steps of whole texels so shadow edges dont
+     * shimmer as the camera moves.
+     */
+    void calculate(const QMatrix4x4& viewMatrix,
+                   const QMatrix4x4& projMatrix,
+                   const QVector3D& lightDir,
+                   const ShadowSettings& settings);
+
+    /**
+     * Returns the light's view rotation shared by the cascades
+     */
+    static QMatrix4x4 getLightView(const QVector3D& lightDir);
+
+    /**
+     * Returns the viewport of a cascade's tile in the atlas as x, y, width and height
+     */
+    static void getTileViewport(int cascade, const ShadowSettings& settings, int viewport[4]);
+
+    /**
+     * Returns the number of tiles along each side of the atlas
+     */
+    static int getGridSize(int cascadeCount)
+    {
+        return cascadeCount > 1 ? 2 : 1;
+    }
+};
+
+}
+
+#endif // SHADOWCASCADES_H
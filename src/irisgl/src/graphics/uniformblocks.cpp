@@ -0,0 +1,48 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "uniformblocks.h"
+#include <QOpenGLFunctions_3_2_Core>
+
+namespace iris
+{
+
+UniformBuffer::UniformBuffer(QOpenGLFunctions_3_2_Core* gl, UniformBlockBinding binding, int size)
+{
+    this->gl = gl;
+    this->binding = (GLuint)binding;
+    this->size = size;
+
+    gl->glGenBuffers(1, &bufferId);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, bufferId);
+    gl->glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    gl->glDeleteBuffers(1, &bufferId);
+}
+
+void UniformBuffer::update(const void* data)
+{
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, bufferId);
+    gl->glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    gl->glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::bind()
+{
+    gl->glBindBufferBase(GL_UNIFORM_BUFFER, binding, bufferId);
+}
+
+}
@@ -0,0 +1,141 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef UNIFORMBLOCKS_H
+#define UNIFORMBLOCKS_H
+
+#include <qopengl.h>
+#include "shader.h"
+#include "shadowcascades.h"
+
+class QOpenGLFunctions_3_2_Core;
+
+namespace iris
+{
+
+/**
+ * Binding points of the engine's uniform blocks.
+ * Programs created by GraphicsHelper::loadShader have their blocks assigned to these.
+ */
+enum class UniformBlockBinding : GLuint
+{
+    FrameData = 0,
+    LightData = 1
+};
+
+/**
+ * Mirror of the FrameData block in uniform_blocks.glsl using std140 rules.
+ * Matrices are column major like QMatrix4x4::constData()
+ */
+struct FrameDataBlock
+{
+    GLfloat viewMatrix[16];
+    GLfloat projMatrix[16];
+    // the last cascade's atlas matrix, for shaders that dont use the cascades
+    GLfloat lightSpaceMatrix[16];
+
+    // a vec3 followed by a float shares a 16 byte slot
+    GLfloat eyePos[3];
+    GLfloat fogStart;
+    GLfloat fogColor[4];
+    GLfloat fogEnd;
+
+    GLfloat padding[3];
+
+    GLfloat shadowMatrices[SHADER_MAX_SHADOW_CASCADES][16];
+    GLfloat shadowTiles[SHADER_MAX_SHADOW_CASCADES][4];
+    GLfloat shadowSplits[4];
+    GLint shadowCascadeCount;
+
+    GLfloat clusterDepthScale;
+    GLfloat clusterDepthBias;
+
+    GLint clusterPadding;
+
+    // the matrices of each eye in single pass stereo, the same as viewMatrix and projMatrix otherwise
+    GLfloat eyeViewMatrices[2][16];
+    GLfloat eyeProjMatrices[2][16];
+
+    // the view the light clusters were binned for and the cascades were split along.
+    // viewMatrix and projMatrix are replaced by an eye's for programs drawn once per eye in stereo,
+    // these stay the view of both eyes
+    GLfloat sharedViewMatrix[16];
+    GLfloat sharedProjMatrix[16];
+};
+
+/**
+ * Mirror of the Light struct in uniform_blocks.glsl.
+ * Only directional lights are kept in the block, the others are in the LightClusters.
+ * Array elements are padded to 16 bytes in std140.
+ */
+struct LightBlockEntry
+{
+    GLfloat color[4];
+    GLfloat position[3];
+    GLint type;
+    GLfloat direction[3];
+    GLfloat distance;
+    GLfloat intensity;
+    GLfloat cutOffAngle;
+    GLfloat cutOffSoftness;
+
+    GLfloat padding;
+};
+
+struct LightDataBlock
+{
+    LightBlockEntry lights[SHADER_MAX_LIGHTS];
+    GLint lightCount;
+
+    GLint padding[3];
+};
+
+static_assert(sizeof(FrameDataBlock) == 240 + 64 * SHADER_MAX_SHADOW_CASCADES + 16 * SHADER_MAX_SHADOW_CASCADES + 32 + 256 + 128, "FrameDataBlock doesnt match the std140 layout");
+static_assert(sizeof(LightBlockEntry) == 64, "LightBlockEntry doesnt match the std140 layout");
+static_assert(sizeof(LightDataBlock) == 64 * SHADER_MAX_LIGHTS + 16, "LightDataBlock doesnt match the std140 layout");
+
+/**
+ * A gl uniform buffer attached to a fixed binding point
+ */
+class UniformBuffer
+{
+public:
+    UniformBuffer(QOpenGLFunctions_3_2_Core* gl, UniformBlockBinding binding, int size);
+    ~UniformBuffer();
+
+    /**
+     * Replaces the buffer's contents. The old storage is orphaned first so
+     * updating the buffer more than once per frame (once per eye in vr) doesnt
+     * wait on draws that still read the previous data.
+     * @param data must be at least size bytes
+     */
+    void update(const void* data);
+
+    /**
+     * Attaches the buffer to its binding point
+     */
+    void bind();
+
+    GLuint getBufferId() const
+    {
+        return bufferId;
+    }
+
+private:
+    QOpenGLFunctions_3_2_Core* gl;
+    GLuint bufferId;
+    GLuint binding;
+    int size;
+};
+
+}
+
+#endif // UNIFORMBLOCKS_H
@@ -22,9 +22,9 @@ VertexLayout::VertexLayout()
     stride = 0;
 }
 
-void VertexLayout::addAttrib(VertexAttribUsage usage,int type,int count,int sizeInBytes)
+void VertexLayout::addAttrib(VertexAttribUsage usage,int type,int count,int sizeInBytes,bool normalized)
 {
-    VertexAttribute attrib = {usage, type, count, sizeInBytes};
+    VertexAttribute attrib = {usage, type, count, sizeInBytes, normalized};
     attribs.append(attrib);
 
     stride += sizeInBytes;
@@ -35,7 +35,8 @@ void VertexLayout::bind()
     int offset = 0;
     for(auto attrib: attribs)
     {
-        gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, attrib.type, GL_FALSE, stride, (GLvoid*)offset);
+        gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, attrib.type,
+                                  attrib.normalized ? GL_TRUE : GL_FALSE, stride, (GLvoid*)offset);
         gl->glEnableVertexAttribArray((int)attrib.usage);
         offset += attrib.sizeInBytes;
     }
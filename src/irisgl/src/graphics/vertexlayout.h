@@ -29,6 +29,8 @@ struct VertexAttribute
     int type;//GL_FLOAT,GL_INT, etc
     int count;//2 for vec2, 3 for vec3, etc
     int sizeInBytes;
+    // integer types are mapped to -1..1 or 0..1 instead of being converted as is
+    bool normalized;
 };
 
 class VertexLayout
@@ -40,7 +42,17 @@ class VertexLayout
 public:
     VertexLayout();
 
-    void addAttrib(VertexAttribUsage usage, int type, int count, int sizeInBytes);
+    void addAttrib(VertexAttribUsage usage, int type, int count, int sizeInBytes, bool normalized = false);
+
+    const QList<VertexAttribute>& getAttribs() const
+    {
+        return attribs;
+    }
+
+    int getStride() const
+    {
+        return stride;
+    }
 
     //todo: make this more efficient
     void bind();
@@ -50,27 +50,60 @@ void CustomMaterial::setValue(const QString &name, const QVariant &value)
 }
 
 void CustomMaterial::setUniformValues(Property *prop)
+{
+    setUniformValues(prop, getPropertyLocation(prop));
+}
+
+void CustomMaterial::setUniformValues(Property *prop, const PropertyLocation &location)
 {
     if (prop->type == PropertyType::Bool) {
-        program->setUniformValue(prop->uniform.toStdString().c_str(), prop->getValue().toBool());
+        program->setUniformValue(location.uniform, prop->getValue().toBool());
     }
 
     if (prop->type == PropertyType::Float) {
-        program->setUniformValue(prop->uniform.toStdString().c_str(), prop->getValue().toFloat());
+        program->setUniformValue(location.uniform, prop->getValue().toFloat());
     }
 
     // TODO, figure out a way for the default material to mix values... the ambient for one
     if (prop->type == PropertyType::Color) {
-        program->setUniformValue(prop->uniform.toStdString().c_str(),
-                                 QVector3D(prop->getValue().value<QColor>().redF(),
-                                           prop->getValue().value<QColor>().greenF(),
-                                           prop->getValue().value<QColor>().blueF()));
+        auto color = prop->getValue().value<QColor>();
+        program->setUniformValue(location.uniform,
+                                 QVector3D(color.redF(), color.greenF(), color.blueF()));
     }
 
     if (prop->type == iris::PropertyType::Texture) {
         auto tprop = static_cast<TextureProperty*>(prop);
-        program->setUniformValue(tprop->toggleValue.toStdString().c_str(), tprop->toggle);
+        program->setUniformValue(location.toggle, tprop->toggle);
+    }
+}
+
+void CustomMaterial::resolvePropertyLocations()
+{
+    if (propertyLocationsShaderId == shader->shaderId &&
+        propertyLocations.size() == properties.size())
+        return;
+
+    propertyLocations.resize(properties.size());
+
+    for (int i = 0; i < properties.size(); i++) {
+        propertyLocations[i] = getPropertyLocation(properties[i]);
     }
+
+    propertyLocationsShaderId = shader->shaderId;
+}
+
+CustomMaterial::PropertyLocation CustomMaterial::getPropertyLocation(Property *prop)
+{
+    PropertyLocation location;
+    location.uniform = shader->getUniformLocation(prop->uniform);
+    location.toggle = -1;
+
+    if (prop->type == PropertyType::Texture) {
+        auto tprop = static_cast<TextureProperty*>(prop);
+        location.toggle = shader->getUniformLocation(tprop->toggleValue);
+    }
+
+    return location;
 }
 
 QString CustomMaterial::firstTextureSlot() const
@@ -97,8 +130,10 @@ void CustomMaterial::begin(QOpenGLFunctions_3_2_Core *gl, ScenePtr scene)
 {
     Material::begin(gl, scene);
 
-    for (auto prop : this->properties) {
-        setUniformValues(prop);
+    resolvePropertyLocations();
+
+    for (int i = 0; i < properties.size(); i++) {
+        setUniformValues(properties[i], propertyLocations[i]);
     }
 }
 
@@ -203,6 +238,7 @@ void CustomMaterial::generate(const QString &fileName, bool project)
 void CustomMaterial::purge()
 {
     this->properties.clear();
+    propertyLocations.clear();
 }
 
 void CustomMaterial::setName(const QString &name)
@@ -273,6 +309,7 @@ CustomMaterialPtr CustomMaterial::create()
 void CustomMaterial::setProperties(QList<Property*> props)
 {
     this->properties = props;
+    propertyLocations.clear();
 }
 
 }
@@ -15,6 +15,7 @@ For more information see the LICENSE file
 #include "../graphics/material.h"
 #include "../irisglfwd.h"
 #include "propertytype.h"
+#include <QVector>
 
 class QOpenGLFunctions_3_2_Core;
 
@@ -48,6 +49,26 @@ private:
     CustomMaterial() = default;
     QString materialName;
 
+    // uniform locations of a property, -1 if the program doesnt use it
+    struct PropertyLocation
+    {
+        int uniform;
+        int toggle;
+    };
+
+    // locations of each property, in the same order as properties
+    QVector<PropertyLocation> propertyLocations;
+    // the shader propertyLocations were resolved from
+    long propertyLocationsShaderId = -1;
+
+    /**
+     * Looks up the locations of the properties' uniforms if the properties
+     * or the shader changed since the last time they were resolved
+     */
+    void resolvePropertyLocations();
+    PropertyLocation getPropertyLocation(Property*);
+    void setUniformValues(Property*, const PropertyLocation&);
+
     QJsonObject loadShaderFromDisk(const QString &);
 };
 
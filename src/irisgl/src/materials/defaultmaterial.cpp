@@ -35,12 +35,26 @@ DefaultMaterial::DefaultMaterial()
     this->createProgramFromShaderSource(":assets/shaders/default_material.vert",
                                         ":assets/shaders/default_material.frag");
 
+    locations.diffuse               = shader->getUniformLocation("u_material.diffuse");
+    locations.ambient               = shader->getUniformLocation("u_material.ambient");
+    locations.specular              = shader->getUniformLocation("u_material.specular");
+    locations.shininess             = shader->getUniformLocation("u_material.shininess");
+
+    locations.textureScale          = shader->getUniformLocation("u_textureScale");
+    locations.normalIntensity       = shader->getUniformLocation("u_normalIntensity");
+    locations.reflectionInfluence   = shader->getUniformLocation("u_reflectionInfluence");
+
+    locations.useDiffuseTex         = shader->getUniformLocation("u_useDiffuseTex");
+    locations.useNormalTex          = shader->getUniformLocation("u_useNormalTex");
+    locations.useSpecularTex        = shader->getUniformLocation("u_useSpecularTex");
+    locations.useReflectionTex      = shader->getUniformLocation("u_useReflectionTex");
+
     program->bind();
-    program->setUniformValue("u_useDiffuseTex",false);
-    program->setUniformValue("u_useNormalTex",false);
-    program->setUniformValue("u_useReflectionTex",false);
-    program->setUniformValue("u_useSpecularTex",false);
-    program->setUniformValue("u_material.diffuse",QVector3D(1,0,0));
+    program->setUniformValue(locations.useDiffuseTex,false);
+    program->setUniformValue(locations.useNormalTex,false);
+    program->setUniformValue(locations.useReflectionTex,false);
+    program->setUniformValue(locations.useSpecularTex,false);
+    program->setUniformValue(locations.diffuse,QVector3D(1,0,0));
 
     textureScale = 1.0f;
     ambientColor = QColor(0,0,0);
@@ -68,25 +82,25 @@ void DefaultMaterial::begin(QOpenGLFunctions_3_2_Core* gl,ScenePtr scene)
     bindTextures(gl);
 
     //set params
-    program->setUniformValue("u_material.diffuse",QVector3D(diffuseColor.redF(),diffuseColor.greenF(),diffuseColor.blueF()));
+    program->setUniformValue(locations.diffuse,QVector3D(diffuseColor.redF(),diffuseColor.greenF(),diffuseColor.blueF()));
 
     const QColor& sceneAmbient = scene->ambientColor;
     auto finalAmbient = QVector3D(ambientColor.redF() + sceneAmbient.redF(),
                                   ambientColor.greenF() + sceneAmbient.greenF(),
                                   ambientColor.blueF() + sceneAmbient.blueF());
-    program->setUniformValue("u_material.ambient",finalAmbient);
-    program->setUniformValue("u_material.specular",QVector3D(specularColor.redF(),specularColor.greenF(),specularColor.blueF()));
-    program->setUniformValue("u_material.shininess",shininess);
+    program->setUniformValue(locations.ambient,finalAmbient);
+    program->setUniformValue(locations.specular,QVector3D(specularColor.redF(),specularColor.greenF(),specularColor.blueF()));
+    program->setUniformValue(locations.shininess,shininess);
 
-    program->setUniformValue("u_textureScale", this->textureScale);
+    program->setUniformValue(locations.textureScale, this->textureScale);
 
-    program->setUniformValue("u_normalIntensity",normalIntensity);
-    program->setUniformValue("u_reflectionInfluence",reflectionInfluence);
+    program->setUniformValue(locations.normalIntensity,normalIntensity);
+    program->setUniformValue(locations.reflectionInfluence,reflectionInfluence);
 
-    program->setUniformValue("u_useDiffuseTex",useDiffuseTex);
-    program->setUniformValue("u_useNormalTex",useNormalTex);
-    program->setUniformValue("u_useSpecularTex",useSpecularTex);
-    program->setUniformValue("u_useReflectionTex",useReflectionTex);
+    program->setUniformValue(locations.useDiffuseTex,useDiffuseTex);
+    program->setUniformValue(locations.useNormalTex,useNormalTex);
+    program->setUniformValue(locations.useSpecularTex,useSpecularTex);
+    program->setUniformValue(locations.useReflectionTex,useReflectionTex);
 
 }
 
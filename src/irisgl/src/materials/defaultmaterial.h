@@ -96,6 +96,24 @@ public:
 
 private:
     DefaultMaterial();
+
+    // locations of the material's uniforms, resolved once the program is created
+    struct UniformLocations
+    {
+        int diffuse;
+        int ambient;
+        int specular;
+        int shininess;
+
+        int textureScale;
+        int normalIntensity;
+        int reflectionInfluence;
+
+        int useDiffuseTex;
+        int useNormalTex;
+        int useSpecularTex;
+        int useReflectionTex;
+    } locations;
 };
 
 }
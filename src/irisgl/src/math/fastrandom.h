@@ -0,0 +1,62 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef FASTRANDOM_H
+#define FASTRANDOM_H
+
+#include <QtGlobal>
+
+namespace iris
+{
+
+/**
+ * Small xorshift random number generator.
+ * Unlike rand() each instance has its own state, so it can be used from several
+ * threads at once and a given seed always gives the same sequence.
+ */
+class FastRandom
+{
+public:
+    FastRandom(quint32 seed = 1)
+    {
+        setSeed(seed);
+    }
+
+    void setSeed(quint32 seed)
+    {
+        // xorshift never leaves the zero state
+        state = seed != 0 ? seed : 0x9E3779B9u;
+    }
+
+    quint32 next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    /**
+     * Returns a float in the range [0, 1)
+     */
+    float nextFloat()
+    {
+        // the top 24 bits fit exactly in a float's mantissa
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    quint32 state;
+};
+
+}
+
+#endif // FASTRANDOM_H
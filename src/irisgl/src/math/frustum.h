@@ -0,0 +1,95 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <QMatrix4x4>
+#include <QVector4D>
+#include "../geometry/boundingbox.h"
+
+namespace iris
+{
+
+/**
+ * View volume defined by six planes. Points p inside the frustum satisfy
+ * dot(plane.xyz, p) + plane.w >= 0 for every plane.
+ */
+class Frustum
+{
+public:
+    enum PlaneIndex
+    {
+        Left = 0,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        PlaneCount
+    };
+
+    QVector4D planes[PlaneCount];
+
+    Frustum() {}
+
+    explicit Frustum(const QMatrix4x4& viewProjMatrix)
+    {
+        setFromMatrix(viewProjMatrix);
+    }
+
+    /**
+     * Extracts the planes from a combined projection * view matrix
+     * http://www.cs.otago.ac.nz/postgrads/alexis/planeExtraction.pdf
+     * @param viewProjMatrix
+     */
+    void setFromMatrix(const QMatrix4x4& viewProjMatrix)
+    {
+        auto row0 = viewProjMatrix.row(0);
+        auto row1 = viewProjMatrix.row(1);
+        auto row2 = viewProjMatrix.row(2);
+        auto row3 = viewProjMatrix.row(3);
+
+        planes[Left]    = row3 + row0;
+        planes[Right]   = row3 - row0;
+        planes[Bottom]  = row3 + row1;
+        planes[Top]     = row3 - row1;
+        planes[Near]    = row3 + row2;
+        planes[Far]     = row3 - row2;
+    }
+
+    /**
+     * Returns false if the box is completely outside of the frustum.
+     * Boxes near the corners of the frustum can be reported as intersecting
+     * even when they're outside, which is fine for culling.
+     * @param box
+     */
+    bool intersectsBox(const BoundingBox& box) const
+    {
+        for (int i = 0; i < PlaneCount; i++) {
+            const auto& plane = planes[i];
+
+            // corner of the box furthest along the plane's normal
+            float x = plane.x() >= 0 ? box.maxPos.x() : box.minPos.x();
+            float y = plane.y() >= 0 ? box.maxPos.y() : box.minPos.y();
+            float z = plane.z() >= 0 ? box.maxPos.z() : box.minPos.z();
+
+            if (plane.x() * x + plane.y() * y + plane.z() * z + plane.w() < 0)
+                return false;
+        }
+
+        return true;
+    }
+};
+
+}
+
+#endif // FRUSTUM_H
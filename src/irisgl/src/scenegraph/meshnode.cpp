@@ -15,6 +15,8 @@ For more information see the LICENSE file
 #include <QJsonValue>
 #include <QDir>
 
+#include <climits>
+
 #include "meshnode.h"
 #include "../graphics/mesh.h"
 #include "assimp/postprocess.h"
@@ -35,6 +37,7 @@ For more information see the LICENSE file
 #include "../core/scene.h"
 #include "../core/scenenode.h"
 #include "../core/irisutils.h"
+#include "../core/meshmanager.h"
 
 
 namespace iris
@@ -47,6 +50,10 @@ MeshNode::MeshNode() {
     renderItem = new RenderItem();
     renderItem->type = RenderItemType::Mesh;
 
+    spatialProxyId = -1;
+    spatialProxyTransformVersion = 0;
+    spatialProxyMesh = nullptr;
+
 //    materialType = 2;
 
 //    this->customMaterial = iris::CustomMaterial::create();
@@ -64,18 +71,25 @@ void MeshNode::setFaceCullingMode(const FaceCullingMode &value)
     faceCullingMode = value;
 }
 
+MeshNode::~MeshNode()
+{
+    MeshManager::release(mesh);
+}
+
 void MeshNode::setMesh(QString source)
 {
-    mesh = Mesh::loadMesh(source);
+    setMesh(MeshManager::getMesh(source, 0));
     meshPath = source;
     meshIndex = 0;
-
-    renderItem->mesh = mesh;
 }
 
 //should not be used on plain scene meshes
 void MeshNode::setMesh(Mesh* mesh)
 {
+    // retained first in case it's the mesh already set
+    MeshManager::retain(mesh);
+    MeshManager::release(this->mesh);
+
     this->mesh = mesh;
     renderItem->mesh = mesh;
 }
@@ -110,10 +124,26 @@ void MeshNode::setActiveMaterial(int type)
 //    }
 }
 
+void MeshNode::update(float dt)
+{
+    SceneNode::update(dt);
+
+    if (!!scene) {
+        scene->updateSpatialIndex(this);
+    }
+}
+
 void MeshNode::submitRenderItems()
 {
     renderItem->worldMatrix = this->globalTransform;
 
+    if (renderItem->transformVersion != getTransformVersion()) {
+        renderItem->transformVersion = getTransformVersion();
+        renderItem->framesUnchanged = 0;
+    } else if (renderItem->framesUnchanged < INT_MAX) {
+        renderItem->framesUnchanged++;
+    }
+
     if (!!material) {
         renderItem->renderLayer = material->renderLayer;
         //renderItem->faceCullingMode = faceCullingMode;
@@ -157,7 +187,7 @@ QSharedPointer<iris::SceneNode> _buildScene(const aiScene* scene,aiNode* node,QS
         // aside from that, iris currently only renders meshes
         if(mesh->HasPositions())
         {
-            meshNode->setMesh(new Mesh(mesh));
+            meshNode->setMesh(MeshManager::getMesh(filePath, node->mMeshes[0]));
             meshNode->name = QString(mesh->mName.C_Str());
             meshNode->meshPath = filePath;
             meshNode->meshIndex = node->mMeshes[0];
@@ -191,7 +221,7 @@ QSharedPointer<iris::SceneNode> _buildScene(const aiScene* scene,aiNode* node,QS
             meshNode->meshPath = filePath;
             meshNode->meshIndex = node->mMeshes[i];
 
-            meshNode->setMesh(new Mesh(mesh));
+            meshNode->setMesh(MeshManager::getMesh(filePath, node->mMeshes[i]));
             sceneNode->addChild(meshNode);
 
             //apply material
@@ -237,10 +267,14 @@ QSharedPointer<iris::SceneNode> MeshNode::loadAsSceneFragment(QString filePath)
     if (!scene) return QSharedPointer<iris::MeshNode>(nullptr);
     if (scene->mNumMeshes == 0) return QSharedPointer<iris::MeshNode>(nullptr);
 
+    // the hierarchy still needs the imported scene but the meshes are only
+    // uploaded the first time the file is loaded
+    MeshManager::addMeshes(filePath, scene);
+
     if (scene->mNumMeshes == 1) {
         auto mesh = scene->mMeshes[0];
         auto node = iris::MeshNode::create();
-        node->setMesh(new Mesh(scene->mMeshes[0]));
+        node->setMesh(MeshManager::getMesh(filePath, 0));
         node->meshPath = filePath;
         node->meshIndex = 0;
 
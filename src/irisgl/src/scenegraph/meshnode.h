@@ -42,6 +42,13 @@ public:
 
     RenderItem* renderItem;
 
+    // proxy of this node in the scene's spatial index, -1 if it isnt in the index
+    // the transform version and mesh the proxy's bounds were last calculated from are kept
+    // so the bounds are only updated when one of them changes
+    int spatialProxyId;
+    quint64 spatialProxyTransformVersion;
+    Mesh* spatialProxyMesh;
+
     static MeshNodePtr create() {
         return MeshNodePtr(new MeshNode());
     }
@@ -55,7 +62,16 @@ public:
      */
     static SceneNodePtr loadAsSceneFragment(QString path);
 
+    /**
+     * Sets the first mesh in source, shared with every other node using the same file
+     * @param source
+     */
     void setMesh(QString source);
+
+    /**
+     * Sets mesh. Meshes from the MeshManager are reference counted by the nodes using them.
+     * @param mesh
+     */
     void setMesh(Mesh* mesh);
 
     Mesh* getMesh();
@@ -80,8 +96,11 @@ public:
     }
 
     SceneNodePtr createDuplicate() override;
+    virtual void update(float dt) override;
     virtual void submitRenderItems() override;
 
+    ~MeshNode();
+
     FaceCullingMode getFaceCullingMode() const;
     void setFaceCullingMode(const FaceCullingMode &value);
 
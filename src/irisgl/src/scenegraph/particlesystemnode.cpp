@@ -23,11 +23,12 @@ For more information see the LICENSE file
 #include "../materials/defaultmaterial.h"
 #include "../materials/materialhelper.h"
 #include "../graphics/renderitem.h"
-#include "../graphics/particle.h"
 #include "../graphics/particlerender.h"
 
 #include "../core/scene.h"
 #include "../core/scenenode.h"
+#include "../core/meshmanager.h"
+#include "../core/jobsystem.h"
 
 namespace iris
 {
@@ -58,13 +59,21 @@ ParticleSystemNode::ParticleSystemNode() {
 
     speedError = lifeError = scaleError = 0;
 
+    maxParticles = 10000;
+    particles.setCapacity(maxParticles);
+
+    // seeded from the node so reloading a scene gives the same particles
+    random.setSeed((quint32)nodeId * 2654435761u + 1);
+
     renderer = new ParticleRenderer();
 
     renderItem = new RenderItem();
     renderItem->type = RenderItemType::ParticleSystem;
 
     boundsRenderItem = new RenderItem();
-    boundsRenderItem->mesh = Mesh::loadMesh(":assets/models/cube.obj");
+    // every particle system shares the cube
+    boundsRenderItem->mesh = MeshManager::getMesh(":assets/models/cube.obj");
+    MeshManager::retain(boundsRenderItem->mesh);
 
     auto mat = DefaultMaterial::create();
     mat->setDiffuseColor(QColor(255, 255, 255));
@@ -74,6 +83,8 @@ ParticleSystemNode::ParticleSystemNode() {
 
 ParticleSystemNode::~ParticleSystemNode()
 {
+    MeshManager::release(boundsRenderItem->mesh);
+
     delete renderItem;
     delete boundsRenderItem;
     delete renderer;
@@ -108,7 +119,7 @@ void ParticleSystemNode::generateParticles(float delta) {
         emitParticle();
     }
 
-    if (static_cast <float> (rand()) / static_cast <float> (RAND_MAX) < partialParticle) {
+    if (random.nextFloat() < partialParticle) {
         emitParticle();
     }
 }
@@ -126,33 +137,31 @@ void ParticleSystemNode::emitParticle() {
     float scl = generateValue(particleScale, scaleError);
     float ll = generateValue(lifeLength, lifeError);
 
-    // reuse particles! this is bad.
-    // change later after atlases
     boundDimension = QVector3D(1, 1, 1) * this->scale;
-    addParticle(new Particle(this->getGlobalPosition() + boundDimension * generateRandomUnitVector(),
-                             velocity,
-                             gravityComplement,
-                             ll,
-                             generateRotation(),
-                             scl));
+    particles.emit(this->getGlobalPosition() + boundDimension * generateRandomUnitVector(),
+                   velocity,
+                   gravityComplement,
+                   ll,
+                   generateRotation(),
+                   scl);
 }
 
 float ParticleSystemNode::generateValue(float average, float errorMargin) {
-    float offset = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) - 0.5f) * 2.f * errorMargin;
+    float offset = (random.nextFloat() - 0.5f) * 2.f * errorMargin;
     return average + offset;
 }
 
 float ParticleSystemNode::generateRotation() {
     if (randomRotation) {
-        return static_cast<float>(rand()) / static_cast<float>(RAND_MAX / 360.f);
+        return random.nextFloat() * 360.f;
     } else {
         return 0;
     }
 }
 
 QVector3D ParticleSystemNode::generateRandomUnitVector() {
-    float theta = (float) (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.f * M_PI);
-    float z = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.f) - 1.f;
+    float theta = (float) (random.nextFloat() * 2.f * M_PI);
+    float z = (random.nextFloat() * 2.f) - 1.f;
     float rootOneMinusZSquared = (float) sqrt(1 - z * z);
     float x = (float) (rootOneMinusZSquared * cos(theta));
     float y = (float) (rootOneMinusZSquared * sin(theta));
@@ -162,35 +171,56 @@ QVector3D ParticleSystemNode::generateRandomUnitVector() {
 void ParticleSystemNode::update(float delta) {
     SceneNode::update(delta);
 
-    generateParticles(delta);
-    std::list<Particle*>::iterator it = particles.begin();
-
-    while (it != particles.end()) {
-        auto p = (*it);
-
-        p->velocity += QVector3D(0, p->GRAVITY * p->gravityEffect * delta, 0);
-        //p.velocity.setY(p.velocity.y() + GRAVITY * gravityEffect * delta);
-        QVector3D change = p->velocity;
-        change *= delta;
-        p->position += change;
-        //p.position += p->velocity * delta;
-        p->elapsedTime += delta;
-
-        // in the future we can call behavior management here, add more forces such as wind
-        if (dissipate && p->elapsedTime > 0) {
-            if (dissipateInv) {
-                p->scale = MathHelper::lerp((p->elapsedTime / p->lifeLength), 0, particleScale);
-            } else {
-                p->scale *= 1.0f - (p->elapsedTime / p->lifeLength);
-            }
-        }
-
-        if (p->elapsedTime > p->lifeLength) {
-            it = particles.erase(it++);
-        }
-
-        ++it;
+    if (!!scene) {
+        scene->updatedParticleSystems.append(this);
+    } else {
+        simulateParticles({this}, delta);
+    }
+}
+
+void ParticleSystemNode::simulateParticles(const QVector<ParticleSystemNode*>& systems, float delta)
+{
+    // large systems are split so they can use more than one core
+    const int chunkSize = 16384;
+
+    struct Chunk
+    {
+        ParticleSystemNode* system;
+        int begin;
+        int end;
+    };
+
+    // emission only uses each system's own generator and transform
+    JobSystem::parallelFor(systems.size(), [&](int i) {
+        auto system = systems[i];
+        if (system->particles.getCapacity() != system->maxParticles)
+            system->particles.setCapacity(system->maxParticles);
+
+        system->generateParticles(delta);
+    });
+
+    QVector<Chunk> chunks;
+    for (auto system : systems) {
+        int count = system->particles.getCount();
+        for (int begin = 0; begin < count; begin += chunkSize)
+            chunks.append({system, begin, qMin(begin + chunkSize, count)});
     }
+
+    JobSystem::parallelFor(chunks.size(), [&](int i) {
+        const auto& chunk = chunks[i];
+        auto system = chunk.system;
+
+        auto dissipation = ParticleDissipation::None;
+        if (system->dissipate)
+            dissipation = system->dissipateInv ? ParticleDissipation::Grow : ParticleDissipation::Shrink;
+
+        system->particles.simulate(chunk.begin, chunk.end, delta, dissipation, system->particleScale);
+    });
+
+    // removal moves particles across chunks so it waits for the whole system
+    JobSystem::parallelFor(systems.size(), [&](int i) {
+        systems[i]->particles.removeDeadParticles();
+    });
 }
 
 void ParticleSystemNode::renderParticles(RenderData* renderData, QOpenGLShaderProgram* shader)
@@ -16,6 +16,8 @@ For more information see the LICENSE file
 #include "../core/scenenode.h"
 #include "../core/irisutils.h"
 #include "../graphics/texture2d.h"
+#include "../graphics/particlepool.h"
+#include "../math/fastrandom.h"
 
 class QOpenGLShaderProgram;
 
@@ -23,7 +25,6 @@ namespace iris
 {
 
 class RenderItem;
-class Particle;
 class ParticleRenderer;
 
 class ParticleSystemNode : public SceneNode
@@ -51,6 +52,7 @@ public:
     float lifeLength;
     float particleScale;
 
+    // capacity of the particle pool, particles emitted while it's full are dropped
     int maxParticles;
     float billboardScale;
 
@@ -154,12 +156,29 @@ public:
 
     void setBillboardScale(float scale);
 
+    /**
+     * Updates the node's transform and queues the system to be simulated by the scene
+     */
     void update(float delta) override;
 
+    /**
+     * Emits and moves the particles of systems on the job system.
+     * Large systems are split into chunks so a single system can use several cores.
+     */
+    static void simulateParticles(const QVector<ParticleSystemNode*>& systems, float delta);
+
+    /**
+     * Restarts the system's random sequence. Systems with the same seed and
+     * settings emit the same particles.
+     */
+    void setSeed(quint32 seed) {
+        random.setSeed(seed);
+    }
+
     void renderParticles(RenderData* renderData, QOpenGLShaderProgram* shader);
 
-    void addParticle(Particle *particle) {
-        particles.push_back(particle);
+    const ParticlePool& getParticles() const {
+        return particles;
     }
 
     ~ParticleSystemNode();
@@ -169,7 +188,9 @@ public:
 private:
     ParticleSystemNode();
 
-    std::list<Particle*> particles;
+    ParticlePool particles;
+    // each system has its own generator so systems can be simulated in parallel
+    FastRandom random;
 
     MaterialPtr material;
     RenderItem* renderItem;
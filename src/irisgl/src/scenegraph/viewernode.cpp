@@ -12,6 +12,7 @@ For more information see the LICENSE file
 #include "viewernode.h"
 #include "../core/scene.h"
 #include "../core/scenenode.h"
+#include "../core/meshmanager.h"
 #include "../graphics/mesh.h"
 #include "../materials/viewermaterial.h"
 #include "../materials/defaultmaterial.h"
@@ -26,7 +27,8 @@ namespace iris
 ViewerNode::ViewerNode()
 {
     this->sceneNodeType = SceneNodeType::Viewer;
-    this->headModel = Mesh::loadMesh(":/assets/models/head2.obj");
+    this->headModel = MeshManager::getMesh(":/assets/models/head2.obj");
+    MeshManager::retain(headModel);
     this->material = ViewerMaterial::create();
     this->material->setTexture(Texture2D::load(":/assets/models/head.png"));
 
@@ -37,7 +39,10 @@ ViewerNode::ViewerNode()
     renderItem->material = this->material;
     renderItem->mesh = headModel;
 
-    auto cube = Mesh::loadMesh(":/assets/models/cube.obj");
+    auto cube = MeshManager::getMesh(":/assets/models/cube.obj");
+    // used by both hands
+    MeshManager::retain(cube);
+    MeshManager::retain(cube);
 
     leftHandenderItem = new RenderItem();
     leftHandenderItem->type = RenderItemType::Mesh;
@@ -52,6 +57,10 @@ ViewerNode::ViewerNode()
 
 ViewerNode::~ViewerNode()
 {
+    MeshManager::release(headModel);
+    MeshManager::release(leftHandenderItem->mesh);
+    MeshManager::release(rightHandRenderItem->mesh);
+
     delete renderItem;
 }
 
@@ -0,0 +1,364 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "ovrdevice.h"
+#include <QOpenGLShaderProgram>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QOpenGLTexture>
+
+#include <QOpenGLContext>
+//#include "../libovr/Include/OVR_CAPI_GL.h"
+#include "../libovr/Include/Extras/OVR_Math.h"
+
+using namespace OVR;
+
+namespace iris
+{
+
+struct VrFrameData
+{
+    ovrEyeRenderDesc eyeRenderDesc[2];
+    ovrPosef eyeRenderPose[2];
+    ovrVector3f hmdToEyeOffset[2];
+    double sensorSampleTime;
+};
+
+OvrDevice::OvrDevice()
+{
+    frameData = new VrFrameData();
+
+    vr_stereoTextureChain = nullptr;
+    vr_stereoFbo = 0;
+    stereoFrame = false;
+}
+
+OvrDevice::~OvrDevice()
+{
+    delete frameData;
+}
+
+void OvrDevice::initialize()
+{
+    ovrResult result = ovr_Initialize(nullptr);
+    if (!OVR_SUCCESS(result)) {
+        //qDebug()<<"Failed to initialize libOVR.";
+        return;
+    }
+
+    result = ovr_Create(&session, &luid);
+    if (!OVR_SUCCESS(result)) {
+        qDebug() << "Could not create libOVR session!";
+        return;
+    }
+
+    hmdDesc = ovr_GetHmdDesc(session);
+
+    // intialize framebuffers necessary for rendering to the hmd
+    for (int eye = 0; eye < 2; ++eye) {
+        ovrSizei texSize = ovr_GetFovTextureSize(session,
+                                                 ovrEyeType(eye),
+                                                 hmdDesc.DefaultEyeFov[eye], 1);
+        createTextureChain(session, vr_textureChain[eye], texSize.w, texSize.h );
+        vr_depthTexture[eye] = createDepthTexture(texSize.w, texSize.h);
+
+        // should be the same for all
+        eyeWidth = texSize.w;
+        eyeHeight = texSize.h;
+    }
+    gl->glGenFramebuffers(2, vr_Fbo);
+
+    createMirrorFbo(800, 600);
+
+    setTrackingOrigin(VrTrackingOrigin::EyeLevel);
+
+    vrSupported = true;
+}
+
+void OvrDevice::setTrackingOrigin(VrTrackingOrigin trackingOrigin)
+{
+    this->trackingOrigin = trackingOrigin;
+
+    if(trackingOrigin == VrTrackingOrigin::FloorLevel)
+        ovr_SetTrackingOriginType(session, ovrTrackingOrigin_FloorLevel);
+    else
+        ovr_SetTrackingOriginType(session, ovrTrackingOrigin_EyeLevel);
+}
+
+ovrTextureSwapChain OvrDevice::createTextureChain(ovrSession session,
+                                                 ovrTextureSwapChain &swapChain,
+                                                 int width,
+                                                 int height)
+{
+    //ovrTextureSwapChain swapChain;
+
+    ovrTextureSwapChainDesc desc = {};
+    desc.Type = ovrTexture_2D;
+    desc.ArraySize = 1;
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+    desc.SampleCount = 1;
+    desc.StaticImage = ovrFalse;
+
+    ovrResult result = ovr_CreateTextureSwapChainGL(session, &desc, &swapChain);
+    if (!OVR_SUCCESS(result)) {
+        //qDebug()<<"could not create swap chain!";
+        return nullptr;
+    }
+
+    int length = 0;
+    ovr_GetTextureSwapChainLength(session, swapChain, &length);
+
+    for (int i = 0; i < length; ++i) {
+        GLuint chainTexId;
+        ovr_GetTextureSwapChainBufferGL(session, swapChain, i, &chainTexId);
+        gl->glBindTexture(GL_TEXTURE_2D, chainTexId);
+
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    return swapChain;
+}
+
+GLuint OvrDevice::createMirrorFbo(int width,int height)
+{
+    ovrMirrorTexture mirrorTexture = nullptr;
+
+    ovrMirrorTextureDesc desc;
+    memset(&desc, 0, sizeof(desc));
+    //todo: use actual viewport size
+    desc.Width = width;
+    desc.Height = height;
+    desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+    // Create mirror texture and an FBO used to copy mirror texture to back buffer
+    ovrResult result = ovr_CreateMirrorTextureGL(session, &desc, &mirrorTexture);
+    if (!OVR_SUCCESS(result))
+    {
+        qDebug()<< "Failed to create mirror texture.";
+        return 0;
+    }
+
+    // Configure the mirror read buffer
+    // no need to store this texture anywhere
+    ovr_GetMirrorTextureBufferGL(session, mirrorTexture, &vr_mirrorTexId);
+
+    gl->glGenFramebuffers(1, &vr_mirrorFbo);
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, vr_mirrorFbo);
+    gl->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, vr_mirrorTexId, 0);
+    gl->glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0);
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    return vr_mirrorFbo;
+}
+
+
+void OvrDevice::beginFrame()
+{
+    frameData->eyeRenderDesc[0] = ovr_GetRenderDesc(session, ovrEye_Left, hmdDesc.DefaultEyeFov[0]);
+    frameData->eyeRenderDesc[1] = ovr_GetRenderDesc(session, ovrEye_Right, hmdDesc.DefaultEyeFov[1]);
+
+    frameData->hmdToEyeOffset[0] = frameData->eyeRenderDesc[0].HmdToEyeOffset;
+    frameData->hmdToEyeOffset[1] = frameData->eyeRenderDesc[1].HmdToEyeOffset;
+
+    ovr_GetEyePoses(session, frameIndex, ovrTrue, frameData->hmdToEyeOffset, frameData->eyeRenderPose, &frameData->sensorSampleTime);
+
+    double timing = ovr_GetPredictedDisplayTime(session, 0);
+    hmdState = ovr_GetTrackingState(session, timing, ovrTrue);
+
+    auto toVector = [](const ovrVector3f& v) {
+        return QVector3D(v.x, v.y, v.z);
+    };
+    auto toQuaternion = [](const ovrQuatf& q) {
+        return QQuaternion(q.w, q.x, q.y, q.z);
+    };
+
+    for (int eye = 0; eye < 2; eye++) {
+        eyePositions[eye] = toVector(frameData->eyeRenderPose[eye].Position);
+        eyeRotations[eye] = toQuaternion(frameData->eyeRenderPose[eye].Orientation);
+    }
+
+    headPosition = toVector(hmdState.HeadPose.ThePose.Position);
+    headRotation = toQuaternion(hmdState.HeadPose.ThePose.Orientation);
+
+    auto contTypes = ovr_GetConnectedControllerTypes(session);
+
+    for (int i=0; i<2; i++) {
+        handPositions[i] = toVector(hmdState.HandPoses[i].ThePose.Position);
+        handRotations[i] = toQuaternion(hmdState.HandPoses[i].ThePose.Orientation);
+
+        auto controllerType = i == 0? ovrControllerType_LTouch : ovrControllerType_RTouch;
+        ovrInputState ovrState;
+        VrInputState state;
+        if( OVR_SUCCESS(ovr_GetInputState(session, controllerType, &ovrState))) {
+            state.buttons = ovrState.Buttons;
+            state.indexTrigger = ovrState.IndexTrigger[i];
+            state.handTrigger = ovrState.HandTrigger[i];
+            state.thumbstick = QVector2D(ovrState.Thumbstick[i].x, ovrState.Thumbstick[i].y);
+        } else {
+            // @todo: log error
+        }
+
+        //touchControllers[i]->isBeingTracked = (hmdState.HandStatusFlags[i] & ovrStatus_PositionTracked) == ovrStatus_PositionTracked;
+        //touchControllers[i]->isBeingTracked = (hmdState.HandStatusFlags[i] & ovrStatus_OrientationTracked);
+        setTouchInput(i, state, (contTypes & controllerType) != 0);
+    }
+}
+
+void OvrDevice::endFrame()
+{
+    ovrLayerEyeFov ld;
+    ld.Header.Type  = ovrLayerType_EyeFov;
+    ld.Header.Flags = ovrLayerFlag_TextureOriginAtBottomLeft;
+
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        if (stereoFrame) {
+            // both eyes are halves of the same texture
+            ld.ColorTexture[eye] = vr_stereoTextureChain;
+            ld.Viewport[eye]     = Recti(Vector2i(eye * eyeWidth, 0), Sizei(eyeWidth,eyeHeight));
+        } else {
+            ld.ColorTexture[eye] = vr_textureChain[eye];
+            ld.Viewport[eye]     = Recti(Sizei(eyeWidth,eyeHeight));
+        }
+        ld.Fov[eye]          = hmdDesc.DefaultEyeFov[eye];
+        ld.RenderPose[eye]   = frameData->eyeRenderPose[eye];
+        ld.SensorSampleTime  = frameData->sensorSampleTime;
+    }
+
+    ovrLayerHeader* layers = &ld.Header;
+    ovrResult result = ovr_SubmitFrame(session, frameIndex, nullptr, &layers, 1);
+
+    if (!OVR_SUCCESS(result))
+    {
+        qDebug()<<"error submitting frame"<<endl;
+    }
+
+    frameIndex++;
+    stereoFrame = false;
+}
+
+void OvrDevice::beginEye(int eye)
+{
+    GLuint curTexId;
+    int curIndex;
+
+    ovr_GetTextureSwapChainCurrentIndex(session, vr_textureChain[eye], &curIndex);
+    ovr_GetTextureSwapChainBufferGL(session, vr_textureChain[eye], curIndex, &curTexId);
+
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, vr_Fbo[eye]);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D,
+                               curTexId,
+                               0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_2D,
+                               vr_depthTexture[eye],
+                               0);
+
+    gl->glViewport(0, 0, eyeWidth, eyeHeight);
+    gl->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gl->glEnable(GL_FRAMEBUFFER_SRGB);
+}
+
+void OvrDevice::endEye(int eye)
+{
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+
+    ovr_CommitTextureSwapChain(session, vr_textureChain[eye]);
+}
+
+void OvrDevice::beginStereo()
+{
+    if (vr_stereoFbo == 0) {
+        createTextureChain(session, vr_stereoTextureChain, eyeWidth * 2, eyeHeight);
+        vr_stereoDepthTexture = createDepthTexture(eyeWidth * 2, eyeHeight);
+        gl->glGenFramebuffers(1, &vr_stereoFbo);
+    }
+
+    GLuint curTexId;
+    int curIndex;
+
+    ovr_GetTextureSwapChainCurrentIndex(session, vr_stereoTextureChain, &curIndex);
+    ovr_GetTextureSwapChainBufferGL(session, vr_stereoTextureChain, curIndex, &curTexId);
+
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, vr_stereoFbo);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D,
+                               curTexId,
+                               0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_2D,
+                               vr_stereoDepthTexture,
+                               0);
+
+    gl->glViewport(0, 0, eyeWidth * 2, eyeHeight);
+    gl->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gl->glEnable(GL_FRAMEBUFFER_SRGB);
+}
+
+void OvrDevice::endStereo()
+{
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+
+    ovr_CommitTextureSwapChain(session, vr_stereoTextureChain);
+    stereoFrame = true;
+}
+
+bool OvrDevice::isHeadMounted()
+{
+    // there's no session without a runtime
+    if (!vrSupported)
+        return false;
+
+    ovrSessionStatus sessionStatus;
+
+    ovr_GetSessionStatus(session, &sessionStatus);
+    //qDebug() <<"tracking state: "<< sessionStatus;
+    return sessionStatus.HmdMounted;
+}
+
+QMatrix4x4 OvrDevice::getEyeProjMatrix(int eye,float nearClip,float farClip)
+{
+    QMatrix4x4 proj;
+    proj.setToIdentity();//not needed
+    Matrix4f eyeProj = ovrMatrix4f_Projection(hmdDesc.DefaultEyeFov[eye],
+                                              nearClip,
+                                              farClip,
+                                              ovrProjection_None);
+
+    //todo: put in
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0;c < 4; c++) {
+            proj(r, c) = eyeProj.M[r][c];
+        }
+    }
+
+    return proj;
+}
+
+GLuint OvrDevice::bindMirrorTextureId()
+{
+    gl->glBindTexture(GL_TEXTURE_2D, vr_mirrorTexId);
+    return vr_mirrorTexId;
+}
+
+}
@@ -0,0 +1,81 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef OVRDEVICE_H
+#define OVRDEVICE_H
+
+#include "vrdevice.h"
+#include "../libovr/Include/OVR_CAPI_GL.h"
+
+namespace iris
+{
+
+struct VrFrameData;
+
+/**
+ * This class provides an interface for the OVR sdk
+ */
+class OvrDevice : public VrDevice
+{
+    friend class VrManager;
+    OvrDevice();
+public:
+    ~OvrDevice();
+
+    void initialize() override;
+    void setTrackingOrigin(VrTrackingOrigin trackingOrigin) override;
+
+    GLuint createMirrorFbo(int width,int height);
+
+    void beginFrame() override;
+    void endFrame() override;
+
+    void beginEye(int eye) override;
+    void endEye(int eye) override;
+
+    void beginStereo() override;
+    void endStereo() override;
+
+    bool isHeadMounted() override;
+
+    QMatrix4x4 getEyeProjMatrix(int eye,float nearClip,float farClip) override;
+
+    GLuint bindMirrorTextureId() override;
+
+private:
+    ovrTextureSwapChain createTextureChain(ovrSession session,ovrTextureSwapChain &swapChain,int width,int height);
+
+    GLuint vr_depthTexture[2];
+    ovrTextureSwapChain vr_textureChain[2];
+    GLuint vr_Fbo[2];
+
+    // side by side target of both eyes
+    GLuint vr_stereoDepthTexture;
+    ovrTextureSwapChain vr_stereoTextureChain;
+    GLuint vr_stereoFbo;
+    // whether the current frame was drawn to the stereo target
+    bool stereoFrame;
+
+    GLuint vr_mirrorFbo;
+    GLuint vr_mirrorTexId;
+
+    ovrSession session;
+    ovrGraphicsLuid luid;
+    ovrHmdDesc hmdDesc;
+
+    VrFrameData* frameData;
+
+    ovrTrackingState hmdState;
+};
+
+}
+
+#endif // OVRDEVICE_H
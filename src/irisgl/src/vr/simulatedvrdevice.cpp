@@ -0,0 +1,333 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "simulatedvrdevice.h"
+#include <QOpenGLFunctions_3_2_Core>
+#include <QThread>
+#include <QtMath>
+
+namespace iris
+{
+
+SimulatedVrDevice::SimulatedVrDevice(const SimulatedVrSettings& settings)
+{
+    this->settings = settings;
+    script = SimulatedVrDevice::defaultScript;
+
+    eyeWidth = settings.eyeWidth;
+    eyeHeight = settings.eyeHeight;
+
+    eyeDepthTextures[0] = eyeDepthTextures[1] = 0;
+    stereoDepthTexture = 0;
+    stereoFrame = false;
+    fbo = 0;
+    mirrorFbo = 0;
+    mirrorTexId = 0;
+
+    frameStart = 0;
+    lastFrameEnd = 0;
+    lastRefresh = 0;
+    resetStats();
+}
+
+SimulatedVrDevice::~SimulatedVrDevice()
+{
+    if (!vrSupported)
+        return;
+
+    for (int eye = 0; eye < 2; eye++) {
+        gl->glDeleteTextures(eyeChains[eye].textures.size(), eyeChains[eye].textures.data());
+        gl->glDeleteTextures(1, &eyeDepthTextures[eye]);
+    }
+
+    if (!stereoChain.textures.isEmpty()) {
+        gl->glDeleteTextures(stereoChain.textures.size(), stereoChain.textures.data());
+        gl->glDeleteTextures(1, &stereoDepthTexture);
+    }
+
+    gl->glDeleteTextures(1, &mirrorTexId);
+    gl->glDeleteFramebuffers(1, &fbo);
+    gl->glDeleteFramebuffers(1, &mirrorFbo);
+}
+
+void SimulatedVrDevice::setScript(const SimulatedVrScript& script)
+{
+    this->script = script;
+}
+
+void SimulatedVrDevice::defaultScript(double time, SimulatedVrState& state)
+{
+    auto wave = [time](double period, double phase = 0.0) {
+        return (float)qSin(time * 2.0 * M_PI / period + phase);
+    };
+
+    float yaw = 30.0f * wave(8.0);
+    float pitch = 10.0f * wave(5.0);
+    state.headRotation = QQuaternion::fromEulerAngles(pitch, yaw, 0);
+    state.headPosition = QVector3D(0.05f * wave(4.0), 0.02f * wave(3.0), 0);
+
+    // the hands follow the head's yaw but not its pitch, like arms held out
+    auto bodyRotation = QQuaternion::fromEulerAngles(0, yaw, 0);
+    for (int i = 0; i < 2; i++) {
+        float side = i == 0 ? -1.0f : 1.0f;
+        state.handPositions[i] = state.headPosition +
+                                 bodyRotation.rotatedVector(QVector3D(side * 0.2f, -0.3f, -0.4f));
+        state.handRotations[i] = bodyRotation * QQuaternion::fromEulerAngles(-30.0f, 0, 0);
+
+        state.input[i].thumbstick = QVector2D(wave(2.0, i * M_PI + M_PI_2), wave(2.0, i * M_PI)) * 0.5f;
+        state.input[i].indexTrigger = 0.5f + 0.5f * wave(1.0, i * M_PI);
+        state.input[i].handTrigger = 0.0f;
+        state.input[i].buttons = 0;
+        state.handTracked[i] = true;
+    }
+
+    state.headMounted = true;
+}
+
+void SimulatedVrDevice::initialize()
+{
+    // every renderer initializes the default device
+    if (vrSupported)
+        return;
+
+    for (int eye = 0; eye < 2; eye++) {
+        createSwapChain(eyeChains[eye], eyeWidth, eyeHeight);
+        eyeDepthTextures[eye] = createDepthTexture(eyeWidth, eyeHeight);
+    }
+    stereoChain.current = 0;
+    stereoChain.committed = -1;
+
+    gl->glGenFramebuffers(1, &fbo);
+
+    gl->glGenTextures(1, &mirrorTexId);
+    gl->glBindTexture(GL_TEXTURE_2D, mirrorTexId);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, settings.mirrorWidth, settings.mirrorHeight,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl->glGenFramebuffers(1, &mirrorFbo);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mirrorFbo);
+    gl->glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mirrorTexId, 0);
+    gl->glClear(GL_COLOR_BUFFER_BIT);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    setTrackingOrigin(VrTrackingOrigin::EyeLevel);
+
+    vrSupported = true;
+}
+
+void SimulatedVrDevice::setTrackingOrigin(VrTrackingOrigin trackingOrigin)
+{
+    this->trackingOrigin = trackingOrigin;
+}
+
+void SimulatedVrDevice::createSwapChain(SwapChain& chain, int width, int height)
+{
+    chain.textures.resize(qMax(settings.swapChainLength, 1));
+    chain.current = 0;
+    chain.committed = -1;
+
+    gl->glGenTextures(chain.textures.size(), chain.textures.data());
+    for (auto texId : chain.textures) {
+        gl->glBindTexture(GL_TEXTURE_2D, texId);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SimulatedVrDevice::bindSwapChain(SwapChain& chain, GLuint depthTexture, int width, int height)
+{
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D,
+                               chain.textures[chain.current],
+                               0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_2D,
+                               depthTexture,
+                               0);
+
+    gl->glViewport(0, 0, width, height);
+    gl->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gl->glEnable(GL_FRAMEBUFFER_SRGB);
+}
+
+void SimulatedVrDevice::commitSwapChain(SwapChain& chain)
+{
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+
+    chain.committed = chain.current;
+    chain.current = (chain.current + 1) % chain.textures.size();
+}
+
+void SimulatedVrDevice::mirror(SwapChain& chain, int srcX, int srcWidth, int dstX, int dstWidth)
+{
+    if (chain.committed < 0)
+        return;
+
+    gl->glFramebufferTexture2D(GL_READ_FRAMEBUFFER,
+                               GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D,
+                               chain.textures[chain.committed],
+                               0);
+    gl->glBlitFramebuffer(srcX, 0, srcX + srcWidth, eyeHeight,
+                          dstX, 0, dstX + dstWidth, settings.mirrorHeight,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    gl->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+}
+
+void SimulatedVrDevice::beginFrame()
+{
+    if (!clock.isValid())
+        clock.start();
+    frameStart = clock.nsecsElapsed();
+
+    // poses are predicted for when the frame is shown, which is a whole number
+    // of refreshes after the first frame
+    state = SimulatedVrState();
+    script(frameIndex / (double)settings.refreshRate, state);
+
+    QVector3D origin;
+    if (trackingOrigin == VrTrackingOrigin::FloorLevel)
+        origin = QVector3D(0, settings.standingHeight, 0);
+
+    headPosition = origin + state.headPosition;
+    headRotation = state.headRotation;
+
+    for (int eye = 0; eye < 2; eye++) {
+        float offset = eye == 0 ? -0.5f * settings.ipd : 0.5f * settings.ipd;
+        eyePositions[eye] = headPosition + headRotation.rotatedVector(QVector3D(offset, 0, 0));
+        eyeRotations[eye] = headRotation;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        handPositions[i] = origin + state.handPositions[i];
+        handRotations[i] = state.handRotations[i];
+        setTouchInput(i, state.input[i], state.handTracked[i]);
+    }
+}
+
+void SimulatedVrDevice::endFrame()
+{
+    // the compositor reads the eyes while showing them
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mirrorFbo);
+    int halfWidth = settings.mirrorWidth / 2;
+    if (stereoFrame) {
+        mirror(stereoChain, 0, eyeWidth, 0, halfWidth);
+        mirror(stereoChain, eyeWidth, eyeWidth, halfWidth, settings.mirrorWidth - halfWidth);
+    } else {
+        mirror(eyeChains[0], 0, eyeWidth, 0, halfWidth);
+        mirror(eyeChains[1], 0, eyeWidth, halfWidth, settings.mirrorWidth - halfWidth);
+    }
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (settings.waitForGpu)
+        gl->glFinish();
+
+    qint64 now = clock.nsecsElapsed();
+    stats.renderTime = (now - frameStart) / 1000;
+
+    // the frame is shown at the first refresh after it's submitted, frames
+    // submitted within the same refresh replace each other
+    qint64 interval = (qint64)(1e9 / settings.refreshRate);
+    qint64 refresh = (now / interval + 1) * interval;
+    if (stats.frameCount > 0)
+        stats.missedRefreshes += qMax<qint64>((refresh - lastRefresh) / interval - 1, 0);
+    lastRefresh = refresh;
+
+    if (settings.throttle) {
+        QThread::usleep((refresh - now) / 1000);
+        now = clock.nsecsElapsed();
+    }
+
+    stats.frameTime = stats.frameCount > 0 ? (now - lastFrameEnd) / 1000 : stats.renderTime;
+    stats.maxFrameTime = qMax(stats.maxFrameTime, stats.frameTime);
+    stats.totalTime = now / 1000;
+    stats.frameCount++;
+    lastFrameEnd = now;
+
+    frameIndex++;
+    stereoFrame = false;
+}
+
+void SimulatedVrDevice::resetStats()
+{
+    stats.frameCount = 0;
+    stats.missedRefreshes = 0;
+    stats.renderTime = 0;
+    stats.frameTime = 0;
+    stats.maxFrameTime = 0;
+    stats.totalTime = 0;
+}
+
+void SimulatedVrDevice::beginEye(int eye)
+{
+    bindSwapChain(eyeChains[eye], eyeDepthTextures[eye], eyeWidth, eyeHeight);
+}
+
+void SimulatedVrDevice::endEye(int eye)
+{
+    commitSwapChain(eyeChains[eye]);
+}
+
+void SimulatedVrDevice::beginStereo()
+{
+    if (stereoChain.textures.isEmpty()) {
+        createSwapChain(stereoChain, eyeWidth * 2, eyeHeight);
+        stereoDepthTexture = createDepthTexture(eyeWidth * 2, eyeHeight);
+    }
+
+    bindSwapChain(stereoChain, stereoDepthTexture, eyeWidth * 2, eyeHeight);
+}
+
+void SimulatedVrDevice::endStereo()
+{
+    commitSwapChain(stereoChain);
+    stereoFrame = true;
+}
+
+bool SimulatedVrDevice::isHeadMounted()
+{
+    return vrSupported && state.headMounted;
+}
+
+QMatrix4x4 SimulatedVrDevice::getEyeProjMatrix(int eye,float nearClip,float farClip)
+{
+    float left = eye == 0 ? settings.fovOuter : settings.fovInner;
+    float right = eye == 0 ? settings.fovInner : settings.fovOuter;
+
+    QMatrix4x4 proj;
+    proj.frustum(-left * nearClip, right * nearClip,
+                 -settings.fovDown * nearClip, settings.fovUp * nearClip,
+                 nearClip, farClip);
+
+    return proj;
+}
+
+GLuint SimulatedVrDevice::bindMirrorTextureId()
+{
+    gl->glBindTexture(GL_TEXTURE_2D, mirrorTexId);
+    return mirrorTexId;
+}
+
+}
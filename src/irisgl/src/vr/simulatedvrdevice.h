@@ -0,0 +1,212 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SIMULATEDVRDEVICE_H
+#define SIMULATEDVRDEVICE_H
+
+#include "vrdevice.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <functional>
+
+namespace iris
+{
+
+/**
+ * Pose and input of the simulated headset at one point in time, in tracking space
+ * with the origin at eye level
+ */
+struct SimulatedVrState
+{
+    QVector3D headPosition;
+    QQuaternion headRotation;
+
+    QVector3D handPositions[2];
+    QQuaternion handRotations[2];
+    VrInputState input[2];
+    bool handTracked[2];
+
+    bool headMounted;
+
+    SimulatedVrState()
+    {
+        handTracked[0] = handTracked[1] = true;
+        headMounted = true;
+    }
+};
+
+/**
+ * Fills in the state of the headset for a time in seconds since the first frame
+ */
+typedef std::function<void(double time, SimulatedVrState& state)> SimulatedVrScript;
+
+struct SimulatedVrSettings
+{
+    // size of each eye's target in pixels
+    int eyeWidth;
+    int eyeHeight;
+
+    // tangents of the half angles of the left eye's fov, the right eye's is mirrored
+    float fovUp;
+    float fovDown;
+    // towards the nose and away from it
+    float fovInner;
+    float fovOuter;
+
+    // distance between the eyes in meters
+    float ipd;
+    // height of the eyes above the floor for VrTrackingOrigin::FloorLevel
+    float standingHeight;
+
+    float refreshRate;
+    int swapChainLength;
+
+    // endFrame waits for the next refresh like a compositor does, otherwise frames
+    // run as fast as they can and missed refreshes are only counted
+    bool throttle;
+    // endFrame waits for the gpu to finish the frame, so frame times include it
+    bool waitForGpu;
+
+    // size of the texture the eyes are mirrored to
+    int mirrorWidth;
+    int mirrorHeight;
+
+    // rift cv1 defaults
+    SimulatedVrSettings()
+    {
+        eyeWidth = 1344;
+        eyeHeight = 1600;
+        fovUp = 1.3298f;
+        fovDown = 1.3298f;
+        fovInner = 1.0924f;
+        fovOuter = 1.0584f;
+        ipd = 0.064f;
+        standingHeight = 1.6f;
+        refreshRate = 90.0f;
+        swapChainLength = 3;
+        throttle = false;
+        waitForGpu = true;
+        mirrorWidth = 800;
+        mirrorHeight = 600;
+    }
+};
+
+struct SimulatedVrStats
+{
+    long long frameCount;
+    // refreshes that passed without a new frame, counted from the refresh after
+    // each endFrame
+    long long missedRefreshes;
+    // microseconds from beginFrame to endFrame of the last frame
+    qint64 renderTime;
+    // microseconds between the last two endFrames
+    qint64 frameTime;
+    qint64 maxFrameTime;
+    // microseconds since the first frame
+    qint64 totalTime;
+};
+
+/**
+ * A headset that doesnt need any hardware or runtime, for running and profiling
+ * the vr path on machines without one.
+ *
+ * Poses and controller input come from a script that's called with each frame's
+ * display time, frameIndex / refreshRate, so runs are repeatable whatever the
+ * frame rate is. The eyes are drawn to offscreen swap chains that are mirrored side
+ * by side in endFrame, and endFrame keeps the frame pacing stats a compositor would.
+ */
+class SimulatedVrDevice : public VrDevice
+{
+public:
+    SimulatedVrDevice(const SimulatedVrSettings& settings = SimulatedVrSettings());
+    ~SimulatedVrDevice();
+
+    /**
+     * Replaces the script the poses are read from, defaultScript is used otherwise
+     */
+    void setScript(const SimulatedVrScript& script);
+
+    /**
+     * Looks around slowly with both hands held out in front and the thumbsticks
+     * moving in circles. No buttons are pressed.
+     */
+    static void defaultScript(double time, SimulatedVrState& state);
+
+    void initialize() override;
+    void setTrackingOrigin(VrTrackingOrigin trackingOrigin) override;
+
+    void beginFrame() override;
+    void endFrame() override;
+
+    void beginEye(int eye) override;
+    void endEye(int eye) override;
+
+    void beginStereo() override;
+    void endStereo() override;
+
+    bool isHeadMounted() override;
+
+    QMatrix4x4 getEyeProjMatrix(int eye,float nearClip,float farClip) override;
+
+    GLuint bindMirrorTextureId() override;
+
+    const SimulatedVrSettings& getSettings() const
+    {
+        return settings;
+    }
+
+    const SimulatedVrStats& getStats() const
+    {
+        return stats;
+    }
+
+    void resetStats();
+
+private:
+    struct SwapChain
+    {
+        QVector<GLuint> textures;
+        int current;
+        // texture committed last, the one the mirror shows
+        int committed;
+    };
+
+    void createSwapChain(SwapChain& chain, int width, int height);
+    void bindSwapChain(SwapChain& chain, GLuint depthTexture, int width, int height);
+    void commitSwapChain(SwapChain& chain);
+    void mirror(SwapChain& chain, int srcX, int srcWidth, int dstX, int dstWidth);
+
+    SimulatedVrSettings settings;
+    SimulatedVrScript script;
+    SimulatedVrState state;
+    SimulatedVrStats stats;
+
+    SwapChain eyeChains[2];
+    GLuint eyeDepthTextures[2];
+    SwapChain stereoChain;
+    GLuint stereoDepthTexture;
+    // whether the current frame was drawn to the stereo target
+    bool stereoFrame;
+
+    GLuint fbo;
+    GLuint mirrorFbo;
+    GLuint mirrorTexId;
+
+    QElapsedTimer clock;
+    qint64 frameStart;
+    qint64 lastFrameEnd;
+    // refresh the last frame was shown at, in nanoseconds on the clock
+    qint64 lastRefresh;
+};
+
+}
+
+#endif // SIMULATEDVRDEVICE_H
@@ -12,9 +12,11 @@ For more information see the LICENSE file
 #ifndef VRDEVICE_H
 #define VRDEVICE_H
 
+#include <qopengl.h>
 #include <QMatrix4x4>
-#include <QOpenGLContext>
-#include "../libovr/Include/OVR_CAPI_GL.h"
+#include <QQuaternion>
+#include <QVector2D>
+#include <QVector3D>
 
 
 class QOpenGLFunctions_3_2_Core;
@@ -28,19 +30,20 @@ enum class VrTrackingOrigin
     FloorLevel
 };
 
+// same bits as ovrButton_ and ovrTouch_ in the oculus sdk
 enum class VrTouchInput : unsigned int
 {
-    A                   = ovrButton_A,
-    B                   = ovrButton_B,
-    RightThumb          = ovrButton_RThumb,
+    A                   = 0x00000001,
+    B                   = 0x00000002,
+    RightThumb          = 0x00000004,
     RightIndexTrigger   = 0x00000010,
-    RightShoulder       = ovrButton_RShoulder,
+    RightShoulder       = 0x00000008,
 
-    X                   = ovrButton_X,
-    Y                   = ovrButton_Y,
-    LeftThumb           = ovrButton_LThumb,
+    X                   = 0x00000100,
+    Y                   = 0x00000200,
+    LeftThumb           = 0x00000400,
     LeftIndexTrigger    = 0x00001000,
-    LeftShoulder        = ovrButton_LShoulder,
+    LeftShoulder        = 0x00000800,
 
     RightIndexPointing  = 0x00000020,
     RightThumbUp        = 0x00000040,
@@ -49,11 +52,30 @@ enum class VrTouchInput : unsigned int
     LeftThumbUp         = 0x00004000
 };
 
+/**
+ * Input of one touch controller for a frame
+ */
+struct VrInputState
+{
+    // VrTouchInput bits of the buttons held down
+    unsigned int buttons;
+    float indexTrigger;
+    float handTrigger;
+    QVector2D thumbstick;
+
+    VrInputState()
+    {
+        buttons = 0;
+        indexTrigger = 0;
+        handTrigger = 0;
+    }
+};
+
 class VrTouchController
 {
     friend class VrDevice;
-    ovrInputState inputState;
-    ovrInputState prevInputState;
+    VrInputState inputState;
+    VrInputState prevInputState;
 
     int index;
     bool isBeingTracked;
@@ -74,43 +96,65 @@ public:
     float getIndexTrigger();
     float getHandTrigger();
 private:
-    bool isButtonDown(const ovrInputState& state, VrTouchInput btn);
+    bool isButtonDown(const VrInputState& state, VrTouchInput btn);
     void setTrackingState(bool state);
 };
 
-struct VrFrameData;
-
 /**
- * This class provides an interface for the OVR sdk
+ * Interface of a headset and its touch controllers.
+ * OvrDevice drives an oculus headset through the OVR sdk and SimulatedVrDevice
+ * plays back scripted poses without one. VrManager picks the device the renderers use.
+ *
+ * Implementations fill in the poses and controller input in beginFrame,
+ * the base class turns them into view matrices.
  */
 class VrDevice
 {
-    friend class VrManager;
-    VrDevice();
 public:
-    void initialize();
-    void setTrackingOrigin(VrTrackingOrigin trackingOrigin);
+    virtual ~VrDevice();
 
-    GLuint createMirrorFbo(int width,int height);
+    virtual void initialize() = 0;
+    virtual void setTrackingOrigin(VrTrackingOrigin trackingOrigin) = 0;
 
     bool isVrSupported();
 
-    void beginFrame();
-    void endFrame();
+    virtual void beginFrame() = 0;
+    virtual void endFrame() = 0;
+
+    virtual void beginEye(int eye) = 0;
+    virtual void endEye(int eye) = 0;
+
+    /**
+     * Binds a target twice as wide as an eye, the left eye is drawn to its left half and
+     * the right eye to its right half. Used instead of beginEye and endEye to draw both
+     * eyes in one pass. The target is created the first time it's used.
+     */
+    virtual void beginStereo() = 0;
+    virtual void endStereo() = 0;
+
+    int getEyeWidth() const
+    {
+        return eyeWidth;
+    }
 
-    void beginEye(int eye);
-    void endEye(int eye);
+    int getEyeHeight() const
+    {
+        return eyeHeight;
+    }
 
     /*
      * Returns whether or not the headset is being tracked
      * If orientation is being track the the headset is on the persons head
      */
-    bool isHeadMounted();
+    virtual bool isHeadMounted() = 0;
 
     QMatrix4x4 getEyeViewMatrix(int eye,QVector3D pivot,QMatrix4x4 transform = QMatrix4x4());
-    QMatrix4x4 getEyeProjMatrix(int eye,float nearClip,float farClip);
+    virtual QMatrix4x4 getEyeProjMatrix(int eye,float nearClip,float farClip) = 0;
 
-    GLuint bindMirrorTextureId();
+    /**
+     * Binds the texture the last frame was mirrored to and returns its id
+     */
+    virtual GLuint bindMirrorTextureId() = 0;
 
     QVector3D getHandPosition(int handIndex);
     QQuaternion getHandRotation(int handIndex);
@@ -119,34 +163,32 @@ public:
     QQuaternion getHeadRotation();
     QVector3D getHeadPos();
 
-private:
+protected:
+    VrDevice();
+
     GLuint createDepthTexture(int width,int height);
-    ovrTextureSwapChain createTextureChain(ovrSession session,ovrTextureSwapChain &swapChain,int width,int height);
 
-    GLuint vr_depthTexture[2];
-    ovrTextureSwapChain vr_textureChain[2];
-    GLuint vr_Fbo[2];
+    // moves the controller's current input to its previous input
+    void setTouchInput(int index, const VrInputState& state, bool tracked);
+
+    QOpenGLFunctions_3_2_Core* gl;
 
     int eyeWidth;
     int eyeHeight;
     long long frameIndex;
 
-    GLuint vr_mirrorFbo;
-    GLuint vr_mirrorTexId;
-
     //quick bool to enable/disable vr rendering
     bool vrSupported;
 
-    ovrSession session;
-    ovrGraphicsLuid luid;
-    ovrHmdDesc hmdDesc;
-
     VrTrackingOrigin trackingOrigin;
 
-    QOpenGLFunctions_3_2_Core* gl;
-    VrFrameData* frameData;
-
-    ovrTrackingState hmdState;
+    // poses of the current frame in tracking space
+    QVector3D eyePositions[2];
+    QQuaternion eyeRotations[2];
+    QVector3D headPosition;
+    QQuaternion headRotation;
+    QVector3D handPositions[2];
+    QQuaternion handRotations[2];
 
     VrTouchController* touchControllers[2];
 };
@@ -11,18 +11,36 @@ For more information see the LICENSE file
 
 #include "vrmanager.h"
 #include "vrdevice.h"
+#include "ovrdevice.h"
+#include "simulatedvrdevice.h"
 
 namespace iris{
 
 VrDevice* VrManager::getDefaultDevice()
 {
-    if(device == nullptr)
-        device = new VrDevice();
+    if(device == nullptr) {
+        if (backend == VrBackend::Simulated || qgetenv("IRIS_VR_BACKEND") == "simulated")
+            device = new SimulatedVrDevice();
+        else
+            device = new OvrDevice();
+    }
 
     return device;
 }
 
+void VrManager::setBackend(VrBackend backend)
+{
+    VrManager::backend = backend;
+}
+
+void VrManager::setDefaultDevice(VrDevice* device)
+{
+    delete VrManager::device;
+    VrManager::device = device;
+}
+
 VrDevice* VrManager::device = nullptr;
+VrBackend VrManager::backend = VrBackend::Oculus;
 
 
 }
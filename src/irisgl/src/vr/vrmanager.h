@@ -15,11 +15,38 @@ For more information see the LICENSE file
 namespace iris{
 class VrDevice;
 
+enum class VrBackend
+{
+    // oculus runtime through the OVR sdk
+    Oculus,
+    // scripted headset for running vr without one, see SimulatedVrDevice
+    Simulated
+};
+
 class VrManager
 {
     static VrDevice* device;
+    static VrBackend backend;
 public:
+    /**
+     * Returns the device the renderers draw vr frames to, it's created on first use.
+     * The backend is Oculus unless setBackend was called or the IRIS_VR_BACKEND
+     * environment variable is "simulated".
+     */
     static VrDevice* getDefaultDevice();
+
+    /**
+     * Picks the backend the default device is created with. Has no effect once
+     * the device exists, so it should be called before any renderer is created.
+     */
+    static void setBackend(VrBackend backend);
+
+    /**
+     * Replaces the default device with one created by the caller, such as a
+     * SimulatedVrDevice with its own settings. The manager takes ownership and
+     * deletes the previous device, so no renderer may be using it anymore.
+     */
+    static void setDefaultDevice(VrDevice* device);
 };
 
 }
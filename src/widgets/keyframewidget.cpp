@@ -54,6 +54,9 @@ KeyFrameWidget::KeyFrameWidget(QWidget* parent):
     leftButtonDown = false;
     middleButtonDown = false;
     rightButtonDown = false;
+
+    selectedKeyFrame = nullptr;
+    selectedKeyIndex = -1;
 }
 
 void KeyFrameWidget::setSceneNode(iris::SceneNodePtr node)
@@ -129,9 +132,9 @@ void KeyFrameWidget::drawFrame(QPainter& paint,iris::FloatKeyFrame* keyFrame,int
     highlightPen.setCapStyle(Qt::RoundCap);
 
 
-    for(auto key:keyFrame->keys)
+    for(const auto& key:keyFrame->keys)
     {
-        int xpos = this->timeToPos(key->time);
+        int xpos = this->timeToPos(key.time);
 
         float distSqrd = distanceSquared(xpos,yTop+10,mousePos.x(),mousePos.y());
 
@@ -211,7 +214,7 @@ void KeyFrameWidget::mousePressEvent(QMouseEvent* evt)
 
     if(mousePos==clickPos && evt->button() == Qt::LeftButton)
     {
-        this->selectedKey = this->getSelectedKey(mousePos.x(),mousePos.y());
+        this->getSelectedKey(mousePos.x(),mousePos.y(),&selectedKeyFrame,&selectedKeyIndex);
     }
     else if(leftButtonDown)
     {
@@ -248,11 +251,13 @@ void KeyFrameWidget::mouseReleaseEvent(QMouseEvent* evt)
 
 void KeyFrameWidget::mouseMoveEvent(QMouseEvent* evt)
 {
-    if(leftButtonDown && selectedKey!=nullptr)
+    if(leftButtonDown && selectedKeyFrame!=nullptr)
     {
         //key dragging
+        //the key is moved so the frame's keys stay sorted, which can change its index
         auto timeDiff = posToTime(evt->x())-posToTime(mousePos.x());
-        selectedKey->time+=timeDiff;
+        auto time = selectedKeyFrame->keys[selectedKeyIndex].time + timeDiff;
+        selectedKeyIndex = selectedKeyFrame->setKeyTime(selectedKeyIndex,time);
     }
     else if(leftButtonDown)
     {
@@ -350,30 +355,35 @@ float KeyFrameWidget::distanceSquared(float x1,float y1,float x2,float y2)
     return dx*dx + dy*dy;
 }
 
-iris::FloatKey* KeyFrameWidget::getSelectedKey(int x,int y)
+bool KeyFrameWidget::getSelectedKey(int x,int y,iris::FloatKeyFrame** keyFrame,int* keyIndex)
 {
+    *keyFrame = nullptr;
+    *keyIndex = -1;
+
     if(!obj)
-        return nullptr;
+        return false;
 
     float penSizeSquared = 7*7;
 
     int frameHeight = 20;
     int ypos = -20;
-    for(auto keyFrame:obj->animation->keyFrameSet->keyFrames)
+    for(auto frame:obj->animation->keyFrameSet->keyFrames)
     {
         ypos+=frameHeight;
-        for(auto key:keyFrame->keys)
+        for(size_t i=0;i<frame->keys.size();i++)
         {
-            int xpos = this->timeToPos(key->time);
+            int xpos = this->timeToPos(frame->keys[i].time);
 
             float distSqrd = distanceSquared(xpos,ypos+10,x,y);
 
             if(distSqrd < penSizeSquared)
             {
-                return key;
+                *keyFrame = frame;
+                *keyIndex = i;
+                return true;
             }
         }
     }
 
-    return nullptr;
+    return false;
 }
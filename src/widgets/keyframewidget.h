@@ -64,7 +64,9 @@ private:
     QPoint mousePos;
     QPoint clickPos;
 
-    iris::FloatKey* selectedKey;
+    //keys are stored by value so the selected key is kept as its frame and index
+    iris::FloatKeyFrame* selectedKeyFrame;
+    int selectedKeyIndex;
 
     bool leftButtonDown;
     bool middleButtonDown;
@@ -111,7 +113,11 @@ private:
     float posToTime(int xpos);
     int timeToPos(float timeInSeconds);
 
-    iris::FloatKey* getSelectedKey(int x,int y);
+    /**
+     * Finds the key under the point x,y
+     * @return false if there's no key there
+     */
+    bool getSelectedKey(int x,int y,iris::FloatKeyFrame** keyFrame,int* keyIndex);
 };
 
 #endif // KEYFRAMEWIDGET_H
@@ -87,6 +87,7 @@ SceneViewWidget::SceneViewWidget(QWidget *parent) : QOpenGLWidget(parent)
     elapsedTimer = new QElapsedTimer();
     playScene = false;
     animTime = 0.0f;
+    animationBakeRate = 60.0f;
 
     sceneFloor = iris::IntersectionHelper::computePlaneND(QVector3D(100,  0,  100),
                                                           QVector3D(-100, 0,  100),
@@ -293,7 +294,7 @@ bool SceneViewWidget::doActiveObjectPicking(const QPointF &point)
     auto segEnd = segStart + rayDir;
 
     QList<PickingResult> hitList;
-    doScenePicking(scene->getRootNode(), segStart, segEnd, hitList);
+    doScenePicking(segStart, segEnd, hitList);
 
     if (hitList.size() == 0) return false;
 
@@ -420,7 +421,7 @@ void SceneViewWidget::doObjectPicking(const QPointF& point, bool skipLights)
     auto segEnd = segStart + rayDir;
 
     QList<PickingResult> hitList;
-    doScenePicking(scene->getRootNode(), segStart, segEnd, hitList);
+    doScenePicking(segStart, segEnd, hitList);
     if (!skipLights) {
         doLightPicking(segStart, segEnd, hitList);
     }
@@ -478,44 +479,19 @@ void SceneViewWidget::doGizmoPicking(const QPointF& point)
     viewportGizmo->onMousePress(editorCam->pos, this->calculateMouseRay(point) * 1024);
 }
 
-void SceneViewWidget::doScenePicking(const QSharedPointer<iris::SceneNode>& sceneNode,
-                                     const QVector3D& segStart,
+void SceneViewWidget::doScenePicking(const QVector3D& segStart,
                                      const QVector3D& segEnd,
                                      QList<PickingResult>& hitList)
 {
-    if ((sceneNode->getSceneNodeType() == iris::SceneNodeType::Mesh) &&
-         sceneNode->isPickable())
-    {
-        auto meshNode = sceneNode.staticCast<iris::MeshNode>();
-        auto mesh = meshNode->getMesh();
-        if(mesh != nullptr)
-        {
-            auto triMesh = meshNode->getMesh()->getTriMesh();
-
-            // transform segment to local space
-            auto invTransform = meshNode->globalTransform.inverted();
-            auto a = invTransform * segStart;
-            auto b = invTransform * segEnd;
-
-            QList<iris::TriangleIntersectionResult> results;
-            if (int resultCount = triMesh->getSegmentIntersections(a, b, results)) {
-                for (auto triResult : results) {
-                    // convert hit to world space
-                    auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
-
-                    PickingResult pick;
-                    pick.hitNode = sceneNode;
-                    pick.hitPoint = hitPoint;
-                    pick.distanceFromCameraSqrd = (hitPoint - editorCam->getGlobalPosition()).lengthSquared();
-
-                    hitList.append(pick);
-                }
-            }
-        }
-    }
+    // only the closest hit is ever used so there's no need to collect every hit
+    iris::PickingResult scenePick;
+    if (scene->rayCastClosest(segStart, segEnd, scenePick)) {
+        PickingResult pick;
+        pick.hitNode = scenePick.hitNode;
+        pick.hitPoint = scenePick.hitPoint;
+        pick.distanceFromCameraSqrd = (scenePick.hitPoint - editorCam->getGlobalPosition()).lengthSquared();
 
-    for (auto child : sceneNode->children) {
-        doScenePicking(child, segStart, segEnd, hitList);
+        hitList.append(pick);
     }
 }
 
@@ -692,15 +668,34 @@ void SceneViewWidget::startPlayingScene()
 {
     playScene = true;
     animTime = 0.0f;
+
+    // baked samples are blended during playback instead of evaluating every curve
+    if (animationBakeRate > 0)
+        scene->bakeAnimations(animationBakeRate);
 }
 
 void SceneViewWidget::stopPlayingScene()
 {
     playScene = false;
     animTime = 0.0f;
+
+    // scrubbing in the editor evaluates the curves directly
+    if (animationBakeRate > 0)
+        scene->bakeAnimations(0);
+
     scene->updateSceneAnimation(0.0f);
 }
 
+void SceneViewWidget::setAnimationBakeRate(float rate)
+{
+    animationBakeRate = rate;
+}
+
+const iris::AnimationStats& SceneViewWidget::getAnimationStats() const
+{
+    return scene->getAnimationStats();
+}
+
 iris::ForwardRendererPtr SceneViewWidget::getRenderer() const
 {
     return renderer;
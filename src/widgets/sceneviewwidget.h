@@ -26,6 +26,7 @@ For more information see the LICENSE file
 namespace iris
 {
     class Scene;
+    struct AnimationStats;
     class ForwardRenderer;
     class Mesh;
     class SceneNode;
@@ -116,6 +117,18 @@ public:
     void startPlayingScene();
     void stopPlayingScene();
 
+    /**
+     * Sets the samples per second animations are baked at when the scene is played.
+     * 0 plays the animation curves without baking them.
+     */
+    void setAnimationBakeRate(float rate);
+
+    /**
+     * Returns the size of the baked animations and how long animating a frame took,
+     * baked and from the curves.
+     */
+    const iris::AnimationStats& getAnimationStats() const;
+
     iris::ForwardRendererPtr getRenderer() const;
     void saveFrameBuffer(QString filePath);
 
@@ -156,8 +169,8 @@ private:
                         QList<PickingResult>& hitList);
 
     // @TODO: use one picking function and pick by mesh type
-    void doScenePicking(const iris::SceneNodePtr& sceneNode,
-                        const QVector3D& segStart,
+    // adds the closest mesh hit in the scene to hitList
+    void doScenePicking(const QVector3D& segStart,
                         const QVector3D& segEnd,
                         QList<PickingResult>& hitList);
 
@@ -193,6 +206,7 @@ private:
     bool playScene;
     iris::Plane sceneFloor;
     float animTime;
+    float animationBakeRate;
 
 signals:
     void initializeGraphics(SceneViewWidget* widget,